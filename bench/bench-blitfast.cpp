@@ -0,0 +1,313 @@
+/*
+ * Fast blitter kernel micro-benchmark
+ *
+ * Runs random blits through src/blit_fast.h and through what
+ * blitter_dofast()/blitter_dofast_desc() call in the real blitfunc.cpp
+ * (the blitfunc_dofast[] tables, and blitdofast_fill/blitdofast_desc_fill
+ * with USE_SHORT_BLITTABLE), each on its own copy of chip memory, with
+ * the minterms the kernels cover plus area fill: random sizes, masks,
+ * shifts, modulos (negative too), idle channels switched on, in-place
+ * C = D and A = D blits, and sources overlapping D. Chip memory and BLTBHOLD, BLTDDAT,
+ * the fill carry and the zero flag must match after every blit. Blits the
+ * kernels turn down go to the table on both copies, as blitter.cpp does.
+ * Then times some typical game blits both ways.
+ *
+ *   make -f Makefile.bench bench-blitfast bench-blitfast-short
+ *   ./bench-blitfast [blits]
+ *
+ * bench-blitfast-short is the same with USE_SHORT_BLITTABLE, the only
+ * build where fill blits really fill and the fill kernel is used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+#include "config.h"
+#include "uae.h"
+#include "options.h"
+#include "custom.h"
+#include "memory.h"
+#include "blitter.h"
+#include "blitfunc.h"
+
+/* blt_info.blitfill as blit_init() sets it */
+#ifndef USE_SHORT_BLITTABLE
+#define BLITFILL(con1) (((con1) & 0x18) ? 0x100 : 0)
+#else
+#define BLITFILL(con1) ((con1) & 0x18)
+#endif
+
+#define MEM_SIZE (512 * 1024)
+
+uae_u8 *chipmemory;
+uae_u32 allocated_chipmem;
+uae_u16 bltcon0;
+uae_u8 blit_filltable[256][4][2];
+#ifdef USE_BLIT_MASKTABLE
+uae_u32 blit_masktable[BLITTER_MAX_WORDS];
+#endif
+
+#include "blit_fast.h"
+
+static uae_u8 mem_table[MEM_SIZE], mem_fast[MEM_SIZE];
+
+static unsigned rnd_state = 0x2545f491;
+
+static unsigned rnd (void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* Same table as build_blitfilltable() */
+static void build_filltable (void)
+{
+    unsigned int d, fillmask;
+    int i;
+
+    for (d = 0; d < 256; d++) {
+	for (i = 0; i < 4; i++) {
+	    int fc = i & 1;
+	    uae_u8 data = d;
+	    for (fillmask = 1; fillmask != 0x100; fillmask <<= 1) {
+		uae_u16 tmp = data;
+		if (fc) {
+		    if (i & 2)
+			data |= fillmask;
+		    else
+			data ^= fillmask;
+		}
+		if (tmp & fillmask) fc = !fc;
+	    }
+	    blit_filltable[d][i][0] = data;
+	    blit_filltable[d][i][1] = fc;
+	}
+    }
+}
+
+/* Exactly what blitter_dofast()/blitter_dofast_desc() call: without
+   USE_SHORT_BLITTABLE the uae_u8 index drops the fill bit there */
+static void run_table (struct bltinfo *b, int desc)
+{
+#ifndef USE_SHORT_BLITTABLE
+    uae_u8 mt = (bltcon0 & 0xFF) | b->blitfill;
+#else
+    uae_u8 mt = bltcon0 & 0xFF;
+#endif
+
+#ifdef USE_BLIT_MASKTABLE
+    blit_masktable[0] = b->bltafwm;
+    blit_masktable[b->hblitsize - 1] &= b->bltalwm;
+#endif
+#ifdef USE_SHORT_BLITTABLE
+    if (b->blitfill) {
+	if (desc)
+	    blitdofast_desc_fill (b);
+	else
+	    blitdofast_fill (b);
+    } else
+#endif
+    if (desc)
+	(*blitfunc_dofast_desc[mt]) (b);
+    else
+	(*blitfunc_dofast[mt]) (b);
+#ifdef USE_BLIT_MASKTABLE
+    blit_masktable[0] = 0xFFFF;
+    blit_masktable[b->hblitsize - 1] = 0xFFFF;
+#endif
+}
+
+static int run_fast (struct bltinfo *b, int desc)
+{
+    if (blitfast_dofast (b, bltcon0 & 0xFF, desc, b->pta, b->ptb, b->ptc, b->ptd))
+	return 1;
+    run_table (b, desc);
+    return 0;
+}
+
+static uaecptr rnd_ptr (void)
+{
+    return (64 * 1024 + rnd () % (384 * 1024)) & ~1;
+}
+
+static void rnd_blit (struct bltinfo *b, int *desc)
+{
+    static const int minterms[] = { 0x00, 0xF0, 0xCC, 0xCA, 0xE2 };
+    int mt = minterms[rnd () % 5], shift = rnd () % 2 ? 0 : rnd () % 16;
+    int con1;
+
+    memset (b, 0, sizeof *b);
+    *desc = rnd () % 2;
+    b->hblitsize = 1 + rnd () % (rnd () % 4 ? 24 : 64);
+    b->vblitsize = 1 + rnd () % 48;
+    b->bltamod = 2 * (int)(rnd () % 64) - 40;
+    b->bltbmod = 2 * (int)(rnd () % 64) - 40;
+    b->bltcmod = 2 * (int)(rnd () % 64) - 40;
+    b->bltdmod = rnd () % 3 ? b->bltcmod : 2 * (int)(rnd () % 64) - 40;
+    b->bltafwm = rnd () % 3 ? 0xFFFF : rnd ();
+    b->bltalwm = rnd () % 3 ? 0xFFFF : rnd ();
+    b->blitashift = shift;
+    b->blitbshift = rnd () % 2 ? shift : rnd () % 16;
+    b->blitdownashift = 16 - b->blitashift;
+    b->blitdownbshift = 16 - b->blitbshift;
+    b->bltadat = rnd ();
+    b->bltbhold = rnd ();
+    b->bltddat = rnd ();
+    b->blitzero = 1;
+    b->pta = mt == 0xF0 || mt == 0xCA || mt == 0xE2 || rnd () % 4 == 0 ? rnd_ptr () : 0;
+    b->ptb = mt == 0xCC || mt == 0xCA || mt == 0xE2 || rnd () % 4 == 0 ? rnd_ptr () : 0;
+    b->ptc = mt == 0xCA || mt == 0xE2 || rnd () % 4 == 0 ? rnd_ptr () : 0;
+    b->ptd = rnd_ptr ();
+    switch (rnd () % 8) {
+    case 0: /* cookie-cut in place */
+	if (b->ptc) {
+	    b->ptd = b->ptc;
+	    b->bltdmod = b->bltcmod;
+	}
+	break;
+    case 1: /* area fill in place, or a plain copy with the fill bits clear */
+	mt = 0xF0;
+	*desc = 1;
+	con1 = (rnd () % 4) << 3;
+	b->blitfill = BLITFILL (con1);
+	b->blitfc = rnd () % 2;
+	b->blitife = con1 & 8;
+	b->pta = b->ptd;
+	b->bltamod = b->bltdmod;
+	b->ptb = b->ptc = 0;
+	break;
+    case 2: /* a source a few words off D: left to the table */
+	if (b->pta)
+	    b->pta = b->ptd + 2 * (int)(rnd () % 9) - 8;
+	break;
+    }
+    bltcon0 = mt;
+}
+
+static int same (struct bltinfo *x, struct bltinfo *y)
+{
+    return x->blitzero == y->blitzero && x->bltbhold == y->bltbhold
+	&& x->bltddat == y->bltddat && x->blitfc == y->blitfc
+	&& !memcmp (mem_table, mem_fast, MEM_SIZE);
+}
+
+static int check (int blits, int *taken)
+{
+    int n, desc, errors = 0;
+    struct bltinfo t, f;
+
+    for (n = 0; n < blits && errors < 10; n++) {
+	rnd_blit (&t, &desc);
+	f = t;
+	/* now and then a smaller chip memory, so some blits fall off the end */
+	allocated_chipmem = rnd () % 8 ? MEM_SIZE : 256 * 1024;
+	chipmemory = mem_table;
+	run_table (&t, desc);
+	chipmemory = mem_fast;
+	*taken += run_fast (&f, desc);
+	if (!same (&t, &f)) {
+	    printf ("mismatch: blit %d minterm %02x%s%s %dx%d shifts %d/%d\n", n, bltcon0 & 0xFF,
+		    desc ? " desc" : "", t.blitfill ? " fill" : "", t.hblitsize, t.vblitsize,
+		    t.blitashift, t.blitbshift);
+	    memcpy (mem_fast, mem_table, MEM_SIZE);
+	    errors++;
+	}
+    }
+    return errors;
+}
+
+static double time_blit (struct bltinfo *proto, int mt, int desc, int fast, int rounds)
+{
+    struct timespec t0, t1;
+    struct bltinfo b;
+    int r;
+
+    bltcon0 = mt;
+    chipmemory = mem_fast;
+    allocated_chipmem = MEM_SIZE;
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    for (r = 0; r < rounds; r++) {
+	b = *proto;
+	if (fast)
+	    run_fast (&b, desc);
+	else
+	    run_table (&b, desc);
+	__asm__ __volatile__ ("" : : "r" (chipmemory) : "memory");
+    }
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / rounds;
+}
+
+static void time_case (const char *name, struct bltinfo *b, int mt, int desc, int rounds)
+{
+    double table = time_blit (b, mt, desc, 0, rounds);
+    double fast = time_blit (b, mt, desc, 1, rounds);
+    printf ("%-36s table %7.0f ns, fast %7.0f ns\n", name, table, fast);
+}
+
+static void time_cases (int rounds)
+{
+    struct bltinfo b;
+
+    /* clear a 320x256 bitplane */
+    memset (&b, 0, sizeof b);
+    b.hblitsize = 20; b.vblitsize = 256;
+    b.bltafwm = b.bltalwm = 0xFFFF;
+    b.ptd = 0x10000;
+    time_case ("clear 320x256 plane (00)", &b, 0x00, 0, rounds);
+
+    /* restore a background strip: A to D, unshifted */
+    b.pta = 0x30000; b.bltamod = 20; b.bltdmod = 20; b.blitdownashift = 16;
+    b.hblitsize = 10;
+    time_case ("copy 160x256 (F0)", &b, 0xF0, 0, rounds);
+
+    /* a 32x32 bob, shifted, masked, into 4 interleaved planes */
+    memset (&b, 0, sizeof b);
+    b.hblitsize = 3; b.vblitsize = 32 * 4;
+    b.bltafwm = 0xFFFF; b.bltalwm = 0;
+    b.blitashift = b.blitbshift = 5;
+    b.blitdownashift = b.blitdownbshift = 11;
+    b.pta = 0x40000; b.ptb = 0x44000; b.ptc = b.ptd = 0x10000;
+    b.bltamod = b.bltbmod = -2; b.bltcmod = b.bltdmod = 34;
+    time_case ("bob 32x32x4 shifted (CA)", &b, 0xCA, 0, rounds);
+    b.blitashift = b.blitbshift = 0;
+    b.blitdownashift = b.blitdownbshift = 16;
+    b.hblitsize = 2; b.bltamod = b.bltbmod = 0; b.bltcmod = b.bltdmod = 36;
+    time_case ("bob 32x32x4 aligned (CA)", &b, 0xCA, 0, rounds);
+
+    /* fill a 320x200 polygon plane in place */
+    memset (&b, 0, sizeof b);
+    b.hblitsize = 20; b.vblitsize = 200;
+    b.bltafwm = b.bltalwm = 0xFFFF;
+    b.blitdownashift = 16;
+    b.blitfill = BLITFILL (0x10);
+    b.pta = b.ptd = 0x10000 + 40 * 200 - 2;
+    time_case ("fill 320x200 in place (F0 desc)", &b, 0xF0, 1, rounds);
+}
+
+int main (int argc, char **argv)
+{
+    int blits = argc > 1 ? atoi (argv[1]) : 100000;
+    int i, errors, taken = 0;
+
+    build_filltable ();
+#ifdef USE_BLIT_MASKTABLE
+    for (i = 0; i < BLITTER_MAX_WORDS; i++)
+	blit_masktable[i] = 0xFFFF;
+#endif
+    for (i = 0; i < MEM_SIZE; i++)
+	mem_table[i] = rnd () % 4 ? rnd () : 0;
+    memcpy (mem_fast, mem_table, MEM_SIZE);
+
+    errors = check (blits, &taken);
+    printf ("bit-exact check over %d blits (%d by the kernels): %s\n", blits, taken,
+	    errors ? "FAILED" : "ok");
+    time_cases (blits > 2000 ? 2000 : blits);
+    return errors != 0;
+}
@@ -0,0 +1,314 @@
+/*
+ * Line mode kernel micro-benchmark
+ *
+ * Draws random lines with src/blit_line.h and with a copy of
+ * blitter_line() from blitter.cpp, each on its own copy of chip memory:
+ * all eight octants, SING on and off, 0x4A, 0xCA and other minterms, C
+ * and D on or off, D apart from C, negative modulos, any start shift,
+ * B patterns and error terms, and pointers past the end of chip memory.
+ * Chip memory and every register the line leaves behind must match.
+ * Then times polygon outlines both ways.
+ *
+ *   make -f Makefile.bench bench-blitline
+ *   ./bench-blitline [lines]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+#include "config.h"
+#include "uae.h"
+#include "options.h"
+#include "custom.h"
+#include "memory.h"
+#include "blitter.h"
+#include "blitfunc.h"
+
+#define MEM_SIZE (512 * 1024)
+
+uae_u8 *chipmemory;
+uae_u32 chipmem_mask = MEM_SIZE - 1;
+uae_u16 bltcon0, bltcon1;
+uae_u32 bltapt, bltbpt, bltcpt, bltdpt;
+uae_u8 blit_filltable[256][4][2];
+#ifdef USE_BLIT_MASKTABLE
+uae_u32 blit_masktable[BLITTER_MAX_WORDS];
+#endif
+struct bltinfo blt_info;
+enum blitter_states bltstate;
+int blinea_shift;
+static uae_u16 blinea, blineb;
+static uaecptr bltcnxlpt, bltdnxlpt;
+static int blitsing, blitonedot, blitsign;
+
+typedef uae_u32 (*blit_func_tbl_t)(uae_u32, uae_u32, uae_u32);
+extern blit_func_tbl_t blit_func_tbl[0x100];
+#define blit_func(srca,srcb,srcc,mt) (blit_func_tbl[mt])(srca,srcb,srcc)
+
+#include "blit_line.h"
+
+static uae_u8 mem_ref[MEM_SIZE], mem_fast[MEM_SIZE];
+
+/* chipmem_wget()/chipmem_wput() */
+static uae_u32 ref_wget (uaecptr addr)
+{
+    return *(uae_u16 *)(chipmemory + (addr & chipmem_mask));
+}
+
+static void ref_wput (uaecptr addr, uae_u32 w)
+{
+    *(uae_u16 *)(chipmemory + (addr & chipmem_mask)) = w;
+}
+
+/* blitter_line() and its helpers, DMA on */
+static void ref_incx (void)
+{
+    if (++blinea_shift == 16) {
+	blinea_shift = 0;
+	bltcnxlpt += 2;
+	bltdnxlpt += 2;
+    }
+}
+
+static void ref_decx (void)
+{
+    if (blinea_shift-- == 0) {
+	blinea_shift = 15;
+	bltcnxlpt -= 2;
+	bltdnxlpt -= 2;
+    }
+}
+
+static void ref_decy (void)
+{
+    bltcnxlpt -= blt_info.bltcmod;
+    bltdnxlpt -= blt_info.bltcmod;
+    blitonedot = 0;
+}
+
+static void ref_incy (void)
+{
+    bltcnxlpt += blt_info.bltcmod;
+    bltdnxlpt += blt_info.bltcmod;
+    blitonedot = 0;
+}
+
+static void ref_line (void)
+{
+    do {
+	if (bltcon0 & 0x200) blt_info.bltcdat = ref_wget (bltcpt);
+	{
+	    uae_u16 blitahold = blinea >> blinea_shift, blitbhold = blineb & 1 ? 0xFFFF : 0, blitchold = blt_info.bltcdat;
+	    if (blitsing && blitonedot) blitahold = 0;
+	    blitonedot = 1;
+	    blt_info.bltddat = blit_func (blitahold, blitbhold, blitchold, bltcon0 & 0xFF);
+	    if (!blitsign) {
+		bltapt += (uae_s16)blt_info.bltamod;
+		if (bltcon1 & 0x10) {
+		    if (bltcon1 & 0x8) ref_decy (); else ref_incy ();
+		} else {
+		    if (bltcon1 & 0x8) ref_decx (); else ref_incx ();
+		}
+	    } else {
+		bltapt += (uae_s16)blt_info.bltbmod;
+	    }
+	    if (bltcon1 & 0x10) {
+		if (bltcon1 & 0x4) ref_decx (); else ref_incx ();
+	    } else {
+		if (bltcon1 & 0x4) ref_decy (); else ref_incy ();
+	    }
+	    blitsign = 0 > (uae_s16)bltapt;
+	}
+	if (blt_info.bltddat) blt_info.blitzero = 0;
+	if (bltcon0 & 0x100) ref_wput (bltdpt, blt_info.bltddat);
+	bltcpt = bltcnxlpt;
+	bltdpt = bltdnxlpt;
+	blineb = (blineb << 1) | (blineb >> 15);
+	if (--blt_info.vblitsize == 0)
+	    bltstate = BLT_done;
+	else
+	    bltstate = BLT_read;
+    } while (bltstate != BLT_done);
+}
+
+/* The line part of blit_init() */
+static void line_init (void)
+{
+    blt_info.blitzero = 1;
+    blt_info.blitbshift = bltcon1 >> 12;
+    blinea_shift = bltcon0 >> 12;
+    bltcnxlpt = bltcpt;
+    bltdnxlpt = bltdpt;
+    blitsing = bltcon1 & 0x2;
+    blinea = blt_info.bltadat;
+    blineb = (blt_info.bltbdat >> blt_info.blitbshift) | (blt_info.bltbdat << (16 - blt_info.blitbshift));
+    blitsign = bltcon1 & 0x40;
+    blitonedot = 0;
+    bltstate = BLT_init;
+}
+
+struct line_state {
+    uae_u32 apt, cpt, dpt, cnx, dnx;
+    uae_u16 cdat, ddat, b;
+    int zero, vsize, shift, sign, onedot, state;
+};
+
+static void save (struct line_state *s)
+{
+    s->apt = bltapt; s->cpt = bltcpt; s->dpt = bltdpt; s->cnx = bltcnxlpt; s->dnx = bltdnxlpt;
+    s->cdat = blt_info.bltcdat; s->ddat = blt_info.bltddat; s->b = blineb;
+    s->zero = blt_info.blitzero; s->vsize = blt_info.vblitsize; s->shift = blinea_shift;
+    s->sign = blitsign; s->onedot = blitonedot; s->state = bltstate;
+}
+
+static unsigned rnd_state = 0x1b873593;
+
+static unsigned rnd (void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* Registers for a line from (x0,y0), dx/dy as a program would set them */
+static void line_regs (int x0, int y0, int dx, int dy, int mt, int sing, int bpl)
+{
+    int adx = dx < 0 ? -dx : dx, ady = dy < 0 ? -dy : dy;
+    int dmax = adx > ady ? adx : ady, dmin = adx > ady ? ady : adx;
+    int oct, err = 4 * dmin - 2 * dmax;
+    uaecptr pt = 0x10000 + y0 * bpl + (x0 >> 3 & ~1);
+
+    /* SUD, SUL, AUL from the octant table */
+    if (adx > ady)
+	oct = (dy < 0 ? 0x8 : 0) | (dx < 0 ? 0x4 : 0);
+    else
+	oct = 0x10 | (dx < 0 ? 0x8 : 0) | (dy < 0 ? 0x4 : 0);
+    bltcon0 = ((x0 & 15) << 12) | 0xB00 | mt;
+    bltcon1 = ((x0 & 15) << 12) | oct | (sing ? 2 : 0) | (err < 0 ? 0x40 : 0) | 1;
+    blt_info.bltadat = 0x8000;
+    blt_info.bltbdat = 0xFFFF;
+    blt_info.bltamod = 4 * (dmin - dmax);
+    blt_info.bltbmod = 4 * dmin;
+    blt_info.bltcmod = blt_info.bltdmod = bpl;
+    blt_info.vblitsize = dmax + 1;
+    blt_info.hblitsize = 2;
+    bltapt = (uae_u16)err;
+    bltcpt = bltdpt = pt;
+}
+
+static void rnd_line (void)
+{
+    static const int minterms[] = { 0x4A, 0xCA, 0x4A, 0xCA, 0x0A, 0xFA, 0x5A, 0x00 };
+    int mt = rnd () % 4 ? minterms[rnd () % 8] : rnd () & 0xFF;
+
+    line_regs (rnd () % 640, rnd () % 400, (int)(rnd () % 1200) - 600, (int)(rnd () % 800) - 400,
+	       mt, rnd () % 2, 80);
+    switch (rnd () % 6) {
+    case 0: /* anything in the registers */
+	bltcon0 = (bltcon0 & 0xF0FF) | (rnd () & 0xF00);
+	bltcon1 = (rnd () & 0xF05E) | 1;
+	blt_info.bltadat = rnd ();
+	blt_info.bltbdat = rnd ();
+	blt_info.bltcdat = rnd ();
+	blt_info.bltamod = (uae_s16)rnd ();
+	blt_info.bltbmod = (uae_s16)rnd ();
+	blt_info.bltcmod = 2 * (int)(rnd () % 400) - 400;
+	bltapt = rnd ();
+	blt_info.vblitsize = 1 + rnd () % 1024;
+	break;
+    case 1: /* D apart from C */
+	bltdpt = bltcpt + 2 * (int)(rnd () % 64) - 64;
+	break;
+    case 2: /* off the end of chip memory */
+	bltcpt = bltdpt = MEM_SIZE - 2 * (rnd () % 256);
+	break;
+    }
+    line_init ();
+}
+
+static int check (int lines)
+{
+    struct line_state r, f;
+    int n, errors = 0;
+
+    for (n = 0; n < lines && errors < 10; n++) {
+	rnd_line ();
+	uae_u32 apt = bltapt, cpt = bltcpt, dpt = bltdpt, cnx = bltcnxlpt, dnx = bltdnxlpt;
+	uae_u16 b = blineb, cdat = blt_info.bltcdat;
+	int vsize = blt_info.vblitsize, shift = blinea_shift, sign = blitsign;
+
+	chipmemory = mem_ref;
+	ref_line ();
+	save (&r);
+
+	bltapt = apt; bltcpt = cpt; bltdpt = dpt; bltcnxlpt = cnx; bltdnxlpt = dnx;
+	blineb = b; blt_info.bltcdat = cdat; blt_info.vblitsize = vsize;
+	blinea_shift = shift; blitsign = sign; blitonedot = 0;
+	blt_info.blitzero = 1;
+	bltstate = BLT_init;
+	chipmemory = mem_fast;
+	blitline_do ();
+	save (&f);
+
+	if (memcmp (&r, &f, sizeof r) || memcmp (mem_ref, mem_fast, MEM_SIZE)) {
+	    printf ("mismatch: line %d minterm %02x bltcon1 %04x length %d\n", n, bltcon0 & 0xFF, bltcon1, vsize);
+	    memcpy (mem_fast, mem_ref, MEM_SIZE);
+	    errors++;
+	}
+    }
+    return errors;
+}
+
+/* A ring of polygon edges around (320,200), drawn for area fill */
+static double time_lines (int mt, int sing, int fast, int rounds, int *dots)
+{
+    struct timespec t0, t1;
+    int r, i;
+
+    chipmemory = mem_fast;
+    *dots = 0;
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    for (r = 0; r < rounds; r++)
+	for (i = 0; i < 32; i++) {
+	    int dx = ((i * 37) % 61) * 4 - 120, dy = ((i * 23) % 41) * 4 - 80;
+	    line_regs (320, 200, dx, dy, mt, sing, 80);
+	    line_init ();
+	    *dots += blt_info.vblitsize;
+	    if (fast)
+		blitline_do ();
+	    else
+		ref_line ();
+	}
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / *dots;
+}
+
+static void time_case (const char *name, int mt, int sing, int rounds)
+{
+    int dots;
+    double ref = time_lines (mt, sing, 0, rounds, &dots);
+    double fast = time_lines (mt, sing, 1, rounds, &dots);
+    printf ("%-32s ref %5.2f ns/dot, fast %5.2f ns/dot\n", name, ref, fast);
+}
+
+int main (int argc, char **argv)
+{
+    int lines = argc > 1 ? atoi (argv[1]) : 100000;
+    int i, errors;
+
+    for (i = 0; i < MEM_SIZE; i++)
+	mem_ref[i] = rnd () % 4 ? rnd () : 0;
+    memcpy (mem_fast, mem_ref, MEM_SIZE);
+
+    errors = check (lines);
+    printf ("bit-exact check over %d lines: %s\n", lines, errors ? "FAILED" : "ok");
+    time_case ("polygon edges, XOR SING (4A)", 0x4A, 1, 2000);
+    time_case ("wireframe, OR (CA)", 0xCA, 0, 2000);
+    time_case ("other minterm (5A)", 0x5A, 0, 2000);
+    return errors != 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Planar to chunky micro-benchmark
+ *
+ * Checks pfield_c2p_scalar() against a plain per-pixel conversion and
+ * pfield_c2p_vector() against pfield_c2p_scalar() over random bitplane
+ * data, every plane count and line length (all outputs must be
+ * bit-exact), then times both on full lores/hires lines.
+ *
+ *   make -f Makefile.bench bench-c2p
+ *   ./bench-c2p
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef unsigned char uae_u8;
+typedef unsigned int uae_u32;
+
+#include "pfield_c2p.h"
+
+#define MAX_WORDS 32
+#define PLANE_BYTES (MAX_WORDS * 4 + 16)
+
+static uae_u8 planes[8][PLANE_BYTES] __attribute__ ((aligned (16)));
+static uae_u32 out_ref[MAX_WORDS * 8 + 4], out_a[MAX_WORDS * 8 + 4], out_b[MAX_WORDS * 8 + 4];
+
+static unsigned rnd_state = 0x2545f491;
+
+static unsigned rnd (void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static void set_ptrs (uae_u8 **p, int offs)
+{
+    int i;
+    for (i = 0; i < 8; i++)
+	p[i] = planes[i] + offs;
+}
+
+/* One pixel at a time: bit 31 of each plane word is the leftmost pixel */
+static void c2p_reference (uae_u8 *out, int wordcount, int planes_nr, int offs)
+{
+    int w, x, p;
+    for (w = 0; w < wordcount; w++)
+	for (x = 0; x < 32; x++) {
+	    uae_u8 v = 0;
+	    for (p = 0; p < planes_nr; p++) {
+		uae_u32 word = *(uae_u32 *)(planes[p] + offs + w * 4);
+		v |= ((word >> (31 - x)) & 1) << p;
+	    }
+	    out[w * 32 + x] = v;
+	}
+}
+
+static int check (void)
+{
+    int round, n, wc, offs, errors = 0;
+    uae_u8 *p[8];
+
+    for (round = 0; round < 200; round++) {
+	for (n = 0; n < 8; n++)
+	    for (wc = 0; wc < PLANE_BYTES; wc++)
+		planes[n][wc] = rnd ();
+	for (n = 1; n <= 8; n++)
+	    for (wc = 0; wc <= MAX_WORDS; wc++) {
+		offs = (rnd () & 3) * 4;
+		memset (out_a, 0xaa, sizeof out_a);
+		memset (out_b, 0x55, sizeof out_b);
+		c2p_reference ((uae_u8 *)out_ref, wc, n, offs);
+		set_ptrs (p, offs);
+		pfield_c2p_scalar (out_a, wc, p, n);
+		if (memcmp (out_a, out_ref, wc * 32) || p[n - 1] != planes[n - 1] + offs + wc * 4) {
+		    printf ("scalar mismatch: planes %d words %d\n", n, wc);
+		    errors++;
+		}
+#ifdef PFIELD_C2P_VECTOR
+		set_ptrs (p, offs);
+		pfield_c2p_vector (out_b + 1, wc, p, n);
+		if (memcmp (out_b + 1, out_a, wc * 32) || out_b[1 + wc * 8] != 0x55555555
+		    || p[n - 1] != planes[n - 1] + offs + wc * 4) {
+		    printf ("vector mismatch: planes %d words %d\n", n, wc);
+		    errors++;
+		}
+#endif
+	    }
+    }
+    return errors;
+}
+
+static double time_lines (int vector, int planes_nr, int wordcount, int lines)
+{
+    struct timespec t0, t1;
+    uae_u8 *p[8];
+    int i;
+
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < lines; i++) {
+	set_ptrs (p, 0);
+#ifdef PFIELD_C2P_VECTOR
+	if (vector)
+	    pfield_c2p_vector (out_a, wordcount, p, planes_nr);
+	else
+#endif
+	    pfield_c2p_scalar (out_a, wordcount, p, planes_nr);
+	__asm__ __volatile__ ("" : : "r" (out_a) : "memory");
+    }
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / lines;
+}
+
+int main (int argc, char **argv)
+{
+    int lines = argc > 1 ? atoi (argv[1]) : 200000;
+    static const int plane_counts[] = { 1, 3, 5, 6, 8 };
+    int errors = check (), i;
+
+    printf ("bit-exact check: %s\n", errors ? "FAILED" : "ok");
+#ifndef PFIELD_C2P_VECTOR
+    printf ("vector backend not available for this target\n");
+#endif
+    /* 320 pixel lores line = 10 words, 640 pixel hires line = 20 words */
+    for (i = 0; i < sizeof plane_counts / sizeof *plane_counts; i++) {
+	int n = plane_counts[i];
+	double s10 = time_lines (0, n, 10, lines), s20 = time_lines (0, n, 20, lines);
+#ifdef PFIELD_C2P_VECTOR
+	double v10 = time_lines (1, n, 10, lines), v20 = time_lines (1, n, 20, lines);
+	printf ("%d planes: lores %.1f -> %.1f ns/line, hires %.1f -> %.1f ns/line\n",
+		n, s10, v10, s20, v20);
+#else
+	printf ("%d planes: lores %.1f ns/line, hires %.1f ns/line\n", n, s10, s20);
+#endif
+    }
+    return errors != 0;
+}
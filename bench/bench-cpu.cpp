@@ -0,0 +1,572 @@
+/*
+ * 68000 core micro-benchmark
+ *
+ * Runs a few hand assembled 68000 loops through m68k_emulate() of the
+ * real famec.cpp, in slices of one PAL scanline like m68k_go() does:
+ * register ALU work, a memory copy, subroutine calls and branches,
+ * MULU/DIVU on memory, custom register accesses going through memory
+ * handlers, and NOPs for the cost of fetch and dispatch alone. Each loop
+ * first runs a fixed number of cycles and its registers, memory and
+ * handler traffic are checked against the values the function pointer
+ * build gives, so the computed goto build (bench-cpu-gotos) must match
+ * it exactly. Then prints the host time per emulated second of each
+ * loop.
+ *
+ * The polling kernels wait on a small chip model instead: VHPOSR, VERTB
+ * in INTREQR, the CIA-A fire bit and a flag in RAM, which like the real
+ * chips only move between two slices. They run in slices of varying
+ * length, as m68k_go() sizes them to the next event, and the registers,
+ * PC, SR and cycle count after every slice go into their checksum.
+ * bench-cpu-idle runs the slices through m68k_idle_emulate() of
+ * USE_CPU_IDLE_SKIP and must give the same checksums. It must also skip
+ * cycles in the polling loops, and never in the two busy loops, where
+ * a counter or a register swap changes every pass.
+ *
+ * bench-cpu-predecode runs the kernel code, which nothing writes, as the
+ * FAME_PREDECODE range the core keeps for the Kickstart, and prints how
+ * many opcodes were dispatched from it with their handler cached.
+ *
+ * bench-cpu-dynarec runs the slices through m68k_dynarec_emulate() of
+ * USE_MIPS_DYNAREC, its MIPS blocks on the emulated MIPS, and with
+ * MIPS_DYNAREC_LOCKSTEP: every block run is compared with FAME running
+ * the same cycles, and a difference fails the kernel. The checksums
+ * must be the same too. Its times are those of the emulated MIPS, not
+ * of the translated code.
+ *
+ *   make -f Makefile.bench bench-cpu bench-cpu-gotos bench-cpu-idle bench-cpu-predecode bench-cpu-dynarec
+ *   ./bench-cpu [emulated seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+#include "m68k/fame/fame.h"
+#ifdef USE_MIPS_DYNAREC
+#include "m68k/mips/m68k_dynarec.h"
+#endif
+
+#define RAM_SIZE (512 * 1024)
+#define SLICE 454		/* CPU cycles in a PAL scanline */
+#define FRAME_LINES 50		/* a short frame, for the chip model */
+#define CHECK_SLICES 2000
+#define CPU_HZ 7093790
+
+#define KERNEL_ADDR 0x1000
+#define DATA_ADDR 0x10000
+#define DATA_SIZE 0x20000
+#define TRAP_ADDR 0x400
+
+/* 68k memory in 16 bit host words, as chip memory is; static so that
+   the core can keep its addresses in 32 bits */
+static uae_u16 ram[RAM_SIZE / 2];
+static uae_u32 custom_sum, custom_reads;
+
+static M68K_CONTEXT ctx;
+static M68K_PROGRAM fetch[2];
+static M68K_DATA read8[4], read16[4], write8[4], write16[4];
+
+/* the chip model: beam position in CPU cycles, INTREQ, and the seed
+   of the slice lengths */
+static uae_u32 chips_time, chips_intreq, slice_seed;
+
+enum { CHIPS_NONE, CHIPS_POLL, CHIPS_BUSY };
+
+struct kernel {
+    const char *name;
+    const uae_u16 *code;
+    int words;
+    uae_u32 expect;
+    int chips;			/* CHIPS_POLL or CHIPS_BUSY: runs on the chip model */
+};
+
+#ifdef USE_CPU_IDLE_SKIP
+/* What m68k_idle.h takes from m68k_intrf.h and memory.h, over the
+   banks of load() */
+extern M68K_CONTEXT m68kcontext;
+#define M68KCONTEXT m68kcontext
+#define _68k_areg(num) (M68KCONTEXT.areg[(num)])
+#define _68k_intmask ((M68KCONTEXT.sr >> 8) & 7)
+
+typedef struct { uae_u8 *baseaddr; } addrbank;
+static addrbank ram_bank = { (uae_u8 *)ram }, custom_bank, cia_bank, dummy_bank;
+int uae4all_go_interrupt;
+
+static addrbank *bench_bank (uae_u32 addr)
+{
+    if (addr < RAM_SIZE)
+	return &ram_bank;
+    if ((addr & 0xFF0000) == 0xDF0000)
+	return &custom_bank;
+    if ((addr & 0xFF0000) == 0xBF0000)
+	return &cia_bank;
+    return &dummy_bank;
+}
+#define get_mem_bank(addr) (*bench_bank (addr))
+
+static uae_u32 get_word (uae_u32 addr)
+{
+    return ram[(addr & (RAM_SIZE - 1)) / 2];
+}
+
+static uae_u32 get_long (uae_u32 addr)
+{
+    return (get_word (addr) << 16) | get_word (addr + 2);
+}
+
+#include "m68k/fame/m68k_idle.h"
+#endif
+
+/* nothing but fetch and dispatch */
+static const uae_u16 k_nop[] = {
+    0x4E71, 0x4E71, 0x4E71, 0x4E71,	/* 00 nop */
+    0x4E71, 0x4E71, 0x4E71, 0x4E71,
+    0x4E71, 0x4E71, 0x4E71, 0x4E71,
+    0x4E71, 0x4E71, 0x4E71,
+    0x60E0			/* 1e bra.s $00 */
+};
+
+static const uae_u16 k_alu[] = {
+    0x7001,			/* 00 moveq #1,d0 */
+    0x7403,			/* 02 moveq #3,d2 */
+    0x3E3C, 0x00FF,		/* 04 move.w #255,d7 */
+    0x2200,			/* 08 move.l d0,d1 */
+    0xD282,			/* 0a add.l d2,d1 */
+    0xB383,			/* 0c eor.l d1,d3 */
+    0xE789,			/* 0e lsl.l #3,d1 */
+    0x9041,			/* 10 sub.w d1,d0 */
+    0x5282,			/* 12 addq.l #1,d2 */
+    0xC843,			/* 14 and.w d3,d4 */
+    0x8A84,			/* 16 or.l d4,d5 */
+    0x4845,			/* 18 swap d5 */
+    0xE25B,			/* 1a ror.w #1,d3 */
+    0x51CF, 0xFFEA,		/* 1c dbra d7,$08 */
+    0x60DE			/* 20 bra.s $00 */
+};
+
+static const uae_u16 k_copy[] = {
+    0x41F9, 0x0001, 0x0000,	/* 00 lea $10000,a0 */
+    0x43F9, 0x0002, 0x0000,	/* 06 lea $20000,a1 */
+    0x3E3C, 0x00FF,		/* 0c move.w #255,d7 */
+    0x22D8,			/* 10 move.l (a0)+,(a1)+ */
+    0x51CF, 0xFFFC,		/* 12 dbra d7,$10 */
+    0x60E8			/* 16 bra.s $00 */
+};
+
+static const uae_u16 k_branch[] = {
+    0x7000,			/* 00 moveq #0,d0 */
+    0x3E3C, 0x03E7,		/* 02 move.w #999,d7 */
+    0x6112,			/* 06 bsr.s $1a */
+    0x5240,			/* 08 addq.w #1,d0 */
+    0x0800, 0x0000,		/* 0a btst #0,d0 */
+    0x6702,			/* 0e beq.s $12 */
+    0x4641,			/* 10 not.w d1 */
+    0x51CF, 0xFFF2,		/* 12 dbra d7,$06 */
+    0x60E8,			/* 16 bra.s $00 */
+    0x4E71,			/* 18 nop */
+    0xD280,			/* 1a add.l d0,d1 */
+    0xE399,			/* 1c rol.l #1,d1 */
+    0x4E75			/* 1e rts */
+};
+
+static const uae_u16 k_muldiv[] = {
+    0x41F9, 0x0001, 0x0000,	/* 00 lea $10000,a0 */
+    0x3E3C, 0x01FF,		/* 06 move.w #511,d7 */
+    0x3010,			/* 0a move.w (a0),d0 */
+    0xC0FC, 0x04D2,		/* 0c mulu.w #1234,d0 */
+    0xD480,			/* 10 add.l d0,d2 */
+    0x3142, 0x0002,		/* 12 move.w d2,2(a0) */
+    0x2202,			/* 16 move.l d2,d1 */
+    0x82FC, 0x0007,		/* 18 divu.w #7,d1 */
+    0x3081,			/* 1c move.w d1,(a0) */
+    0x5488,			/* 1e addq.l #2,a0 */
+    0x51CF, 0xFFE8,		/* 20 dbra d7,$0a */
+    0x60DA			/* 24 bra.s $00 */
+};
+
+static const uae_u16 k_custom[] = {
+    0x45F9, 0x00DF, 0xF180,	/* 00 lea $dff180,a2 */
+    0x47F9, 0x00DF, 0xF006,	/* 06 lea $dff006,a3 */
+    0x3E3C, 0x00FF,		/* 0c move.w #255,d7 */
+    0x3013,			/* 10 move.w (a3),d0 */
+    0x3480,			/* 12 move.w d0,(a2) */
+    0x0240, 0x0F0F,		/* 14 andi.w #$0f0f,d0 */
+    0x3540, 0x0002,		/* 18 move.w d0,2(a2) */
+    0x51CF, 0xFFF2,		/* 1c dbra d7,$10 */
+    0x60DE			/* 20 bra.s $00 */
+};
+
+/* WaitTOF style: wait for a raster line, then for the next one */
+static const uae_u16 k_vpos[] = {
+    0x41F9, 0x00DF, 0xF006,	/* 00 lea $dff006,a0 */
+    0x3010,			/* 06 move.w (a0),d0 */
+    0x0240, 0xFF00,		/* 08 andi.w #$ff00,d0 */
+    0xB07C, 0x2000,		/* 0c cmp.w #$2000,d0 */
+    0x66F4,			/* 10 bne.s $06 */
+    0x5247,			/* 12 addq.w #1,d7 */
+    0x3010,			/* 14 move.w (a0),d0 */
+    0x0240, 0xFF00,		/* 16 andi.w #$ff00,d0 */
+    0xB07C, 0x2000,		/* 1a cmp.w #$2000,d0 */
+    0x67F4,			/* 1e beq.s $14 */
+    0x60E4			/* 20 bra.s $06 */
+};
+
+/* wait for VERTB in INTREQR, then acknowledge it */
+static const uae_u16 k_intreq[] = {
+    0x41F9, 0x00DF, 0xF01E,	/* 00 lea $dff01e,a0 */
+    0x0828, 0x0005, 0x0001,	/* 06 btst #5,1(a0) */
+    0x67F8,			/* 0c beq.s $06 */
+    0x5247,			/* 0e addq.w #1,d7 */
+    0x317C, 0x0020, 0x007E,	/* 10 move.w #$20,$7e(a0) */
+    0x60EE			/* 16 bra.s $06 */
+};
+
+/* wait for the fire button on CIA-A, then for its release */
+static const uae_u16 k_cia[] = {
+    0x43F9, 0x00BF, 0xE001,	/* 00 lea $bfe001,a1 */
+    0x0811, 0x0006,		/* 06 btst #6,(a1) */
+    0x66FA,			/* 0a bne.s $06 */
+    0x5247,			/* 0c addq.w #1,d7 */
+    0x0811, 0x0006,		/* 0e btst #6,(a1) */
+    0x67FA,			/* 12 beq.s $0e */
+    0x60F0			/* 14 bra.s $06 */
+};
+
+/* wait for a flag in RAM that the frame sets, then clear it */
+static const uae_u16 k_ramflag[] = {
+    0x41F9, 0x0001, 0x0000,	/* 00 lea $10000,a0 */
+    0x4A50,			/* 06 tst.w (a0) */
+    0x67FC,			/* 08 beq.s $06 */
+    0x4250,			/* 0a clr.w (a0) */
+    0x5247,			/* 0c addq.w #1,d7 */
+    0x60F6			/* 0e bra.s $06 */
+};
+
+/* polls like k_vpos, but counts the passes: must not be skipped */
+static const uae_u16 k_count[] = {
+    0x41F9, 0x00DF, 0xF006,	/* 00 lea $dff006,a0 */
+    0x5281,			/* 06 addq.l #1,d1 */
+    0x3010,			/* 08 move.w (a0),d0 */
+    0x0240, 0xFF00,		/* 0a andi.w #$ff00,d0 */
+    0xB07C, 0x2000,		/* 0e cmp.w #$2000,d0 */
+    0x66F2,			/* 12 bne.s $06 */
+    0x5247,			/* 14 addq.w #1,d7 */
+    0x60EE			/* 16 bra.s $06 */
+};
+
+/* only instructions the skip accepts, but d1 and d2 trade places every
+   pass, so no two passes in a row leave the same state */
+static const uae_u16 k_swap[] = {
+    0x7201,			/* 00 moveq #1,d1 */
+    0x41F9, 0x00DF, 0xF006,	/* 02 lea $dff006,a0 */
+    0x2001,			/* 08 move.l d1,d0 */
+    0x2202,			/* 0a move.l d2,d1 */
+    0x2400,			/* 0c move.l d0,d2 */
+    0x3610,			/* 0e move.w (a0),d3 */
+    0x0243, 0xFF00,		/* 10 andi.w #$ff00,d3 */
+    0xB67C, 0x2000,		/* 14 cmp.w #$2000,d3 */
+    0x66EE,			/* 18 bne.s $08 */
+    0x5247,			/* 1a addq.w #1,d7 */
+    0x60EA			/* 1c bra.s $08 */
+};
+
+#define KERNEL(k) #k, k_##k, sizeof k_##k / sizeof k_##k[0]
+
+/* expected state checksums, from the function pointer build */
+static struct kernel kernels[] = {
+    { KERNEL(nop), 0xC601C9E6 },
+    { KERNEL(alu), 0xB476BFB6 },
+    { KERNEL(copy), 0xF57B7F9B },
+    { KERNEL(branch), 0xE9690749 },
+    { KERNEL(muldiv), 0x56713C06 },
+    { KERNEL(custom), 0x2943247C },
+    { KERNEL(vpos), 0x257563C5, CHIPS_POLL },
+    { KERNEL(intreq), 0x4CEFAF4C, CHIPS_POLL },
+    { KERNEL(cia), 0xB1A85E3C, CHIPS_POLL },
+    { KERNEL(ramflag), 0xF67D6530, CHIPS_POLL },
+    { KERNEL(count), 0x83229C4F, CHIPS_BUSY },
+    { KERNEL(swap), 0xDCE2CED7, CHIPS_BUSY },
+};
+
+/* the $dfxxxx bank: a beam counter to read, a sum of the writes */
+static uae_u8 custom_bget (uae_s32 addr)
+{
+    return custom_reads++;
+}
+
+static uae_u16 custom_wget (uae_s32 addr)
+{
+    return (custom_reads++ * 0x9E37) ^ addr;
+}
+
+static void custom_put (uae_s32 addr, uae_s32 v)
+{
+    custom_sum = custom_sum * 31 + (addr & 0x1FF) + (v & 0xFFFF);
+}
+
+/* The chip model, as the polling kernels see it: VHPOSR, INTREQR and
+   INTREQ, and the CIA-A fire button, down on every other 8 lines */
+static uae_u16 chips_wget (uae_s32 addr)
+{
+    uae_u32 line = chips_time / SLICE;
+
+    if ((addr & 0xFF0000) == 0xBF0000)
+	return ((addr >> 8) & 0xF) == 0 && (line & 8) ? 0xFFBF : 0xFFFF;
+    switch (addr & 0x1FE) {
+    case 0x006:
+	return ((line % FRAME_LINES) << 8) | (chips_time % SLICE) / 2;
+    case 0x01E:
+	return chips_intreq;
+    }
+    return 0;
+}
+
+static uae_u8 chips_bget (uae_s32 addr)
+{
+    uae_u16 v = chips_wget (addr & ~1);
+    return addr & 1 ? v : v >> 8;
+}
+
+static void chips_put (uae_s32 addr, uae_s32 v)
+{
+    if ((addr & 0xFF01FE) == 0xDF009C) {
+	if (v & 0x8000)
+	    chips_intreq |= v & 0x7FFF;
+	else
+	    chips_intreq &= ~v;
+    }
+    custom_sum = custom_sum * 31 + (addr & 0x1FF) + (v & 0xFFFF);
+}
+
+/* do_cycles() after a slice: the beam moves on by the cycles the CPU
+   took, and a new frame raises VERTB and sets the flag in RAM, as a
+   VERTB handler would */
+static void chips_advance (uae_u32 cycles)
+{
+    uae_u32 frame = chips_time / (SLICE * FRAME_LINES);
+
+    chips_time += cycles;
+    if (chips_time / (SLICE * FRAME_LINES) != frame) {
+	chips_intreq |= 0x20;
+	ram[DATA_ADDR / 2] = 1;
+    }
+}
+
+static void put_long (uae_u32 addr, uae_u32 v)
+{
+    ram[addr / 2] = v >> 16;
+    ram[addr / 2 + 1] = v;
+}
+
+static void set_bank (M68K_DATA *d, void *handler)
+{
+    d[0].low_addr = 0;
+    d[0].high_addr = RAM_SIZE - 1;
+    d[0].mem_handler = NULL;
+    d[0].data = ram;
+    d[1].low_addr = 0xDF0000;
+    d[1].high_addr = 0xDFFFFF;
+    d[1].mem_handler = handler;
+    d[1].data = NULL;
+    d[2].low_addr = 0xBF0000;
+    d[2].high_addr = 0xBFFFFF;
+    d[2].mem_handler = handler;
+    d[2].data = NULL;
+    d[3].low_addr = (unsigned)-1;
+    d[3].high_addr = (unsigned)-1;
+}
+
+/* a reset into the kernel, with fresh data and registers */
+static void load (const struct kernel *k)
+{
+    uae_u32 seed = 0x2545F491;
+    int i;
+
+    memset (ram, 0, sizeof ram);
+    put_long (0, 0x80000);
+    put_long (4, KERNEL_ADDR);
+    for (i = 2; i < 256; i++)
+	put_long (i * 4, TRAP_ADDR);
+    ram[TRAP_ADDR / 2] = 0x60FE;	/* bra.s * */
+    memcpy (&ram[KERNEL_ADDR / 2], k->code, k->words * 2);
+    for (i = 0; i < DATA_SIZE / 2; i++) {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	ram[DATA_ADDR / 2 + i] = seed;
+    }
+    custom_sum = custom_reads = 0;
+    chips_time = chips_intreq = 0;
+    slice_seed = 0x9E3779B9;
+    if (k->chips)
+	ram[DATA_ADDR / 2] = 0;
+
+    memset (&ctx, 0, sizeof ctx);
+    fetch[0].low_addr = 0;
+    fetch[0].high_addr = RAM_SIZE - 1;
+    fetch[0].offset = (unsigned)(uintptr_t)ram;
+    fetch[1].low_addr = (unsigned)-1;
+    fetch[1].high_addr = (unsigned)-1;
+    set_bank (read8, k->chips ? (void *)&chips_bget : (void *)&custom_bget);
+    set_bank (read16, k->chips ? (void *)&chips_wget : (void *)&custom_wget);
+    set_bank (write8, k->chips ? (void *)&chips_put : (void *)&custom_put);
+    set_bank (write16, k->chips ? (void *)&chips_put : (void *)&custom_put);
+    ctx.fetch = ctx.sv_fetch = ctx.user_fetch = fetch;
+    ctx.read_byte = ctx.sv_read_byte = ctx.user_read_byte = read8;
+    ctx.read_word = ctx.sv_read_word = ctx.user_read_word = read16;
+    ctx.write_byte = ctx.sv_write_byte = ctx.user_write_byte = write8;
+    ctx.write_word = ctx.sv_write_word = ctx.user_write_word = write16;
+    m68k_set_context (&ctx);
+    m68k_reset ();
+#ifdef USE_CPU_IDLE_SKIP
+    m68k_idle_reset ();
+#endif
+#ifdef FAME_PREDECODE
+    m68k_predecode_range (KERNEL_ADDR, KERNEL_ADDR + 0xFFF);
+#endif
+#ifdef USE_MIPS_DYNAREC
+    m68k_dynarec_reset ();
+#endif
+}
+
+/* One slice as m68k_go() runs it. On the chip model it is as long as
+   to a next event somewhere in the following two lines, and the chips
+   catch up after it. */
+static void run_slice (const struct kernel *k)
+{
+    uae_u32 before = m68k_get_cycles_counter ();
+    int cycles = SLICE;
+
+    if (k->chips) {
+	slice_seed = slice_seed * 1103515245 + 12345;
+	cycles = 40 + (slice_seed >> 16) % (2 * SLICE);
+    }
+#ifdef USE_CPU_IDLE_SKIP
+    m68k_idle_emulate (cycles);
+#elif defined(USE_MIPS_DYNAREC)
+    m68k_dynarec_emulate (cycles);
+#else
+    m68k_emulate (cycles);
+#endif
+    if (k->chips)
+	chips_advance (m68k_get_cycles_counter () - before);
+}
+
+/* the registers, PC, SR and cycle count after a slice */
+static uae_u32 slice_sum (uae_u32 h)
+{
+    int i;
+
+    for (i = M68K_REG_D0; i <= M68K_REG_SR; i++)
+	h = (h ^ (uae_u32)m68k_get_register ((m68k_register)i)) * 0x01000193;
+    return (h ^ m68k_get_cycles_counter ()) * 0x01000193;
+}
+
+static uae_u32 state_sum (void)
+{
+    uae_u32 h = 0x811C9DC5;
+    int i;
+
+    for (i = M68K_REG_D0; i <= M68K_REG_SR; i++)
+	h = (h ^ (uae_u32)m68k_get_register ((m68k_register)i)) * 0x01000193;
+    for (i = 0; i < DATA_SIZE / 2; i++)
+	h = (h ^ ram[DATA_ADDR / 2 + i]) * 0x01000193;
+    h = (h ^ custom_sum) * 0x01000193;
+    return (h ^ custom_reads) * 0x01000193;
+}
+
+static double ms_since (struct timespec *t0)
+{
+    struct timespec t1;
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) * 1e3 + (t1.tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+int main (int argc, char **argv)
+{
+    int seconds = argc > 1 ? atoi (argv[1]) : 2;
+    unsigned i, errors = 0;
+    double total = 0;
+
+    if (seconds < 1)
+	seconds = 1;
+    m68k_init ();
+#ifdef FAME_GOTOS
+    printf ("computed goto dispatch\n");
+#else
+    printf ("function pointer dispatch\n");
+#endif
+#ifdef USE_CPU_IDLE_SKIP
+    printf ("idle loop skipping\n");
+#endif
+#ifdef FAME_PREDECODE
+    printf ("predecoded kernel code\n");
+#endif
+#ifdef USE_MIPS_DYNAREC
+    printf ("translated blocks on the emulated MIPS, checked against FAME\n");
+#endif
+    printf ("kernel      state     ms per emulated s  realtime\n");
+    for (i = 0; i < sizeof kernels / sizeof kernels[0]; i++) {
+	struct kernel *k = &kernels[i];
+	struct timespec t0;
+	long slices = (long)seconds * CPU_HZ / SLICE, n;
+	uae_u32 sum;
+	double ms, skipped = 0, translated = 0;
+	int failed;
+
+	load (k);
+	sum = 0x811C9DC5;
+#ifdef USE_CPU_IDLE_SKIP
+	idle_hits = 0;
+	idle_skipped = 0;
+#endif
+	for (n = 0; n < CHECK_SLICES; n++) {
+	    run_slice (k);
+	    if (k->chips)
+		sum = slice_sum (sum);
+	}
+	sum = k->chips ? (sum ^ state_sum ()) * 0x01000193 : state_sum ();
+	failed = m68k_get_pc () == TRAP_ADDR || (k->expect && sum != k->expect);
+#ifdef USE_CPU_IDLE_SKIP
+	/* the polling loops must be skipped, the busy ones never */
+	if ((k->chips == CHIPS_POLL && !idle_hits) || (k->chips == CHIPS_BUSY && idle_hits))
+	    failed = 1;
+	skipped = 100 * idle_skipped / m68k_get_cycles_counter ();
+#endif
+#ifdef USE_MIPS_DYNAREC
+	if (m68k_dynarec_stats.mismatches)
+	    failed = 1;
+	translated = 100 * m68k_dynarec_stats.cycles / m68k_get_cycles_counter ();
+#endif
+	errors += failed;
+
+	load (k);
+	clock_gettime (CLOCK_MONOTONIC, &t0);
+	for (n = 0; n < slices; n++)
+	    run_slice (k);
+	ms = ms_since (&t0) / seconds;
+	total += ms;
+	printf ("%-8s %08x %s %12.2f %8.1fx", k->name, sum, failed ? "FAILED" : "ok    ", ms, 1000 / ms);
+#ifdef USE_CPU_IDLE_SKIP
+	printf ("  %5.1f%% skipped", skipped);
+#endif
+#ifdef FAME_PREDECODE
+	{
+	    unsigned hits, misses;
+	    m68k_predecode_stats (&hits, &misses);
+	    printf ("  %u hits, %u misses", hits, misses);
+	}
+#endif
+#ifdef USE_MIPS_DYNAREC
+	printf ("  %5.1f%% in blocks", translated);
+#endif
+	printf ("\n");
+    }
+    printf ("all kernels: %.2f ms per emulated second\n", total / i);
+    printf ("state checks: %s\n", errors ? "FAILED" : "ok");
+    return errors != 0;
+}
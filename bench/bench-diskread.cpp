@@ -0,0 +1,265 @@
+/*
+ * Disk read DMA micro-benchmark
+ *
+ * Builds src/disk_read.h twice, with and without USE_DISK_FAST_READ,
+ * and streams the same tracks through both a line at a time: AmigaDOS
+ * tracks encoded as drive_fill_bigbuf() does (from the ADF files given
+ * on the command line, random sector data otherwise) and raw tracks of
+ * odd bit lengths. DSKSYNC, ADKCON word sync, DMA on/off, drive ready
+ * and floppy speed change along the way. After every line the DMA
+ * words, DSKBYTR values and cycles, word sync cycles, disk_sync[] and
+ * the stream state must match.
+ *
+ *   make -f Makefile.bench bench-diskread
+ *   ./bench-diskread [disk.adf ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef unsigned char uae_u8;
+typedef unsigned short uae_u16;
+typedef unsigned int uae_u32;
+
+#define MAXHPOS 227
+#define MAX_DISK_WORDS_PER_LINE 50
+#define WORDSYNC_CYCLES 7
+#define DISK_INDEXSYNC 1
+#define DISK_WORDSYNC 2
+#define FLOPPY_WRITE_LEN (12650 / 2)
+#define FLOPPY_GAP_LEN (FLOPPY_WRITE_LEN - 11 * 544)
+#define NORMAL_FLOPPY_SPEED 1830
+
+typedef struct {
+    uae_u16 *bigmfmbuf;
+    int mfmpos;
+    int tracklen;
+    int trackspeed;
+    int dskready;
+} drive;
+
+static int maxhpos = MAXHPOS;
+static uae_u16 dsksync, adkcon;
+
+static void write_log (const char *s)
+{
+    fputs (s, stderr);
+}
+
+#define DISK_READ_STATE \
+    static uae_u16 dskbytr_tab[MAX_DISK_WORDS_PER_LINE * 2 + 1]; \
+    static uae_u8 dskbytr_cycle[MAX_DISK_WORDS_PER_LINE * 2 + 1]; \
+    static short wordsync_cycle[MAX_DISK_WORDS_PER_LINE * 2 + 1]; \
+    static uae_u32 dma_tab[MAX_DISK_WORDS_PER_LINE + 1]; \
+    static uae_u8 disk_sync[MAXHPOS]; \
+    static int dma_enable, bitoffset, disk_hpos, events; \
+    static uae_u32 word; \
+    static void disk_events (int last) { events++; }
+
+namespace bitloop {
+DISK_READ_STATE
+#define DISK_READ_NAME disk_doupdate_read
+#include "../src/disk_read.h"
+}
+
+namespace fast {
+DISK_READ_STATE
+#define USE_DISK_FAST_READ
+#define DISK_READ_NAME disk_doupdate_read
+#include "../src/disk_read.h"
+#undef USE_DISK_FAST_READ
+}
+
+#define MAX_TRACK_WORDS 0x8000
+
+static uae_u16 tracks[8][MAX_TRACK_WORDS];
+static int tracklens[8];
+
+static unsigned rnd_state = 0x3c6ef372;
+
+static unsigned rnd (void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static void mfmcode (uae_u16 * mfm, int words)
+{
+    uae_u32 lastword = 0;
+
+    while (words--) {
+	uae_u32 v = *mfm;
+	uae_u32 lv = (lastword << 16) | v;
+	uae_u32 nlv = 0x55555555 & ~lv;
+	uae_u32 mfmbits = (nlv << 1) & (nlv >> 1);
+
+	*mfm++ = v | mfmbits;
+	lastword = v;
+    }
+}
+
+/* Same layout as drive_fill_bigbuf(), checksums left out */
+static int encode_amigados (uae_u16 *mfm, int tr, const uae_u8 *data)
+{
+    int sec, i;
+
+    for (i = 0; i < FLOPPY_GAP_LEN; i++)
+	mfm[i] = 0xaaaa;
+    for (sec = 0; sec < 11; sec++) {
+	uae_u16 *mfmbuf = mfm + 544 * sec + FLOPPY_GAP_LEN;
+	uae_u32 deven, dodd;
+
+	mfmbuf[0] = mfmbuf[1] = 0xaaaa;
+	mfmbuf[2] = mfmbuf[3] = 0x4489;
+	deven = (0xff << 24) | (tr << 16) | (sec << 8) | (11 - sec);
+	dodd = (deven >> 1) & 0x55555555;
+	deven &= 0x55555555;
+	mfmbuf[4] = dodd >> 16;
+	mfmbuf[5] = dodd;
+	mfmbuf[6] = deven >> 16;
+	mfmbuf[7] = deven;
+	for (i = 8; i < 32; i++)
+	    mfmbuf[i] = 0xaaaa;
+	for (i = 0; i < 512; i += 4) {
+	    const uae_u8 *d = data + sec * 512 + i;
+	    deven = (d[0] << 24) | (d[1] << 16) | (d[2] << 8) | d[3];
+	    dodd = (deven >> 1) & 0x55555555;
+	    deven &= 0x55555555;
+	    mfmbuf[(i >> 1) + 32] = dodd >> 16;
+	    mfmbuf[(i >> 1) + 33] = dodd;
+	    mfmbuf[(i >> 1) + 256 + 32] = deven >> 16;
+	    mfmbuf[(i >> 1) + 256 + 33] = deven;
+	}
+	mfmcode (mfmbuf + 4, 544 - 4);
+    }
+    return (11 * 544 + FLOPPY_GAP_LEN) * 16;
+}
+
+static void make_tracks (int argc, char **argv)
+{
+    static uae_u8 data[11 * 512];
+    int t, i;
+
+    for (t = 0; t < 4; t++) {
+	FILE *f = t + 1 < argc ? fopen (argv[t + 1], "rb") : NULL;
+	int tr = 20 + 30 * t;
+	if (f) {
+	    fseek (f, tr * 11 * 512L, SEEK_SET);
+	    if (fread (data, 1, sizeof data, f) != sizeof data)
+		printf ("%s: short read, track %d padded\n", argv[t + 1], tr);
+	    fclose (f);
+	} else {
+	    for (i = 0; i < (int)sizeof data; i++)
+		data[i] = rnd ();
+	}
+	tracklens[t] = encode_amigados (tracks[t], tr, data);
+    }
+    /* raw tracks: odd bit lengths, extra syncs in odd places */
+    for (t = 4; t < 8; t++) {
+	int words = 6000 + rnd () % 1000;
+	for (i = 0; i < words + 2; i++)
+	    tracks[t][i] = rnd () % 5 ? (rnd () & 0x5555) | 0x8888 : 0x4489;
+	tracklens[t] = words * 16 - (int)(rnd () % 15);
+    }
+}
+
+static int compare (int line)
+{
+    int i, errors = 0;
+
+#define SAME(x) (!memcmp (&bitloop::x, &fast::x, sizeof fast::x))
+    if (!SAME (disk_sync) || !SAME (word) || !SAME (bitoffset) || !SAME (dma_enable)
+	|| !SAME (disk_hpos) || !SAME (events))
+	errors++;
+    for (i = 0; fast::dma_tab[i] != 0xffffffff || bitloop::dma_tab[i] != 0xffffffff; i++)
+	if (fast::dma_tab[i] != bitloop::dma_tab[i]) {
+	    errors++;
+	    break;
+	}
+    for (i = 0; fast::dskbytr_cycle[i] != 255 || bitloop::dskbytr_cycle[i] != 255; i++)
+	if (fast::dskbytr_cycle[i] != bitloop::dskbytr_cycle[i]
+	    || fast::dskbytr_tab[i] != bitloop::dskbytr_tab[i]) {
+	    errors++;
+	    break;
+	}
+    for (i = 0; fast::wordsync_cycle[i] != 255 || bitloop::wordsync_cycle[i] != 255; i++)
+	if (fast::wordsync_cycle[i] != bitloop::wordsync_cycle[i]) {
+	    errors++;
+	    break;
+	}
+    if (errors)
+	printf ("mismatch at line %d\n", line);
+#undef SAME
+    return errors;
+}
+
+static void start (drive *a, drive *b, int t, int speed)
+{
+    a->bigmfmbuf = b->bigmfmbuf = tracks[t];
+    a->tracklen = b->tracklen = tracklens[t];
+    a->trackspeed = b->trackspeed = speed * tracklens[t] / (2 * 8 * FLOPPY_WRITE_LEN);
+    a->mfmpos = b->mfmpos = rnd () % tracklens[t];
+    a->dskready = b->dskready = 1;
+    bitloop::dma_enable = fast::dma_enable = (adkcon & 0x400) ? 0 : 1;
+    bitloop::word = fast::word = 0;
+    bitloop::bitoffset = fast::bitoffset = 0;
+}
+
+static int check (int lines)
+{
+    static const int speeds[] = { NORMAL_FLOPPY_SPEED, NORMAL_FLOPPY_SPEED / 2, NORMAL_FLOPPY_SPEED / 4 };
+    drive a, b;
+    int line, errors = 0;
+
+    for (line = 0; line < lines && errors < 10; line++) {
+	if (line % 500 == 0) {
+	    dsksync = rnd () % 4 ? 0x4489 : 0x8888 | (rnd () & 0x5555);
+	    adkcon = rnd () & 1 ? 0x400 : 0;
+	    start (&a, &b, rnd () % 8, speeds[rnd () % 3]);
+	}
+	if (rnd () % 2000 == 0)
+	    a.dskready = b.dskready = !a.dskready;
+	bitloop::disk_doupdate_read (&a);
+	fast::disk_doupdate_read (&b);
+	if (a.mfmpos != b.mfmpos)
+	    errors++;
+	errors += compare (line);
+	memset (bitloop::disk_sync, 0, sizeof bitloop::disk_sync);
+	memset (fast::disk_sync, 0, sizeof fast::disk_sync);
+    }
+    return errors;
+}
+
+static double time_lines (void (*read) (drive *), int lines)
+{
+    struct timespec t0, t1;
+    drive d;
+    int i;
+
+    dsksync = 0x4489;
+    adkcon = 0x400;
+    start (&d, &d, 0, NORMAL_FLOPPY_SPEED);
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < lines; i++)
+	read (&d);
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / lines;
+}
+
+int main (int argc, char **argv)
+{
+    int errors, lines = 200000;
+
+    make_tracks (argc, argv);
+    errors = check (lines);
+    printf ("bit-exact check over %d lines (%d sync/index events): %s\n", lines,
+	    fast::events, errors ? "FAILED" : "ok");
+    printf ("AmigaDOS track, normal speed: bit loop %.0f ns/line, fast %.0f ns/line\n",
+	    time_lines (bitloop::disk_doupdate_read, lines),
+	    time_lines (fast::disk_doupdate_read, lines));
+    return errors != 0;
+}
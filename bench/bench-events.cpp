@@ -0,0 +1,178 @@
+/*
+ * Event scheduler micro-benchmark
+ *
+ * Drives events.h with a synthetic but typical event mix: hsync every
+ * line, copper waits inside the line, audio at sample rate, CIA timers
+ * and occasional blits, plus CPU-side register writes that reschedule
+ * CIA/copper between events. Built twice by Makefile.bench, once with
+ * the eventtab scan and once with USE_EVENT_QUEUE; both must print the
+ * same checksum (same events fired at the same cycles, same order).
+ *
+ *   make -f Makefile.bench bench-events
+ *   ./bench-events-scan && ./bench-events-queue
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "events.h"
+
+#define CYCLE_UNIT 512
+#define MAXHPOS 227
+
+unsigned long currcycle, nextevent;
+struct ev eventtab[ev_max];
+#ifdef USE_EVENT_QUEUE
+int event_queue[ev_max];
+int event_queue_pos[ev_max] = { -1, -1, -1, -1, -1, -1 };
+int event_queue_len;
+#endif
+
+static unsigned rnd_state = 0x12345678;
+static unsigned checksum = 0;
+static unsigned fired = 0, schedules = 0;
+
+static unsigned rnd (unsigned n)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state % n;
+}
+
+static void note (int ev)
+{
+    checksum = (checksum ^ (unsigned)(currcycle + ev)) * 16777619u;
+    fired++;
+}
+
+static void set_event (int ev, unsigned long cycles)
+{
+    eventtab[ev].active = 1;
+    eventtab[ev].oldcycles = currcycle;
+    eventtab[ev].evtime = currcycle + cycles * CYCLE_UNIT;
+    event_changed (ev);
+}
+
+static void clear_event (int ev)
+{
+    eventtab[ev].active = 0;
+    event_changed (ev);
+}
+
+static void reschedule (void)
+{
+    schedules++;
+    events_schedule ();
+}
+
+static void hsync (void)
+{
+    note (ev_hsync);
+    eventtab[ev_hsync].evtime += currcycle - eventtab[ev_hsync].oldcycles;
+    eventtab[ev_hsync].oldcycles = currcycle;
+    event_changed (ev_hsync);
+    /* copper restarts on most lines */
+    if (rnd (4))
+	set_event (ev_copper, 8 + rnd (40));
+}
+
+static void copper (void)
+{
+    note (ev_copper);
+    if (rnd (3))
+	set_event (ev_copper, 8 + rnd (60));
+    else
+	clear_event (ev_copper);
+    reschedule ();
+}
+
+static void audio (void)
+{
+    note (ev_audio);
+    set_event (ev_audio, 60 + rnd (40));
+}
+
+static void cia (void)
+{
+    note (ev_cia);
+    set_event (ev_cia, 10 * (50 + rnd (700)));
+    reschedule ();
+}
+
+static void blitter (void)
+{
+    note (ev_blitter);
+    clear_event (ev_blitter);
+}
+
+static void disk (void)
+{
+    note (ev_disk);
+    clear_event (ev_disk);
+}
+
+int main (int argc, char **argv)
+{
+    unsigned long frames = argc > 1 ? strtoul (argv[1], NULL, 0) : 20000;
+    unsigned long total = frames * 313 * MAXHPOS * CYCLE_UNIT;
+    unsigned long done = 0;
+    struct timespec t0, t1;
+    double ns;
+
+    eventtab[ev_hsync].handler = hsync;
+    eventtab[ev_copper].handler = copper;
+    eventtab[ev_audio].handler = audio;
+    eventtab[ev_cia].handler = cia;
+    eventtab[ev_blitter].handler = blitter;
+    eventtab[ev_disk].handler = disk;
+    set_event (ev_hsync, MAXHPOS);
+    set_event (ev_audio, 80);
+    set_event (ev_cia, 700);
+    reschedule ();
+
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    while (done < total) {
+	/* CPU slice up to the next event, as m68k_run does, then the
+	   register writes it made: CIA/blitter/disk restarts. */
+	unsigned long slice = nextevent - currcycle;
+	if (slice > 40 * CYCLE_UNIT)
+	    slice = (1 + rnd (40)) * CYCLE_UNIT;
+	do_cycles (slice);
+	done += slice;
+	switch (rnd (16)) {
+	    case 0:
+		set_event (ev_cia, 10 * (50 + rnd (700)));
+		reschedule ();
+		break;
+	    case 1:
+		if (!eventtab[ev_blitter].active) {
+		    set_event (ev_blitter, 10 + rnd (3000));
+		    reschedule ();
+		}
+		break;
+	    case 2:
+		if (!rnd (8)) {
+		    set_event (ev_disk, rnd (MAXHPOS));
+		    reschedule ();
+		}
+		break;
+	    case 3:
+		clear_event (ev_copper);
+		reschedule ();
+		break;
+	}
+    }
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+
+#ifdef USE_EVENT_QUEUE
+    printf ("queue: ");
+#else
+    printf ("scan:  ");
+#endif
+    printf ("%lu frames, %u events, %u schedules, %.1f ns/event, checksum %08x\n",
+	    frames, fired, schedules, ns / fired, checksum);
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * linetoscr micro-benchmark
+ *
+ * Renders a 320x256 frame of random pixel indexes through the four
+ * linetoscr.h/linetoscr2.h instantiations used by drawing.cpp (lores,
+ * hires downscaled, and both in dual playfield) and through the plain
+ * one-store-per-pixel loop they replace. Outputs must match, including
+ * spans with odd start/stop positions.
+ *
+ *   make -f Makefile.bench bench-linetoscr
+ *   ./bench-linetoscr
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef unsigned char uae_u8;
+typedef unsigned short uae_u16;
+typedef unsigned int uae_u32;
+#define uae_u64 unsigned long long
+typedef long int xcolnr;
+
+#define WIDTH 320
+#define HEIGHT 256
+#define SRC_PIXELS (WIDTH * 2 + 16)
+
+static struct { xcolnr acolors[256]; } colors_for_drawing;
+#define DRAWING_ACOLORS colors_for_drawing.acolors
+static union { long align; uae_u8 apixels[SRC_PIXELS]; } pixdata;
+static int dblpf_ind1[256], dblpf_ind2[256];
+static int bpldualpfpri;
+static char *xlinebuffer;
+static int src_pixel;
+
+#define LNAME linetoscr_lores
+#define SRC_INC 1
+#include "../src/linetoscr.h"
+#define LNAME linetoscr_hires
+#define SRC_INC 2
+#include "../src/linetoscr.h"
+#define LNAME linetoscr_lores_dual
+#define SRC_INC 1
+#include "../src/linetoscr2.h"
+#define LNAME linetoscr_hires_dual
+#define SRC_INC 2
+#include "../src/linetoscr2.h"
+
+/* The per-pixel loop linetoscr.h used before */
+#define REF_LINETOSCR(NAME, INC, DUAL) \
+static void NAME (int dpix, int stoppos) \
+{ \
+    unsigned short *buf = (unsigned short *)xlinebuffer; \
+    int *lookup = bpldualpfpri ? dblpf_ind2 : dblpf_ind1; \
+    int spix = src_pixel; \
+    while (dpix < stoppos) { \
+	int c = pixdata.apixels[spix]; \
+	buf[dpix++] = colors_for_drawing.acolors[DUAL ? lookup[c] : c]; \
+	spix += INC; \
+    } \
+    src_pixel = spix; \
+}
+REF_LINETOSCR (ref_lores, 1, 0)
+REF_LINETOSCR (ref_hires, 2, 0)
+REF_LINETOSCR (ref_lores_dual, 1, 1)
+REF_LINETOSCR (ref_hires_dual, 2, 1)
+
+typedef void (*linetoscr_func)(int, int);
+
+static const struct {
+    const char *name;
+    linetoscr_func f, ref;
+} modes[] = {
+    { "lores", linetoscr_lores, ref_lores },
+    { "hires", linetoscr_hires, ref_hires },
+    { "lores dual", linetoscr_lores_dual, ref_lores_dual },
+    { "hires dual", linetoscr_hires_dual, ref_hires_dual },
+};
+
+static uae_u16 frame_a[HEIGHT][WIDTH + 8] __attribute__ ((aligned (16)));
+static uae_u16 frame_b[HEIGHT][WIDTH + 8] __attribute__ ((aligned (16)));
+
+static unsigned rnd_state = 0x1d872b41;
+
+static unsigned rnd (void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static double now_ns (void)
+{
+    struct timespec t;
+    clock_gettime (CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static int check (int m)
+{
+    int y, round, errors = 0;
+    for (round = 0; round < 50; round++)
+	for (y = 0; y < HEIGHT; y++) {
+	    int start = rnd () % 16, stop = WIDTH - rnd () % 16, src = rnd () % 8;
+	    int end_a, end_b;
+	    bpldualpfpri = rnd () & 1;
+	    xlinebuffer = (char *)frame_a[y];
+	    src_pixel = src;
+	    modes[m].f (start, stop);
+	    end_a = src_pixel;
+	    xlinebuffer = (char *)frame_b[y];
+	    src_pixel = src;
+	    modes[m].ref (start, stop);
+	    end_b = src_pixel;
+	    if (end_a != end_b || memcmp (frame_a[y], frame_b[y], sizeof frame_a[y])) {
+		printf ("%s mismatch: line %d span %d-%d\n", modes[m].name, y, start, stop);
+		errors++;
+	    }
+	}
+    return errors;
+}
+
+int main (int argc, char **argv)
+{
+    int frames = argc > 1 ? atoi (argv[1]) : 2000;
+    int i, m, y, errors = 0;
+
+    for (i = 0; i < 256; i++) {
+	colors_for_drawing.acolors[i] = rnd () & 0xffff;
+	dblpf_ind1[i] = rnd () & 0xff;
+	dblpf_ind2[i] = rnd () & 0xff;
+    }
+    for (i = 0; i < SRC_PIXELS; i++)
+	pixdata.apixels[i] = rnd ();
+
+    for (m = 0; m < 4; m++)
+	errors += check (m);
+    printf ("output check: %s\n", errors ? "FAILED" : "ok");
+
+    for (m = 0; m < 4; m++) {
+	double t0, t1, t2;
+	int f;
+	t0 = now_ns ();
+	for (f = 0; f < frames; f++)
+	    for (y = 0; y < HEIGHT; y++) {
+		xlinebuffer = (char *)frame_b[y];
+		src_pixel = 0;
+		modes[m].ref (0, WIDTH);
+	    }
+	t1 = now_ns ();
+	for (f = 0; f < frames; f++)
+	    for (y = 0; y < HEIGHT; y++) {
+		xlinebuffer = (char *)frame_a[y];
+		src_pixel = 0;
+		modes[m].f (0, WIDTH);
+	    }
+	t2 = now_ns ();
+	printf ("%-10s 320x256: per-pixel %.1f us/frame, word stores %.1f us/frame\n",
+		modes[m].name, (t1 - t0) / frames / 1000, (t2 - t1) / frames / 1000);
+    }
+    return errors != 0;
+}
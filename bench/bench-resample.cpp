@@ -0,0 +1,122 @@
+/*
+ * Output resampler micro-benchmark
+ *
+ * Feeds audio_resample.h blocks the way flush_audio() does: a frame's
+ * worth of interleaved stereo words whose length wanders around the
+ * 882 frames a 44100 Hz / 50 Hz frame needs, resampled to exactly 882.
+ * Checks the output length, DC gain, and that a 1 kHz tone comes out
+ * as a clean 1 kHz tone with no block-edge clicks (error against the
+ * ideal sine at the output times), then times one frame.
+ *
+ *   make -f Makefile.bench bench-resample
+ *   ./bench-resample
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+typedef unsigned short uae_u16;
+
+#include "audio_resample.h"
+
+#define RATE 44100
+#define TARGET (RATE / 50)
+#define TONE 1000.0
+
+static struct audio_resample r;
+static uae_u16 in[RESAMPLE_MAX_IN * 2], out[RESAMPLE_MAX_IN * 2];
+
+static unsigned rnd_state = 0x6b43a9b5;
+
+static unsigned rnd (void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* Paula-side block length for a frame: within +-3% of TARGET */
+static int block_len (void)
+{
+    return TARGET - TARGET * 3 / 100 + rnd () % (TARGET * 6 / 100);
+}
+
+static int check_dc (void)
+{
+    int f, i, errors = 0;
+
+    audio_resample_init (&r);
+    for (f = 0; f < 20; f++) {
+	int n = block_len ();
+	for (i = 0; i < n * 2; i++)
+	    in[i] = (uae_u16)-12000;
+	if (audio_resample_block (&r, in, n, out, TARGET) != TARGET)
+	    errors++;
+	/* after the filter has filled */
+	for (i = 0; f > 0 && i < TARGET * 2; i++)
+	    if ((short)out[i] < -12001 || (short)out[i] > -11999) {
+		printf ("DC mismatch: frame %d sample %d: %d\n", f, i / 2, (short)out[i]);
+		errors++;
+		break;
+	    }
+    }
+    return errors;
+}
+
+/* Returns the tone's signal to error ratio in dB */
+static double check_tone (void)
+{
+    double t_in = 0, t_out = 0, sig = 0, err = 0;
+    int f, i;
+
+    audio_resample_init (&r);
+    for (f = 0; f < 200; f++) {
+	int n = block_len ();
+	/* this block spans 1/50 s, so its input rate is n * 50 */
+	double dt_in = 1.0 / (n * 50.0), dt_out = 1.0 / (TARGET * 50.0);
+	for (i = 0; i < n; i++)
+	    in[i * 2] = in[i * 2 + 1] = (uae_u16)(short)floor (16000 * sin (2 * M_PI * TONE * (t_in + i * dt_in)) + 0.5);
+	audio_resample_block (&r, in, n, out, TARGET);
+	if (f >= 4)
+	    for (i = 0; i < TARGET; i++) {
+		/* output lags the input by RESAMPLE_TAPS/2 + 1 samples */
+		double t = t_out + i * dt_out - (RESAMPLE_TAPS / 2 + 1) * dt_in;
+		double ideal = 16000 * sin (2 * M_PI * TONE * t);
+		double e = (short)out[i * 2] - ideal;
+		sig += ideal * ideal;
+		err += e * e;
+	    }
+	t_in += n * dt_in;
+	t_out += TARGET * dt_out;
+    }
+    return 10 * log10 (sig / err);
+}
+
+int main (int argc, char **argv)
+{
+    int frames = argc > 1 ? atoi (argv[1]) : 20000;
+    int errors = check_dc (), f, i;
+    double snr = check_tone (), ns;
+    struct timespec t0, t1;
+
+    printf ("length/DC check: %s\n", errors ? "FAILED" : "ok");
+    printf ("1 kHz tone through +-3%% rate changes: %.1f dB signal to error\n", snr);
+    if (snr < 40)
+	errors++;
+
+    for (i = 0; i < RESAMPLE_MAX_IN * 2; i++)
+	in[i] = rnd ();
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    for (f = 0; f < frames; f++) {
+	audio_resample_block (&r, in, block_len (), out, TARGET);
+	__asm__ __volatile__ ("" : : "r" (out) : "memory");
+    }
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    printf ("%d frames/frame at %d Hz: %.1f us/frame\n", TARGET, RATE, ns / frames / 1000);
+    return errors != 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Disk write-back micro-benchmark
+ *
+ * Writes random runs into a copy of a disk image, marking them the way
+ * uae4all_fwrite() does, and checks that savedisk_get_changes_dirty()
+ * builds the same patch as the full-image savedisk_get_changes(),
+ * including runs written back with the original bytes. Then times one
+ * write-back check of each kind: image checksum plus full diff versus
+ * the dirty-slot patch plus its checksum.
+ *
+ * The patch is also packed in SAVEDISK_SLICE steps as the write-behind
+ * path does, written and read back in the .ads layout, uncompressed and
+ * applied to the original image with savedisk_apply_changes(); the
+ * result must equal the written image.
+ *
+ *   make -f Makefile.bench bench-savedisk
+ *   ./bench-savedisk
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define USE_SAVEDISK_DIRTY
+#define USE_SAVEDISK_ASYNC
+#include "../src/savedisk.cpp"
+
+#define MAX_DISK_LEN 1024*(1024-128)
+
+static unsigned char orig[MAX_DISK_LEN], mem[MAX_DISK_LEN];
+static unsigned patch_a[MAX_DISK_LEN / 4 + 1024], patch_b[MAX_DISK_LEN / 4 + 1024];
+static unsigned dirty[SAVEDISK_DIRTY_WORDS(MAX_DISK_LEN)];
+
+#define MAX_COMP_SIZE (1024*128)
+#define SAVEDISK_SLICE (16*1024)
+
+static unsigned char restored[MAX_DISK_LEN];
+
+static int roundtrip (unsigned size)
+{
+    savedisk_packer p;
+    static unsigned char bc[MAX_COMP_SIZE];
+    unsigned long n = 0, sizeuncompressed = MAX_DISK_LEN;
+    int ret;
+    FILE *f = tmpfile ();
+
+    if (!f || !savedisk_pack_start (&p, patch_b, size, MAX_COMP_SIZE))
+	return 1;
+    while (!(ret = savedisk_pack_step (&p, SAVEDISK_SLICE)));
+    if (ret > 0) {
+	fwrite ((void *)&p.out_size, 1, 4, f);
+	fwrite (p.out, 1, p.out_size, f);
+    }
+    savedisk_pack_free (&p);
+    if (ret < 0)
+	return 1;
+
+    rewind (f);
+    if (fread ((void *)&n, 1, 4, f) != 4 || fread (bc, 1, n, f) != n)
+	return 1;
+    fclose (f);
+    memcpy (restored, orig, MAX_DISK_LEN);
+    if (uncompress ((Bytef *)patch_a, &sizeuncompressed, (const Bytef *)bc, n) != Z_OK
+	|| sizeuncompressed != size)
+	return 1;
+    savedisk_apply_changes (restored, patch_a, sizeuncompressed);
+    return memcmp (restored, mem, MAX_DISK_LEN) != 0;
+}
+
+static unsigned rnd_state = 0x9e3779b9;
+
+static unsigned rnd (void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* A track's worth of sectors or a single byte run, like drive_write_adf_amigados */
+static void write_run (void)
+{
+    unsigned len = rnd () % 4 ? 512 * (1 + rnd () % 11) : 1 + rnd () % 700;
+    unsigned pos = rnd () % (MAX_DISK_LEN - len);
+    unsigned i;
+
+    if (rnd () % 5 == 0)
+	memcpy (mem + pos, orig + pos, len);
+    else
+	for (i = 0; i < len; i++)
+	    mem[pos + i] = rnd () & 0x13;
+    savedisk_mark_dirty (dirty, pos, len);
+}
+
+static double ns_since (struct timespec *t0)
+{
+    struct timespec t1;
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) * 1e9 + (t1.tv_nsec - t0->tv_nsec);
+}
+
+int main (int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi (argv[1]) : 50;
+    int r, w, errors = 0;
+    unsigned i, a = 0, b = 0, crc = 0;
+    struct timespec t0;
+    double full, slots;
+
+    for (i = 0; i < MAX_DISK_LEN; i++)
+	orig[i] = rnd ();
+    for (r = 0; r < 20; r++) {
+	memcpy (mem, orig, MAX_DISK_LEN);
+	memset (dirty, 0, sizeof dirty);
+	for (w = 0; w < r * 3; w++) {
+	    write_run ();
+	    a = savedisk_get_changes (mem, MAX_DISK_LEN, patch_a, orig);
+	    b = savedisk_get_changes_dirty (mem, MAX_DISK_LEN, patch_b, orig, dirty);
+	    if (a != b || memcmp (patch_a, patch_b, a)) {
+		printf ("patch mismatch: round %d write %d (%u/%u bytes)\n", r, w, a, b);
+		errors++;
+	    }
+	}
+	if (b && roundtrip (b)) {
+	    printf ("round trip failed: round %d (%u byte patch)\n", r, b);
+	    errors++;
+	}
+    }
+    printf ("patch and .ads round trip check: %s\n", errors ? "FAILED" : "ok");
+
+    /* a game that wrote one track */
+    memcpy (mem, orig, MAX_DISK_LEN);
+    memset (dirty, 0, sizeof dirty);
+    memset (mem + 40 * 5632, 0x55, 5632);
+    savedisk_mark_dirty (dirty, 40 * 5632, 5632);
+
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    for (r = 0; r < rounds; r++) {
+	crc += savedisk_get_checksum (mem, MAX_DISK_LEN);
+	a = savedisk_get_changes (mem, MAX_DISK_LEN, patch_a, orig);
+    }
+    full = ns_since (&t0) / rounds;
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    for (r = 0; r < rounds; r++) {
+	b = savedisk_get_changes_dirty (mem, MAX_DISK_LEN, patch_b, orig, dirty);
+	crc += savedisk_get_checksum (patch_b, b);
+    }
+    slots = ns_since (&t0) / rounds;
+    printf ("one dirty track: checksum+full diff %.0f us, dirty slots %.1f us (%u byte patch, %08x)\n",
+	    full / 1000, slots / 1000, b, crc);
+    return errors != 0;
+}
@@ -0,0 +1,236 @@
+/*
+ * Sprite compositing micro-benchmark
+ *
+ * Puts random sprite entries (spixels/spixstate as record_sprite()
+ * leaves them, attached pairs included) over random playfield pixels,
+ * once through draw_sprites_1() from drawing.cpp and once through
+ * sprite_composite() from sprite_merge.h, for both resolutions, single
+ * and dual playfield and every playfield priority. The apixels must
+ * come out bit-exact. Then both are timed on lines with
+ * eight 16 pixel sprites.
+ *
+ *   make -f Makefile.bench bench-sprites
+ *   ./bench-sprites
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef unsigned char uae_u8;
+typedef unsigned short uae_u16;
+typedef unsigned int uae_u32;
+
+#include "sprite_merge.h"
+
+#define LINE_PIXELS 1024
+#define ENTRY_MAX 448
+
+static union { uae_u8 apixels[LINE_PIXELS]; uae_u16 apixels_w[LINE_PIXELS / 2]; } pix_a, pix_b, pix_pf;
+static uae_u16 spixels[ENTRY_MAX];
+static uae_u8 spixstate[ENTRY_MAX];
+static int dblpf_ms[256], dblpf_ms1[256], dblpf_ms2[256], sprite_offs[256];
+static uae_u32 plf_sprite_mask;
+
+static unsigned rnd_state = 0x2545f491;
+
+static unsigned rnd (void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static double now_ns (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* gen_pfield_tables() */
+static void init_tables (void)
+{
+    int i;
+    for (i = 0; i < 256; i++) {
+	int plane1 = (i & 1) | ((i >> 1) & 2) | ((i >> 2) & 4) | ((i >> 3) & 8);
+	int plane2 = ((i >> 1) & 1) | ((i >> 2) & 2) | ((i >> 3) & 4) | ((i >> 4) & 8);
+	dblpf_ms1[i] = plane1 == 0 ? (plane2 == 0 ? 16 : 8) : 0;
+	dblpf_ms2[i] = plane2 == 0 ? (plane1 == 0 ? 16 : 0) : 8;
+	dblpf_ms[i] = i == 0 ? 16 : 8;
+	sprite_offs[i] = (i & 15) ? 0 : 2;
+    }
+    sprite_merge_init ();
+}
+
+/* draw_sprites_1() from drawing.cpp, with the entry as arguments */
+static void draw_sprites_ref (uae_u8 *apixels, int window_pos, int n, int *shift_lookup,
+			      int dualpf, int doubling, int has_attach)
+{
+    uae_u16 *apixels_w = (uae_u16 *)apixels;
+    int pos;
+
+    for (pos = 0; pos < n; pos += 1) {
+	int maskshift, plfmask;
+	unsigned int v = spixels[pos];
+
+	maskshift = shift_lookup[apixels[window_pos]];
+	plfmask = (plf_sprite_mask >> maskshift) >> maskshift;
+	v &= ~plfmask;
+	if (v != 0) {
+	    unsigned int vlo, vhi, col;
+	    unsigned int v1 = v & 255;
+	    int offs;
+	    if (v1 == 0)
+		offs = 4 + sprite_offs[v >> 8];
+	    else
+		offs = sprite_offs[v1];
+
+	    v >>= offs << 1;
+	    v &= 15;
+
+	    if (has_attach && (spixstate[pos] & (1 << offs))) {
+		col = v;
+		col += 16;
+	    } else {
+		vlo = v & 3;
+		vhi = (v & (vlo - 1)) >> 2;
+		col = (vlo | vhi);
+		col += 16;
+		col += (offs << 1);
+	    }
+	    if (dualpf)
+		col += 128;
+	    if (doubling)
+		apixels_w[window_pos >> 1] = col | (col << 8);
+	    else
+		apixels[window_pos] = col;
+	}
+	window_pos += 1 << doubling;
+    }
+}
+
+static void draw_sprites_composite (uae_u8 *apixels, int window_pos, int n, int *shift_lookup,
+				    int dualpf, int doubling, int has_attach)
+{
+    sprite_merge_set_front (shift_lookup, plf_sprite_mask);
+    sprite_composite (apixels, window_pos, spixels, spixstate, n, has_attach, dualpf ? 128 : 0, doubling);
+}
+
+/* Sprites 0-7 at random places of an n pixel entry, as record_sprite() */
+static void make_entry (int n, int nr_sprites, int attach)
+{
+    int s, i;
+
+    memset (spixels, 0, sizeof spixels);
+    memset (spixstate, 0, sizeof spixstate);
+    for (s = 0; s < nr_sprites; s++) {
+	int num = rnd () & 7, x = rnd () % n;
+	int attached = attach && (num & 1) && (rnd () & 1);
+	for (i = x; i < x + 16 && i < n; i++) {
+	    spixels[i] |= (rnd () & 3) << (2 * num);
+	    if (attached)
+		spixstate[i] |= 1 << (num - 1);
+	}
+    }
+}
+
+/* pfield_expand_dp_bplcon() */
+static void set_priorities (void)
+{
+    int plf1pri = rnd () & 7, plf2pri = rnd () & 7;
+
+    plf_sprite_mask = 0xFFFF0000 << (4 * plf2pri);
+    plf_sprite_mask |= (0xFFFF << (4 * plf1pri)) & 0xFFFF;
+}
+
+static void make_playfield (int sparse)
+{
+    int i;
+    for (i = 0; i < LINE_PIXELS; i++)
+	pix_pf.apixels[i] = (sparse && (rnd () & 1)) ? 0 : rnd () & 63;
+}
+
+static int check (void)
+{
+    int round, errors = 0;
+
+    for (round = 0; round < 200000; round++) {
+	int dualpf = rnd () & 1, doubling = rnd () & 1, attach = rnd () & 1;
+	int *shift_lookup = dualpf ? ((rnd () & 1) ? dblpf_ms2 : dblpf_ms1) : dblpf_ms;
+	int n = 1 + rnd () % ENTRY_MAX;
+	int window_pos = rnd () % (LINE_PIXELS - (ENTRY_MAX << 1) - 2);
+
+	if (!(round & 255))
+	    make_playfield (round & 256);
+	make_entry (n, rnd () % 12, attach);
+	set_priorities ();
+	memcpy (&pix_a, &pix_pf, sizeof pix_pf);
+	memcpy (&pix_b, &pix_pf, sizeof pix_pf);
+	draw_sprites_ref (pix_a.apixels, window_pos, n, shift_lookup, dualpf, doubling, attach);
+	draw_sprites_composite (pix_b.apixels, window_pos, n, shift_lookup, dualpf, doubling, attach);
+	if (memcmp (&pix_a, &pix_b, sizeof pix_a)) {
+	    if (errors++ < 10)
+		printf ("mismatch: round %d, %s %s%s, %d pixels at %d\n", round,
+			dualpf ? "dual" : "single", doubling ? "hires" : "lores",
+			attach ? " attached" : "", n, window_pos);
+	}
+    }
+    return errors;
+}
+
+int main (int argc, char **argv)
+{
+    int lines = argc > 1 ? atoi (argv[1]) : 200000;
+    int mode, errors;
+
+    init_tables ();
+    errors = check ();
+    printf ("output check: %s\n", errors ? "FAILED" : "ok");
+
+    make_playfield (1);
+    for (mode = 0; mode < 4; mode++) {
+	int dualpf = mode & 1, doubling = mode >> 1;
+	int *shift_lookup = dualpf ? dblpf_ms1 : dblpf_ms;
+	double t0, t1, t2, ref, merge;
+	int l, rep;
+
+	/* eight sprites side by side, two of them attached */
+	memset (spixels, 0, sizeof spixels);
+	memset (spixstate, 0, sizeof spixstate);
+	for (l = 0; l < 8 * 16; l++) {
+	    int num = (l >> 4) & 7;
+	    spixels[l] = (rnd () & 3) << (2 * num);
+	    if (num == 1 || num == 5)
+		spixstate[l] = 1 << (num - 1);
+	}
+	plf_sprite_mask = 0xFFFF0000 << 8;
+	plf_sprite_mask |= (0xFFFF << 8) & 0xFFFF;
+
+	/* best of five, the host is not quiet */
+	ref = merge = 1e30;
+	for (rep = 0; rep < 5; rep++) {
+	    t0 = now_ns ();
+	    for (l = 0; l < lines; l++) {
+		memcpy (&pix_a, &pix_pf, 320 << doubling);
+		draw_sprites_ref (pix_a.apixels, 64, 8 * 16, shift_lookup, dualpf, doubling, 1);
+	    }
+	    t1 = now_ns ();
+	    for (l = 0; l < lines; l++) {
+		memcpy (&pix_b, &pix_pf, 320 << doubling);
+		draw_sprites_composite (pix_b.apixels, 64, 8 * 16, shift_lookup, dualpf, doubling, 1);
+	    }
+	    t2 = now_ns ();
+	    if (t1 - t0 < ref)
+		ref = t1 - t0;
+	    if (t2 - t1 < merge)
+		merge = t2 - t1;
+	}
+	printf ("%-6s %-5s 8 sprites: draw_sprites_1 %.1f ns/line, sprite_composite %.1f ns/line\n",
+		dualpf ? "dual" : "single", doubling ? "hires" : "lores",
+		ref / lines, merge / lines);
+    }
+    return errors != 0;
+}
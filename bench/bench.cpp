@@ -0,0 +1,468 @@
+/*
+ * UAE4ALL headless benchmark harness
+ *
+ * Minimal libretro frontend: loads the core, replays a recorded input
+ * script through the input callbacks and runs N frames of retro_run().
+ * For every frame it reports wall time, 68k cycles executed and hashes
+ * of the gfx_mem framebuffer and the audio produced, so two builds can
+ * be compared for speed (fps) and for bit-exact output (final hash).
+ *
+ * Usage:
+ *   uae4all_bench [-k kick.rom | -s sysdir] [-n frames] [-f frameskip]
+ *                 [-i input.txt] [-o frames.csv] disk.adf
+ *
+ *   -k  Kickstart image (linked as kick13.rom into a temporary system dir)
+ *   -s  system directory already containing kick13.rom
+ *   -n  frames to run after the core's own warmup (default 1000)
+ *   -f  fixed frameskip (default 0, every frame drawn). Auto frameskip
+ *       depends on wall time and is never used here.
+ *   -i  input script, see below
+ *   -o  per-frame CSV: frame,usec,cycles,gfx_hash,audio_hash,samples
+ *   -p  profiler output prefix, writes <prefix>.csv and <prefix>.json
+ *       (only with make -f Makefile.bench PROFILER=1)
+ *   -b  blitter trace file for bench/blit-replay.cpp (only in builds
+ *       with USE_BLIT_TRACE, which also print the blitter histograms)
+ *   -r  0 draws frames serially, 1 (default) on the render thread (only
+ *       in builds with USE_RENDER_THREAD); gfx hashes must not differ
+ *
+ * Input script, one event per line, '#' starts a comment, state holds
+ * until changed, frame numbers must not decrease:
+ *   <frame> <port> <button> <0|1>   button: UP DOWN LEFT RIGHT A B X Y
+ *                                   L R L2 R2 L3 R3 SELECT START
+ *   <frame> key <retrok> <0|1>      retrok: numeric RETROK_* code
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "libretro.h"
+#include "debug_uae4all.h"
+
+extern char *gfx_mem;
+extern unsigned gfx_rowbytes;
+extern int GFXVIDINFO_HEIGHT_VAR;
+extern int prefs_gfx_framerate, changed_gfx_framerate;
+extern int sf2000_frameskip;
+unsigned m68k_get_cycles_counter(void);	/* famec.cpp, C++ linkage */
+#ifdef USE_DISK_TRACK_CACHE
+extern unsigned disk_cache_hits, disk_cache_misses;
+#endif
+#ifdef USE_BLIT_TRACE
+extern int blit_trace_start(const char *filename);	/* blittrace.h */
+extern void blit_trace_stop(void);
+extern void blit_trace_show(void);
+#endif
+#ifdef USE_CPU_IDLE_SKIP
+extern void m68k_idle_show(void);	/* m68k_intrf.h */
+#endif
+#ifdef FAME_PREDECODE
+extern void m68k_predecode_show(void);	/* m68k_intrf.h */
+#endif
+#ifdef USE_MIPS_DYNAREC
+extern void m68k_dynarec_show(void);	/* m68k_intrf.h */
+#endif
+#ifdef USE_RENDER_THREAD
+extern int render_thread_enabled;	/* drawing.h */
+#endif
+
+/* SF2000 firmware file API, used by core-mapper.cpp and savestate.cpp */
+
+#define FS_O_WRONLY 0x0001
+#define FS_O_RDWR   0x0002
+#define FS_O_CREAT  0x0100
+#define FS_O_TRUNC  0x0200
+
+extern "C" int fs_open(const char *path, int flags, int perms)
+{
+	int f = O_RDONLY;
+	if (flags & FS_O_WRONLY) f = O_WRONLY;
+	if (flags & FS_O_RDWR)   f = O_RDWR;
+	if (flags & FS_O_CREAT)  f |= O_CREAT;
+	if (flags & FS_O_TRUNC)  f |= O_TRUNC;
+	return open(path, f, perms);
+}
+
+extern "C" ssize_t fs_read(int fd, void *buf, size_t count)  { return read(fd, buf, count); }
+extern "C" ssize_t fs_write(int fd, const void *buf, size_t count) { return write(fd, buf, count); }
+extern "C" int fs_close(int fd) { return close(fd); }
+extern "C" int fs_sync(const char *path) { return 0; }
+extern "C" int fs_mkdir(const char *path, int mode) { return mkdir(path, mode); }
+extern "C" int64_t fs_lseek(int fd, int64_t offset, int whence) { return lseek(fd, (off_t)offset, whence); }
+
+/* 64-bit FNV-1a */
+
+#define HASH_INIT 0xcbf29ce484222325ULL
+
+static uint64_t hash_bytes(uint64_t h, const void *data, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	while (len--)
+	{
+		h ^= *p++;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+/* Recorded input */
+
+struct bench_event {
+	unsigned frame;
+	int device;	/* RETRO_DEVICE_JOYPAD or RETRO_DEVICE_KEYBOARD */
+	unsigned port, id;
+	int value;
+};
+
+static struct bench_event *events;
+static unsigned num_events, next_event;
+
+static int16_t joy_state[2][16];
+static int16_t key_state[RETROK_LAST];
+
+static const char *const joy_names[16] = {
+	"B", "Y", "SELECT", "START", "UP", "DOWN", "LEFT", "RIGHT",
+	"A", "X", "L", "R", "L2", "R2", "L3", "R3"
+};
+
+static int load_input(const char *name)
+{
+	FILE *f = fopen(name, "r");
+	char line[256], what[32], button[32];
+	unsigned cap = 0, lineno = 0, last_frame = 0;
+
+	if (!f)
+	{
+		fprintf(stderr, "bench: can't open input script %s\n", name);
+		return 0;
+	}
+	while (fgets(line, sizeof(line), f))
+	{
+		struct bench_event ev;
+		char *c = strchr(line, '#');
+		int i;
+
+		lineno++;
+		if (c) *c = 0;
+		if (sscanf(line, "%u %31s %31s %d", &ev.frame, what, button, &ev.value) != 4)
+			continue;
+		if (ev.frame < last_frame)
+		{
+			fprintf(stderr, "bench: %s:%u: frame numbers must not decrease\n", name, lineno);
+			fclose(f);
+			return 0;
+		}
+		last_frame = ev.frame;
+		if (!strcmp(what, "key"))
+		{
+			ev.device = RETRO_DEVICE_KEYBOARD;
+			ev.port = 0;
+			ev.id = atoi(button);
+			if (ev.id >= RETROK_LAST)
+				goto bad;
+		}
+		else
+		{
+			ev.device = RETRO_DEVICE_JOYPAD;
+			ev.port = atoi(what);
+			for (i = 0; i < 16; i++)
+				if (!strcmp(button, joy_names[i]))
+					break;
+			if (ev.port > 1 || i == 16)
+				goto bad;
+			ev.id = i;
+		}
+		if (num_events == cap)
+		{
+			cap = cap ? cap * 2 : 64;
+			events = (struct bench_event *)realloc(events, cap * sizeof(*events));
+		}
+		events[num_events++] = ev;
+		continue;
+bad:
+		fprintf(stderr, "bench: %s:%u: bad event\n", name, lineno);
+		fclose(f);
+		return 0;
+	}
+	fclose(f);
+	return 1;
+}
+
+static void apply_input(unsigned frame)
+{
+	while (next_event < num_events && events[next_event].frame <= frame)
+	{
+		struct bench_event *ev = &events[next_event++];
+		if (ev->device == RETRO_DEVICE_KEYBOARD)
+			key_state[ev->id] = ev->value;
+		else
+			joy_state[ev->port][ev->id] = ev->value;
+	}
+}
+
+/* libretro frontend callbacks */
+
+static const char *system_dir = ".";
+static uint64_t frame_gfx_hash, frame_audio_hash;
+static unsigned frame_samples;
+
+static bool bench_environment(unsigned cmd, void *data)
+{
+	switch (cmd)
+	{
+		case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+		case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+			*(const char **)data = system_dir;
+			return true;
+		case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+			return *(enum retro_pixel_format *)data == RETRO_PIXEL_FORMAT_RGB565;
+		case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+		case RETRO_ENVIRONMENT_SET_VARIABLES:
+		case RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS:
+		case RETRO_ENVIRONMENT_SET_SERIALIZATION_QUIRKS:
+		case RETRO_ENVIRONMENT_SET_MESSAGE:
+		case RETRO_ENVIRONMENT_SET_MESSAGE_EXT:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static void bench_video(const void *data, unsigned width, unsigned height, size_t pitch)
+{
+	/* The frame sent to the frontend depends on overlays and Y-stretch;
+	   the emulated picture itself is gfx_mem, which is what we hash. */
+	if (gfx_mem)
+		frame_gfx_hash = hash_bytes(HASH_INIT, gfx_mem, gfx_rowbytes * GFXVIDINFO_HEIGHT_VAR);
+}
+
+static void bench_audio(int16_t left, int16_t right)
+{
+	int16_t s[2] = { left, right };
+	frame_audio_hash = hash_bytes(frame_audio_hash, s, sizeof(s));
+	frame_samples++;
+}
+
+static size_t bench_audio_batch(const int16_t *data, size_t frames)
+{
+	frame_audio_hash = hash_bytes(frame_audio_hash, data, frames * 2 * sizeof(int16_t));
+	frame_samples += frames;
+	return frames;
+}
+
+static void bench_input_poll(void)
+{
+}
+
+static int16_t bench_input_state(unsigned port, unsigned device, unsigned index, unsigned id)
+{
+	switch (device)
+	{
+		case RETRO_DEVICE_JOYPAD:
+			return (port < 2 && id < 16) ? joy_state[port][id] : 0;
+		case RETRO_DEVICE_KEYBOARD:
+			return id < RETROK_LAST ? key_state[id] : 0;
+		default:
+			return 0;
+	}
+}
+
+static uint64_t now_usec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: uae4all_bench [-k kick.rom | -s sysdir] [-n frames] [-f frameskip]\n"
+	                "                     [-i input.txt] [-o frames.csv] [-p prefix]\n"
+	                "                     [-b blits.trace] [-r 0|1] disk.adf\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	const char *kick = NULL, *input = NULL, *csv_name = NULL, *prof_name = NULL;
+	const char *blit_trace_name = NULL;
+	unsigned frames = 1000, frame;
+	int frameskip = 0, opt;
+	char tmpdir[] = "/tmp/uae4all_bench.XXXXXX";
+	char kick_link[sizeof(tmpdir) + 16];
+	struct retro_game_info info;
+	FILE *csv = NULL;
+	uint64_t t0, total_usec = 0, min_usec = ~0ULL, max_usec = 0, run_hash = HASH_INIT;
+	uint64_t total_cycles = 0;
+
+	while ((opt = getopt(argc, argv, "k:s:n:f:i:o:p:b:r:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'k': kick = optarg; break;
+			case 's': system_dir = optarg; break;
+			case 'n': frames = strtoul(optarg, NULL, 0); break;
+			case 'f': frameskip = atoi(optarg); break;
+			case 'i': input = optarg; break;
+			case 'o': csv_name = optarg; break;
+			case 'p': prof_name = optarg; break;
+			case 'b': blit_trace_name = optarg; break;
+#ifdef USE_RENDER_THREAD
+			case 'r': render_thread_enabled = atoi(optarg); break;
+#endif
+			default: usage();
+		}
+	}
+	if (optind != argc - 1)
+		usage();
+
+	if (kick)
+	{
+		char *abs_kick = realpath(kick, NULL);
+		if (!abs_kick || !mkdtemp(tmpdir))
+		{
+			fprintf(stderr, "bench: can't use kickstart %s\n", kick);
+			return 1;
+		}
+		snprintf(kick_link, sizeof(kick_link), "%s/kick13.rom", tmpdir);
+		if (symlink(abs_kick, kick_link))
+		{
+			fprintf(stderr, "bench: can't link %s\n", kick_link);
+			return 1;
+		}
+		free(abs_kick);
+		system_dir = tmpdir;
+	}
+	if (input && !load_input(input))
+		return 1;
+	if (csv_name)
+	{
+		if (!(csv = fopen(csv_name, "w")))
+		{
+			fprintf(stderr, "bench: can't create %s\n", csv_name);
+			return 1;
+		}
+		fprintf(csv, "frame,usec,cycles,gfx_hash,audio_hash,samples\n");
+	}
+
+	retro_set_environment(bench_environment);
+	retro_set_video_refresh(bench_video);
+	retro_set_audio_sample(bench_audio);
+	retro_set_audio_sample_batch(bench_audio_batch);
+	retro_set_input_poll(bench_input_poll);
+	retro_set_input_state(bench_input_state);
+	retro_init();
+
+	/* Fixed frameskip: also applied by the core's own settings code */
+	sf2000_frameskip = frameskip;
+
+	memset(&info, 0, sizeof(info));
+	info.path = argv[optind];
+	t0 = now_usec();
+	if (!retro_load_game(&info))
+	{
+		fprintf(stderr, "bench: can't load %s\n", info.path);
+		return 1;
+	}
+	prefs_gfx_framerate = changed_gfx_framerate = frameskip;
+	printf("load+warmup: %.3f s\n", (now_usec() - t0) / 1e6);
+#ifdef PROFILER_UAE4ALL
+	uae4all_prof_init();
+	if (prof_name)
+		uae4all_prof_trace_start();
+#endif
+#ifdef USE_BLIT_TRACE
+	if (!blit_trace_start(blit_trace_name))
+		return 1;
+#endif
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		unsigned c0;
+		uint64_t usec;
+
+		apply_input(frame);
+		frame_gfx_hash = 0;
+		frame_audio_hash = HASH_INIT;
+		frame_samples = 0;
+
+		c0 = m68k_get_cycles_counter();
+		t0 = now_usec();
+		retro_run();
+		usec = now_usec() - t0;
+		c0 = m68k_get_cycles_counter() - c0;
+
+		total_usec += usec;
+		total_cycles += c0;
+		if (usec < min_usec) min_usec = usec;
+		if (usec > max_usec) max_usec = usec;
+		run_hash = hash_bytes(run_hash, &frame_gfx_hash, sizeof(frame_gfx_hash));
+		run_hash = hash_bytes(run_hash, &frame_audio_hash, sizeof(frame_audio_hash));
+
+		if (csv)
+			fprintf(csv, "%u,%llu,%u,%016llx,%016llx,%u\n", frame,
+				(unsigned long long)usec, c0,
+				(unsigned long long)frame_gfx_hash,
+				(unsigned long long)frame_audio_hash, frame_samples);
+	}
+
+	if (csv)
+		fclose(csv);
+#ifdef PROFILER_UAE4ALL
+	uae4all_prof_show();
+	if (prof_name)
+	{
+		char name[1024];
+		snprintf(name, sizeof(name), "%s.csv", prof_name);
+		uae4all_prof_dump_csv(name);
+		snprintf(name, sizeof(name), "%s.json", prof_name);
+		uae4all_prof_dump_trace(name);
+	}
+#endif
+#ifdef USE_BLIT_TRACE
+	blit_trace_stop();
+	blit_trace_show();
+#endif
+#ifdef USE_CPU_IDLE_SKIP
+	m68k_idle_show();
+#endif
+#ifdef FAME_PREDECODE
+	m68k_predecode_show();
+#endif
+#ifdef USE_MIPS_DYNAREC
+	m68k_dynarec_show();
+#endif
+	if (frames)
+	{
+		printf("frames: %u\n", frames);
+		printf("time: %.3f s, %.2f fps\n", total_usec / 1e6,
+			total_usec ? frames * 1e6 / total_usec : 0.0);
+		printf("frame usec: min %llu avg %llu max %llu\n",
+			(unsigned long long)min_usec,
+			(unsigned long long)(total_usec / frames),
+			(unsigned long long)max_usec);
+		printf("68k cycles: %llu (%llu/frame)\n",
+			(unsigned long long)total_cycles,
+			(unsigned long long)(total_cycles / frames));
+		printf("hash: %016llx\n", (unsigned long long)run_hash);
+#ifdef USE_DISK_TRACK_CACHE
+		printf("disk track cache: %u hits, %u misses\n",
+			disk_cache_hits, disk_cache_misses);
+#endif
+	}
+
+	retro_unload_game();
+	retro_deinit();
+	if (kick)
+	{
+		unlink(kick_link);
+		rmdir(tmpdir);
+	}
+	return 0;
+}
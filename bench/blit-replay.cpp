@@ -0,0 +1,299 @@
+/*
+ * Blitter trace replay
+ *
+ * Reads a trace written by a USE_BLIT_TRACE build (uae4all_bench -b, or
+ * uae4all_blits.trace from AUTO_PROFILER) and runs its area blits again
+ * through the blitfunc_dofast[]/blitfunc_dofast_desc[] tables of the
+ * real blitfunc.cpp, and through the src/blit_fast.h kernels on a second
+ * copy of chip memory. Chip memory starts out random, since the trace
+ * only holds registers. Both copies must match after every blit. Prints
+ * the time per minterm, so blitfunc.cpp changes can be measured on the
+ * blits games actually do. Line mode blits are counted, not replayed.
+ *
+ *   make -f Makefile.bench blit-replay
+ *   ./blit-replay [-n rounds] blits.trace
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+#include "config.h"
+#include "uae.h"
+#include "options.h"
+#include "custom.h"
+#include "memory.h"
+#include "blitter.h"
+#include "blitfunc.h"
+
+/* blt_info.blitfill as blit_init() sets it */
+#ifndef USE_SHORT_BLITTABLE
+#define BLITFILL(con1) (((con1) & 0x18) ? 0x100 : 0)
+#else
+#define BLITFILL(con1) ((con1) & 0x18)
+#endif
+#include "blittrace.h"
+
+#define MEM_SIZE (2 * 1024 * 1024)
+
+uae_u8 *chipmemory;
+uae_u32 allocated_chipmem = MEM_SIZE;
+uae_u16 bltcon0;
+uae_u8 blit_filltable[256][4][2];
+#ifdef USE_BLIT_MASKTABLE
+uae_u32 blit_masktable[BLITTER_MAX_WORDS];
+#endif
+
+#include "blit_fast.h"
+
+static uae_u8 mem_table[MEM_SIZE], mem_fast[MEM_SIZE];
+
+struct replay_blit {
+    struct bltinfo b;
+    uae_u16 con0;
+    int desc;
+};
+
+struct replay_time {
+    unsigned count, fast;
+    double table_ns, fast_ns, trace_us;
+};
+
+static struct replay_time times[256];
+
+static unsigned rnd_state = 0x8f1bbcdc;
+
+static unsigned rnd (void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* Same table as build_blitfilltable() */
+static void build_filltable (void)
+{
+    unsigned int d, fillmask;
+    int i;
+
+    for (d = 0; d < 256; d++) {
+	for (i = 0; i < 4; i++) {
+	    int fc = i & 1;
+	    uae_u8 data = d;
+	    for (fillmask = 1; fillmask != 0x100; fillmask <<= 1) {
+		uae_u16 tmp = data;
+		if (fc) {
+		    if (i & 2)
+			data |= fillmask;
+		    else
+			data ^= fillmask;
+		}
+		if (tmp & fillmask) fc = !fc;
+	    }
+	    blit_filltable[d][i][0] = data;
+	    blit_filltable[d][i][1] = fc;
+	}
+    }
+}
+
+static double ns_since (struct timespec *t0)
+{
+    struct timespec t1;
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) * 1e9 + (t1.tv_nsec - t0->tv_nsec);
+}
+
+/* blit_init() and the pointer setup of blitter_dofast(); 0 if a channel
+   leaves chip memory */
+static int setup (const struct blit_trace_record *r, struct replay_blit *x)
+{
+    struct bltinfo *b = &x->b;
+    int lo, hi;
+
+    memset (x, 0, sizeof *x);
+    x->con0 = r->bltcon0;
+    x->desc = (r->bltcon1 & 2) != 0;
+    b->blitzero = 1;
+    b->blitashift = r->bltcon0 >> 12;
+    b->blitdownashift = 16 - b->blitashift;
+    b->blitbshift = r->bltcon1 >> 12;
+    b->blitdownbshift = 16 - b->blitbshift;
+    b->blitfc = !!(r->bltcon1 & 0x4);
+    b->blitife = r->bltcon1 & 0x8;
+    b->blitfill = BLITFILL (r->bltcon1);
+    b->hblitsize = r->hblitsize;
+    b->vblitsize = r->vblitsize;
+    b->bltamod = r->bltamod;
+    b->bltbmod = r->bltbmod;
+    b->bltcmod = r->bltcmod;
+    b->bltdmod = r->bltdmod;
+    b->bltafwm = r->bltafwm;
+    b->bltalwm = r->bltalwm;
+    b->bltadat = r->bltadat;
+    b->bltbdat = r->bltbdat;
+    b->bltcdat = r->bltcdat;
+    b->bltbhold = r->bltbhold;
+    b->pta = r->bltcon0 & 0x800 ? r->bltapt : 0;
+    b->ptb = r->bltcon0 & 0x400 ? r->bltbpt : 0;
+    b->ptc = r->bltcon0 & 0x200 ? r->bltcpt : 0;
+    b->ptd = r->bltcon0 & 0x100 ? r->bltdpt : 0;
+    if (b->hblitsize < 1 || b->vblitsize < 1 || b->hblitsize > BLITTER_MAX_WORDS)
+	return 0;
+    return (!b->pta || blitfast_span (b->pta, b->bltamod, b->hblitsize, b->vblitsize, x->desc, &lo, &hi))
+	&& (!b->ptb || blitfast_span (b->ptb, b->bltbmod, b->hblitsize, b->vblitsize, x->desc, &lo, &hi))
+	&& (!b->ptc || blitfast_span (b->ptc, b->bltcmod, b->hblitsize, b->vblitsize, x->desc, &lo, &hi))
+	&& (!b->ptd || blitfast_span (b->ptd, b->bltdmod, b->hblitsize, b->vblitsize, x->desc, &lo, &hi));
+}
+
+/* Exactly what blitter_dofast()/blitter_dofast_desc() call: without
+   USE_SHORT_BLITTABLE the uae_u8 index drops the fill bit there */
+static void run_table (struct bltinfo *b, int desc)
+{
+#ifndef USE_SHORT_BLITTABLE
+    uae_u8 mt = (bltcon0 & 0xFF) | b->blitfill;
+#else
+    uae_u8 mt = bltcon0 & 0xFF;
+#endif
+
+#ifdef USE_BLIT_MASKTABLE
+    blit_masktable[0] = b->bltafwm;
+    blit_masktable[b->hblitsize - 1] &= b->bltalwm;
+#endif
+#ifdef USE_SHORT_BLITTABLE
+    if (b->blitfill) {
+	if (desc)
+	    blitdofast_desc_fill (b);
+	else
+	    blitdofast_fill (b);
+    } else
+#endif
+    if (desc)
+	(*blitfunc_dofast_desc[mt]) (b);
+    else
+	(*blitfunc_dofast[mt]) (b);
+#ifdef USE_BLIT_MASKTABLE
+    blit_masktable[0] = 0xFFFF;
+    blit_masktable[b->hblitsize - 1] = 0xFFFF;
+#endif
+}
+
+static int run_fast (struct bltinfo *b, int desc)
+{
+    if (blitfast_dofast (b, bltcon0 & 0xFF, desc, b->pta, b->ptb, b->ptc, b->ptd))
+	return 1;
+    run_table (b, desc);
+    return 0;
+}
+
+static int same (struct bltinfo *x, struct bltinfo *y)
+{
+    return x->blitzero == y->blitzero && x->bltbhold == y->bltbhold
+	&& x->bltddat == y->bltddat && x->blitfc == y->blitfc;
+}
+
+int main (int argc, char **argv)
+{
+    struct blit_trace_header h;
+    struct blit_trace_record r;
+    struct replay_blit x;
+    struct bltinfo t, f;
+    struct timespec t0;
+    unsigned n = 0, lines = 0, skipped = 0, errors = 0;
+    int rounds = 1, round, opt, i;
+    double ticks_per_us, table_ns = 0, fast_ns = 0, trace_us = 0;
+    FILE *in;
+
+    while ((opt = getopt (argc, argv, "n:")) != -1) {
+	if (opt == 'n')
+	    rounds = atoi (optarg) > 0 ? atoi (optarg) : 1;
+	else
+	    optind = argc;
+    }
+    if (optind != argc - 1) {
+	fprintf (stderr, "usage: blit-replay [-n rounds] blits.trace\n");
+	return 1;
+    }
+    if (!(in = fopen (argv[optind], "rb")) || fread (&h, sizeof h, 1, in) != 1
+	|| h.magic != BLIT_TRACE_MAGIC || h.version != BLIT_TRACE_VERSION
+	|| h.record_size != sizeof (struct blit_trace_record)) {
+	fprintf (stderr, "blit-replay: %s is not a version %d blitter trace\n", argv[optind], BLIT_TRACE_VERSION);
+	return 1;
+    }
+    ticks_per_us = h.ticks_per_ms ? h.ticks_per_ms / 1000.0 : 1000.0;
+
+    build_filltable ();
+#ifdef USE_BLIT_MASKTABLE
+    for (i = 0; i < BLITTER_MAX_WORDS; i++)
+	blit_masktable[i] = 0xFFFF;
+#endif
+    for (i = 0; i < MEM_SIZE; i++)
+	mem_table[i] = rnd ();
+    memcpy (mem_fast, mem_table, MEM_SIZE);
+
+    for (round = 0; round < rounds; round++) {
+	rewind (in);
+	fread (&h, sizeof h, 1, in);
+	while (fread (&r, sizeof r, 1, in) == 1) {
+	    struct replay_time *rt = &times[r.bltcon0 & 0xFF];
+	    double ns;
+	    int fast;
+
+	    if (round == 0)
+		n++;
+	    if (r.bltcon1 & 1) {
+		lines += round == 0;
+		continue;
+	    }
+	    if (!setup (&r, &x)) {
+		skipped += round == 0;
+		continue;
+	    }
+	    bltcon0 = x.con0;
+	    t = f = x.b;
+
+	    chipmemory = mem_table;
+	    clock_gettime (CLOCK_MONOTONIC, &t0);
+	    run_table (&t, x.desc);
+	    ns = ns_since (&t0);
+	    rt->table_ns += ns;
+	    table_ns += ns;
+
+	    chipmemory = mem_fast;
+	    clock_gettime (CLOCK_MONOTONIC, &t0);
+	    fast = run_fast (&f, x.desc);
+	    ns = ns_since (&t0);
+	    rt->fast_ns += ns;
+	    fast_ns += ns;
+
+	    if (round == 0) {
+		rt->count++;
+		rt->fast += fast;
+		rt->trace_us += r.ticks / ticks_per_us;
+		trace_us += r.ticks / ticks_per_us;
+	    }
+	    if (!same (&t, &f) && errors++ < 10)
+		printf ("mismatch: blit %u minterm %02x\n", n, r.bltcon0 & 0xFF);
+	}
+    }
+    if (memcmp (mem_table, mem_fast, MEM_SIZE)) {
+	printf ("chip memory differs after the replay\n");
+	errors++;
+    }
+
+    /* replay times are per round */
+    printf ("%u blits: %u line (not replayed), %u outside chip memory, %d rounds\n", n, lines, skipped, rounds);
+    printf ("minterm   blits  recorded us   table us    fast us  by kernels\n");
+    for (i = 0; i < 256; i++)
+	if (times[i].count)
+	    printf ("   %02x  %8u %12.0f %10.0f %10.0f %8.1f%%\n", i, times[i].count, times[i].trace_us,
+		    times[i].table_ns / 1000 / rounds, times[i].fast_ns / 1000 / rounds, 100.0 * times[i].fast / times[i].count);
+    printf ("total: recorded %.3f ms, table %.3f ms, fast %.3f ms\n", trace_us / 1000, table_ns / 1e6 / rounds, fast_ns / 1e6 / rounds);
+    printf ("table and kernels: %s\n", errors ? "FAILED" : "ok");
+    fclose (in);
+    return errors != 0;
+}
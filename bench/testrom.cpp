@@ -0,0 +1,505 @@
+/*
+ * Synthetic display ROM for uae4all_bench
+ *
+ * Writes a 256KB "Kickstart" whose only job is to keep the display
+ * busy, so drawing changes can be checked frame for frame without a real
+ * ROM or game: five random bitplanes, a copper list that changes COLOR00
+ * and BPLCON0 on every line and COLOR01 somewhere in the middle of it
+ * (5 planes lores, dual playfield, 4 planes hires, 3 and 0 planes), and
+ * eight sprites, two of them attached. Once per frame, at line $130, the
+ * 68k shifts all the line colors, moves the sprites at different speeds
+ * and steps BPLCON1 scrolling and BPLCON2 priorities.
+ *
+ *   make -f Makefile.bench testrom
+ *   ./testrom [testrom.rom]
+ *   ./uae4all_bench -k testrom.rom -n 500 -o frames.csv none.adf
+ *
+ * The gfx hashes of two builds must match on every frame.
+ *
+ * With -b, -a or -d the 68k also runs workloads from chip RAM once the
+ * line colors are done, for changes outside the display:
+ *   -b  three area blits a frame into the bitplanes, waiting on BBUSY
+ *       for each: A shifted by the frame xor C, a cookie cut and a
+ *       descending exclusive fill
+ *   -a  all four audio channels on DMA; the 68k sweeps a period, ramps
+ *       a volume, moves a sample pointer and turns a channel on and off
+ *   -d  a track loader on DF0 over the image it writes to disk.adf:
+ *       seeks back and forth, reads tracks by disk DMA, checksums each
+ *       one into sprite 7 and writes every 8th back with the data of two
+ *       sectors swapped. The writes stay in the core's copy of the
+ *       image; with autosave on they also go to a .ads patch, which
+ *       has to be deleted before the next run.
+ *
+ *   ./testrom -b -a -d disk.adf work.rom
+ *   ./uae4all_bench -k work.rom -n 1000 -o frames.csv disk.adf
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#define ROM_SIZE 262144
+#define ROM_BASE 0xFC0000
+#define CODE 0x10		/* ROM offset of the reset code */
+#define BLOB 0x400		/* ROM offset of the chip RAM image */
+#define CHIP 0x1000		/* ... copied here: copper list, */
+#define SPRITES 0x3000		/* sprites, */
+#define BLOB_SIZE 0x2400
+#define PLANES 0x10000		/* bitplanes, filled by the code */
+#define PLANE_SIZE 0x3000
+#define FIRST_LINE 0x2C
+#define LAST_LINE 0xFF
+#define LINE_BYTES 20		/* copper list per line */
+#define STUB 0x2800		/* ROM offset of the workload hook, */
+#define WORK 0x3000		/* and of the workloads, copied to */
+#define WORK_CHIP 0x4000	/* chip RAM here, with */
+#define SAMPLES 0x4800		/* the audio samples and */
+#define FLAGS 0x47FE		/* the workloads to run */
+#define WORK_SIZE 0x1000
+#define DISK_BUF 0x1F000	/* track buffer, plane 5 */
+#define DISK_WORDS 6000
+#define DISK_COUNT 0x5000	/* tracks read and written */
+#define DISK_CYL 0x5002		/* head position */
+#define DISK_SIZE (80 * 2 * 11 * 512)
+
+static unsigned char rom[ROM_SIZE];
+static unsigned cop;		/* chip address of the next copper word */
+
+static void put_word (unsigned off, unsigned w)
+{
+    rom[off] = w >> 8;
+    rom[off + 1] = w;
+}
+
+static void chip_word (unsigned addr, unsigned w)
+{
+    put_word (BLOB + addr - CHIP, w);
+}
+
+static unsigned cop_move (unsigned reg, unsigned v)
+{
+    chip_word (cop, reg);
+    chip_word (cop + 2, v);
+    cop += 4;
+    return cop - 2;
+}
+
+static void cop_wait (unsigned line, unsigned hpos)
+{
+    chip_word (cop, (line << 8) | (hpos & 0xFE) | 1);
+    chip_word (cop + 2, 0xFFFE);
+    cop += 4;
+}
+
+static unsigned line_mode (unsigned line)
+{
+    if (line < 0x70)
+	return 0x5200;		/* 5 planes */
+    if (line < 0xA0)
+	return 0x6600;		/* dual playfield, 3+3 planes */
+    if (line < 0xD0)
+	return 0xC200;		/* hires, 4 planes */
+    if (line < 0xE8)
+	return 0x3200;
+    return 0x0200;
+}
+
+int main (int argc, char **argv)
+{
+    const char *name = "testrom.rom", *disk = NULL;
+    unsigned bplcon1, bplcon2, lines, i, n, flags = 0;
+    FILE *f;
+
+    for (i = 1; i < (unsigned)argc; i++) {
+	if (!strcmp (argv[i], "-b"))
+	    flags |= 1;
+	else if (!strcmp (argv[i], "-a"))
+	    flags |= 2;
+	else if (!strcmp (argv[i], "-d") && i + 1 < (unsigned)argc) {
+	    flags |= 4;
+	    disk = argv[++i];
+	} else
+	    name = argv[i];
+    }
+
+    /* the copper list, set up again at every vertical blank */
+    cop = CHIP;
+    cop_move (0x08E, 0x2C81);		/* DIWSTRT */
+    cop_move (0x090, 0x2CC1);		/* DIWSTOP */
+    cop_move (0x092, 0x0030);		/* DDFSTRT, a word early for scrolling */
+    cop_move (0x094, 0x00D0);		/* DDFSTOP */
+    cop_move (0x108, 2);		/* BPL1MOD: 44 byte rows */
+    cop_move (0x10A, 2);		/* BPL2MOD */
+    cop_move (0x100, 0x0200);		/* BPLCON0 */
+    bplcon1 = cop_move (0x102, 0);
+    bplcon2 = cop_move (0x104, 0);
+    for (i = 0; i < 6; i++) {
+	unsigned pt = PLANES + i * PLANE_SIZE;
+	cop_move (0x0E0 + i * 4, pt >> 16);
+	cop_move (0x0E2 + i * 4, pt & 0xFFFF);
+    }
+    for (i = 0; i < 8; i++) {
+	unsigned pt = SPRITES + i * 0x80;
+	cop_move (0x120 + i * 4, pt >> 16);
+	cop_move (0x122 + i * 4, pt & 0xFFFF);
+    }
+    for (i = 0; i < 32; i++)
+	cop_move (0x180 + i * 2, (i * 0x123 + 0x46) & 0xFFF);
+    lines = cop;
+    for (i = FIRST_LINE; i <= LAST_LINE; i++) {
+	cop_wait (i, 0x06);
+	cop_move (0x180, (i * 0x35) & 0xFFF);		/* COLOR00 */
+	cop_move (0x100, line_mode (i));		/* BPLCON0 */
+	cop_wait (i, 0x40 + ((i * 6) & 0x7E));
+	cop_move (0x182, (i * 0x1C7) & 0xFFF);		/* COLOR01 */
+    }
+    chip_word (cop, 0xFFFF);
+    chip_word (cop + 2, 0xFFFE);
+    if (cop + 4 > SPRITES) {
+	fprintf (stderr, "testrom: copper list too long\n");
+	return 1;
+    }
+
+    /* 16 line sprites, 1 and 5 attached to 0 and 4 */
+    for (n = 0; n < 8; n++) {
+	unsigned addr = SPRITES + n * 0x80;
+	unsigned vstart = 0x50 + n * 12, hstart = 0x70 + n * 28;
+
+	chip_word (addr, (vstart << 8) | ((hstart >> 1) & 0xFF));
+	chip_word (addr + 2, ((vstart + 16) << 8) | ((n & 3) == 1 ? 0x80 : 0) | (hstart & 1));
+	for (i = 0; i < 16; i++) {
+	    chip_word (addr + 4 + i * 4, (0xF00F >> (i & 7)) ^ (n * 0x1111));
+	    chip_word (addr + 6 + i * 4, (0x0FF0 << (i & 3)) ^ (i * 0x0101));
+	}
+	chip_word (addr + 68, 0);
+	chip_word (addr + 70, 0);
+    }
+
+    {
+	/* hand assembled, offsets from the start of the ROM */
+	static const unsigned short code[] = {
+	    0x4BF9, 0x00DF, 0xF000,		/* 10 lea $dff000,a5 */
+	    0x3B7C, 0x7FFF, 0x009A,		/* 16 move.w #$7fff,$9a(a5)	INTENA */
+	    0x3B7C, 0x7FFF, 0x0096,		/* 1c move.w #$7fff,$96(a5)	DMACON */
+	    0x3B7C, 0x7FFF, 0x009C,		/* 22 move.w #$7fff,$9c(a5)	INTREQ */
+	    0x13FC, 0x0003, 0x00BF, 0xE201,	/* 28 move.b #3,$bfe201 */
+	    0x13FC, 0x0000, 0x00BF, 0xE001,	/* 30 move.b #0,$bfe001		no overlay */
+	    0x4FF9, 0x0007, 0xFFF0,		/* 38 lea $7fff0,a7 */
+	    0x41F9, 0x0001, 0x0000,		/* 3e lea $10000,a0 */
+	    0x203C, 0x1234, 0x5678,		/* 44 move.l #$12345678,d0 */
+	    0x3E3C, 0x47FF,			/* 4a move.w #$47ff,d7 */
+	    0x20C0,				/* 4e move.l d0,(a0)+ */
+	    0xEB98,				/* 50 rol.l #5,d0 */
+	    0x0680, 0x9E37, 0x79B9,		/* 52 addi.l #$9e3779b9,d0 */
+	    0x51CF, 0xFFF4,			/* 58 dbra d7,$4e */
+	    0x41F9, 0x00FC, BLOB,		/* 5c lea BLOB,a0 */
+	    0x43F8, CHIP,			/* 62 lea CHIP.w,a1 */
+	    0x3E3C, BLOB_SIZE / 4 - 1,		/* 66 move.w #BLOB_SIZE/4-1,d7 */
+	    0x22D8,				/* 6a move.l (a0)+,(a1)+ */
+	    0x51CF, 0xFFFC,			/* 6c dbra d7,$6a */
+	    0x2B7C, 0x0000, CHIP, 0x0080,	/* 70 move.l #CHIP,$80(a5)	COP1LC */
+	    0x3B7C, 0x0000, 0x0088,		/* 78 move.w #0,$88(a5)		COPJMP1 */
+	    0x3B7C, 0x83E0, 0x0096,		/* 7e move.w #$83e0,$96(a5)	DMACON */
+	    0x7C00,				/* 84 moveq #0,d6 */
+	    0x202D, 0x0004,			/* 86 move.l 4(a5),d0		VPOSR */
+	    0x0280, 0x0001, 0xFF00,		/* 8a andi.l #$1ff00,d0 */
+	    0x0C80, 0x0001, 0x3000,		/* 90 cmpi.l #$13000,d0 */
+	    0x66EE,				/* 96 bne.s $86 */
+	    0x5246,				/* 98 addq.w #1,d6 */
+	    0x41F8, 0,				/* 9a lea LINES+6.w,a0 */
+	    0x3E3C, LAST_LINE - FIRST_LINE,	/* 9e move.w #lines-1,d7 */
+	    0xDD50,				/* a2 add.w d6,(a0)		COLOR00 */
+	    0x9D68, 0x000C,			/* a4 sub.w d6,12(a0)		COLOR01 */
+	    0x41E8, LINE_BYTES,			/* a8 lea LINE_BYTES(a0),a0 */
+	    0x51CF, 0xFFF4,			/* ac dbra d7,$a2 */
+	    0x41F8, SPRITES + 1,		/* b0 lea SPRITES+1.w,a0 */
+	    0x7E07,				/* b4 moveq #7,d7 */
+	    0xDF10,				/* b6 add.b d7,(a0)		HSTART */
+	    0x41E8, 0x0080,			/* b8 lea $80(a0),a0 */
+	    0x51CF, 0xFFF8,			/* bc dbra d7,$b6 */
+	    0x3006,				/* c0 move.w d6,d0 */
+	    0x0240, 0x000F,			/* c2 andi.w #$f,d0 */
+	    0x3200,				/* c6 move.w d0,d1 */
+	    0xE949,				/* c8 lsl.w #4,d1 */
+	    0x8041,				/* ca or.w d1,d0 */
+	    0x31C0, 0,				/* cc move.w d0,BPLCON1 value.w */
+	    0x3006,				/* d0 move.w d6,d0 */
+	    0xE448,				/* d2 lsr.w #2,d0 */
+	    0x0240, 0x007F,			/* d4 andi.w #$7f,d0 */
+	    0x31C0, 0,				/* d8 move.w d0,BPLCON2 value.w */
+	    0x202D, 0x0004,			/* dc move.l 4(a5),d0 */
+	    0x0280, 0x0001, 0xFF00,		/* e0 andi.l #$1ff00,d0 */
+	    0x0C80, 0x0001, 0x3000,		/* e6 cmpi.l #$13000,d0 */
+	    0x67EE,				/* ec beq.s $dc */
+	    0x6096				/* ee bra.s $86 */
+	};
+
+	put_word (0, 0x1111);
+	put_word (2, 0x4EF9);
+	put_word (4, ROM_BASE >> 16);
+	put_word (6, CODE);
+	for (i = 0; i < sizeof code / sizeof code[0]; i++)
+	    put_word (CODE + i * 2, code[i]);
+	put_word (0x9C, lines + 6);
+	put_word (0xCE, bplcon1);
+	put_word (0xDA, bplcon2);
+    }
+
+    if (flags) {
+	/* the hook, in ROM: copies the workloads at the first frame */
+	static const unsigned short stub[] = {
+	    0x0C46, 0x0001,			/* 2800 cmpi.w #1,d6		first frame: */
+	    0x6618,				/* 2804 bne.s $281e */
+	    0x41F9, 0x00FC, 0x3000,		/* 2806 lea ROM_BASE+WORK,a0	copy the workloads to chip RAM */
+	    0x43F8, 0x4000,			/* 280c lea WORK_CHIP.w,a1 */
+	    0x3E3C, 0x03FF,			/* 2810 move.w #$1000/4-1,d7 */
+	    0x22D8,				/* 2814 move.l (a0)+,(a1)+ */
+	    0x51CF, 0xFFFC,			/* 2816 dbra d7,$2814 */
+	    0x4EB8, 0x4000,			/* 281a jsr $4000.w		init */
+	    0x4EB8, 0x401E,			/* 281e jsr $401e.w		frame */
+	    0x4EF9, 0x00FC, 0x0086		/* 2822 jmp ROM_BASE+$86 */
+	};
+	/* the workloads, offsets from WORK_CHIP */
+	static const unsigned short work[] = {
+	    0x3038, 0x47FE,			/* 00 move.w FLAGS.w,d0 */
+	    0x0800, 0x0001,			/* 04 btst #1,d0 */
+	    0x6704,				/* 08 beq.s $e */
+	    0x6100, 0x003E,			/* 0a bsr $4a */
+	    0x3038, 0x47FE,			/* 0e move.w FLAGS.w,d0 */
+	    0x0800, 0x0002,			/* 12 btst #2,d0 */
+	    0x6704,				/* 16 beq.s $1c */
+	    0x6100, 0x01BE,			/* 18 bsr $1d8 */
+	    0x4E75,				/* 1c rts */
+	    0x3038, 0x47FE,			/* 1e move.w FLAGS.w,d0	audio first: its writes do not wait on the blits */
+	    0x0800, 0x0001,			/* 22 btst #1,d0 */
+	    0x6704,				/* 26 beq.s $2c */
+	    0x6100, 0x0158,			/* 28 bsr $182 */
+	    0x3038, 0x47FE,			/* 2c move.w FLAGS.w,d0 */
+	    0x0800, 0x0000,			/* 30 btst #0,d0 */
+	    0x6704,				/* 34 beq.s $3a */
+	    0x6100, 0x007C,			/* 36 bsr $b4 */
+	    0x3038, 0x47FE,			/* 3a move.w FLAGS.w,d0 */
+	    0x0800, 0x0002,			/* 3e btst #2,d0 */
+	    0x6704,				/* 42 beq.s $48 */
+	    0x6100, 0x01FA,			/* 44 bsr $240 */
+	    0x4E75,				/* 48 rts */
+	    0x3B7C, 0x00FF, 0x009E,		/* 4a move.w #$00ff,$9e(a5)	ADKCON: no modulation */
+	    0x2B7C, 0x0000, 0x4800, 0x00A0,	/* 50 move.l #SAMPLES,$a0(a5)	AUD0LC: 64 word triangle */
+	    0x3B7C, 0x0040, 0x00A4,		/* 58 move.w #64,$a4(a5)	AUD0LEN */
+	    0x3B7C, 0x0040, 0x00A8,		/* 5e move.w #64,$a8(a5)	AUD0VOL */
+	    0x2B7C, 0x0000, 0x4880, 0x00B0,	/* 64 move.l #SAMPLES+$80,$b0(a5)	AUD1LC: 50 word square */
+	    0x3B7C, 0x0032, 0x00B4,		/* 6c move.w #50,$b4(a5) */
+	    0x3B7C, 0x013D, 0x00B6,		/* 72 move.w #317,$b6(a5)	AUD1PER */
+	    0x2B7C, 0x0000, 0x4900, 0x00C0,	/* 78 move.l #SAMPLES+$100,$c0(a5)	AUD2LC: 128 word saw */
+	    0x3B7C, 0x0080, 0x00C4,		/* 80 move.w #128,$c4(a5) */
+	    0x3B7C, 0x00B5, 0x00C6,		/* 86 move.w #181,$c6(a5) */
+	    0x3B7C, 0x0028, 0x00C8,		/* 8c move.w #40,$c8(a5) */
+	    0x2B7C, 0x0000, 0x4B00, 0x00D0,	/* 92 move.l #SAMPLES+$300,$d0(a5)	AUD3LC: 128 word noise */
+	    0x3B7C, 0x0080, 0x00D4,		/* 9a move.w #128,$d4(a5) */
+	    0x3B7C, 0x01C5, 0x00D6,		/* a0 move.w #453,$d6(a5) */
+	    0x3B7C, 0x0014, 0x00D8,		/* a6 move.w #20,$d8(a5) */
+	    0x3B7C, 0x800F, 0x0096,		/* ac move.w #$800f,$96(a5)	DMACON: AUD0-3 */
+	    0x4E75,				/* b2 rts */
+	    0x082D, 0x0006, 0x0002,		/* b4 btst #6,2(a5)		DMACONR BBUSY */
+	    0x66F8,				/* ba bne.s $b4 */
+	    0x3006,				/* bc move.w d6,d0		1: A shifted by the frame xor C */
+	    0x0240, 0x000F,			/* be andi.w #15,d0 */
+	    0xE858,				/* c2 ror.w #4,d0 */
+	    0x0040, 0x0B5A,			/* c4 ori.w #$0b5a,d0 */
+	    0x3B40, 0x0040,			/* c8 move.w d0,$40(a5)	BLTCON0 */
+	    0x3B7C, 0x0000, 0x0042,		/* cc move.w #0,$42(a5)	BLTCON1 */
+	    0x2B7C, 0xFFFF, 0xFFFF, 0x0044,	/* d2 move.l #-1,$44(a5)	BLTAFWM, BLTALWM */
+	    0x2B7C, 0x0001, 0x0000, 0x0050,	/* da move.l #PLANES,$50(a5)	BLTAPT: plane 0 */
+	    0x2B7C, 0x0001, 0x4130, 0x0048,	/* e2 move.l #PLANES+$3000+100*44,$48(a5)	BLTCPT: plane 1, line 100 */
+	    0x2B7C, 0x0001, 0x4130, 0x0054,	/* ea move.l #PLANES+$3000+100*44,$54(a5)	BLTDPT */
+	    0x3B7C, 0x0004, 0x0060,		/* f2 move.w #4,$60(a5)	BLTCMOD */
+	    0x3B7C, 0x0004, 0x0064,		/* f8 move.w #4,$64(a5)	BLTAMOD */
+	    0x3B7C, 0x0004, 0x0066,		/* fe move.w #4,$66(a5)	BLTDMOD */
+	    0x3B7C, 0x0814, 0x0058,		/* 104 move.w #32*64+20,$58(a5)	BLTSIZE: 20 words, 32 lines */
+	    0x082D, 0x0006, 0x0002,		/* 10a btst #6,2(a5) */
+	    0x66F8,				/* 110 bne.s $10a */
+	    0x3006,				/* 112 move.w d6,d0		2: cookie cut, A at a line of the frame */
+	    0x0240, 0x003F,			/* 114 andi.w #63,d0 */
+	    0xC0FC, 0x002C,			/* 118 mulu #44,d0 */
+	    0x0680, 0x0001, 0x9000,		/* 11c addi.l #PLANES+3*$3000,d0 */
+	    0x2B40, 0x0050,			/* 122 move.l d0,$50(a5)	BLTAPT: plane 3 */
+	    0x2B7C, 0x0001, 0xC000, 0x004C,	/* 126 move.l #PLANES+4*$3000,$4c(a5)	BLTBPT: plane 4 */
+	    0x2B7C, 0x0001, 0x66E0, 0x0048,	/* 12e move.l #PLANES+2*$3000+40*44,$48(a5)	BLTCPT: plane 2, line 40 */
+	    0x2B7C, 0x0001, 0x66E0, 0x0054,	/* 136 move.l #PLANES+2*$3000+40*44,$54(a5)	BLTDPT */
+	    0x3B7C, 0x0FCA, 0x0040,		/* 13e move.w #$0fca,$40(a5) */
+	    0x3B7C, 0x0004, 0x0062,		/* 144 move.w #4,$62(a5)	BLTBMOD */
+	    0x3B7C, 0x0A14, 0x0058,		/* 14a move.w #40*64+20,$58(a5) */
+	    0x082D, 0x0006, 0x0002,		/* 150 btst #6,2(a5) */
+	    0x66F8,				/* 156 bne.s $150 */
+	    0x203C, 0x0001, 0xE25A,		/* 158 move.l #PLANES+4*$3000+199*44+38,d0	3: descending fill in place */
+	    0x2B40, 0x0050,			/* 15e move.l d0,$50(a5) */
+	    0x2B40, 0x0054,			/* 162 move.l d0,$54(a5) */
+	    0x3B7C, 0x09F0, 0x0040,		/* 166 move.w #$09f0,$40(a5) */
+	    0x3B7C, 0x0012, 0x0042,		/* 16c move.w #$0012,$42(a5)	DESC, EFE */
+	    0x3B7C, 0x0C94, 0x0058,		/* 172 move.w #50*64+20,$58(a5) */
+	    0x082D, 0x0006, 0x0002,		/* 178 btst #6,2(a5) */
+	    0x66F8,				/* 17e bne.s $178 */
+	    0x4E75,				/* 180 rts */
+	    0x3006,				/* 182 move.w d6,d0		AUD0PER sweeps */
+	    0x0240, 0x007F,			/* 184 andi.w #127,d0 */
+	    0xD040,				/* 188 add.w d0,d0 */
+	    0x0640, 0x00C8,			/* 18a addi.w #200,d0 */
+	    0x3B40, 0x00A6,			/* 18e move.w d0,$a6(a5) */
+	    0x3006,				/* 192 move.w d6,d0		AUD1VOL ramps */
+	    0x0240, 0x003F,			/* 194 andi.w #63,d0 */
+	    0x3B40, 0x00B8,			/* 198 move.w d0,$b8(a5) */
+	    0x3006,				/* 19c move.w d6,d0		every 16 frames AUD2 to the other half */
+	    0x0240, 0x000F,			/* 19e andi.w #15,d0 */
+	    0x6614,				/* 1a2 bne.s $1b8 */
+	    0x7200,				/* 1a4 moveq #0,d1 */
+	    0x3206,				/* 1a6 move.w d6,d1 */
+	    0x0241, 0x0010,			/* 1a8 andi.w #16,d1 */
+	    0xE949,				/* 1ac lsl.w #4,d1 */
+	    0x0681, 0x0000, 0x4900,		/* 1ae addi.l #SAMPLES+$100,d1 */
+	    0x2B41, 0x00C0,			/* 1b4 move.l d1,$c0(a5) */
+	    0x3006,				/* 1b8 move.w d6,d0		every 64 frames AUD3 DMA on or off */
+	    0x0240, 0x003F,			/* 1ba andi.w #63,d0 */
+	    0x6616,				/* 1be bne.s $1d6 */
+	    0x3006,				/* 1c0 move.w d6,d0 */
+	    0x0240, 0x0040,			/* 1c2 andi.w #64,d0 */
+	    0x6708,				/* 1c6 beq.s $1d0 */
+	    0x3B7C, 0x0008, 0x0096,		/* 1c8 move.w #$0008,$96(a5) */
+	    0x6006,				/* 1ce bra.s $1d6 */
+	    0x3B7C, 0x8008, 0x0096,		/* 1d0 move.w #$8008,$96(a5) */
+	    0x4E75,				/* 1d6 rts */
+	    0x3B7C, 0x8010, 0x0096,		/* 1d8 move.w #$8010,$96(a5)	DMACON: DSKEN */
+	    0x13FC, 0x00FF, 0x00BF, 0xD300,	/* 1de move.b #$ff,$bfd300	CIA-B DDRB */
+	    0x13FC, 0x00FF, 0x00BF, 0xD100,	/* 1e6 move.b #$ff,$bfd100	CIA-B PRB: nothing selected */
+	    0x13FC, 0x00F7, 0x00BF, 0xD100,	/* 1ee move.b #$f7,$bfd100	select DF0, motor bit high: motor off */
+	    0x13FC, 0x00FF, 0x00BF, 0xD100,	/* 1f6 move.b #$ff,$bfd100 */
+	    0x13FC, 0x007F, 0x00BF, 0xD100,	/* 1fe move.b #$7f,$bfd100	motor bit low */
+	    0x13FC, 0x0077, 0x00BF, 0xD100,	/* 206 move.b #$77,$bfd100	select DF0: motor on */
+	    0x0839, 0x0004, 0x00BF, 0xE001,	/* 20e btst #4,$bfe001		CIA-A PRA /TK0 */
+	    0x6714,				/* 216 beq.s $22c */
+	    0x13FC, 0x0076, 0x00BF, 0xD100,	/* 218 move.b #$76,$bfd100	step out */
+	    0x13FC, 0x0077, 0x00BF, 0xD100,	/* 220 move.b #$77,$bfd100 */
+	    0x610C,				/* 228 bsr.s $236 */
+	    0x60E2,				/* 22a bra.s $20e */
+	    0x4278, 0x5002,			/* 22c clr.w DISK_CYL.w */
+	    0x4278, 0x5000,			/* 230 clr.w DISK_COUNT.w */
+	    0x6034,				/* 234 bra.s $26a */
+	    0x3E3C, 0x012C,			/* 236 move.w #300,d7		for the step rate */
+	    0x51CF, 0xFFFE,			/* 23a dbra d7,$23a */
+	    0x4E75,				/* 23e rts */
+	    0x082D, 0x0001, 0x001F,		/* 240 btst #1,$1f(a5)		INTREQR DSKBLK */
+	    0x6720,				/* 246 beq.s $268 */
+	    0x3B7C, 0x0002, 0x009C,		/* 248 move.w #2,$9c(a5) */
+	    0x41F9, 0x0001, 0xF000,		/* 24e lea DISK_BUF,a0		checksum the track into sprite 7 */
+	    0x7000,				/* 254 moveq #0,d0 */
+	    0x3E3C, 0x0BB7,			/* 256 move.w #DISK_WORDS/2-1,d7 */
+	    0xD098,				/* 25a add.l (a0)+,d0 */
+	    0xE398,				/* 25c rol.l #1,d0 */
+	    0x51CF, 0xFFFA,			/* 25e dbra d7,$25a */
+	    0x21C0, 0x3384,			/* 262 move.l d0,SPRITES+7*$80+4.w */
+	    0x6102,				/* 266 bsr.s $26a */
+	    0x4E75,				/* 268 rts */
+	    0x3038, 0x5000,			/* 26a move.w DISK_COUNT.w,d0 */
+	    0x5278, 0x5000,			/* 26e addq.w #1,DISK_COUNT.w */
+	    0x3200,				/* 272 move.w d0,d1 */
+	    0x0241, 0x0007,			/* 274 andi.w #7,d1 */
+	    0x0C41, 0x0007,			/* 278 cmpi.w #7,d1 */
+	    0x6640,				/* 27c bne.s $2be */
+	    0x41F9, 0x0001, 0xF032,		/* 27e lea DISK_BUF+25*2,a0	every 8th: swap the data of two sectors */
+	    0x43F9, 0x0001, 0xF472,		/* 284 lea DISK_BUF+(544+25)*2,a1 */
+	    0x3E3C, 0x0101,			/* 28a move.w #516/2-1,d7 */
+	    0x2210,				/* 28e move.l (a0),d1 */
+	    0x20D1,				/* 290 move.l (a1),(a0)+ */
+	    0x22C1,				/* 292 move.l d1,(a1)+ */
+	    0x51CF, 0xFFF8,			/* 294 dbra d7,$28e */
+	    0x23FC, 0xAAAA, 0x4489, 0x0001, 0xEFFC,	/* 298 move.l #$aaaa4489,DISK_BUF-4	and write the track back */
+	    0x2B7C, 0x0001, 0xEFFC, 0x0020,	/* 2a2 move.l #DISK_BUF-4,$20(a5)	DSKPT */
+	    0x3B7C, 0x4000, 0x0024,		/* 2aa move.w #$4000,$24(a5)	DSKLEN */
+	    0x3B7C, 0xD772, 0x0024,		/* 2b0 move.w #$c000+DISK_WORDS+2,$24(a5) */
+	    0x3B7C, 0xD772, 0x0024,		/* 2b6 move.w #$c000+DISK_WORDS+2,$24(a5) */
+	    0x4E75,				/* 2bc rts */
+	    0x0240, 0x000F,			/* 2be andi.w #15,d0		cylinder from the table */
+	    0x41F8, 0x4340,			/* 2c2 lea tracks.w,a0 */
+	    0x7600,				/* 2c6 moveq #0,d3 */
+	    0x1630, 0x0000,			/* 2c8 move.b 0(a0,d0.w),d3 */
+	    0x3438, 0x5000,			/* 2cc move.w DISK_COUNT.w,d2	side from bit 4 of the count */
+	    0xE44A,				/* 2d0 lsr.w #2,d2 */
+	    0x0242, 0x0004,			/* 2d2 andi.w #4,d2 */
+	    0x0A42, 0x0075,			/* 2d6 eori.w #$75,d2		d2: motor, DF0, side, step high */
+	    0x3838, 0x5002,			/* 2da move.w DISK_CYL.w,d4 */
+	    0xB644,				/* 2de cmp.w d4,d3 */
+	    0x6726,				/* 2e0 beq.s $308 */
+	    0x6208,				/* 2e2 bhi.s $2ec */
+	    0x0042, 0x0002,			/* 2e4 ori.w #2,d2		out */
+	    0x5344,				/* 2e8 subq.w #1,d4 */
+	    0x6006,				/* 2ea bra.s $2f2 */
+	    0x0242, 0x00FD,			/* 2ec andi.w #$fd,d2		in */
+	    0x5244,				/* 2f0 addq.w #1,d4 */
+	    0x1002,				/* 2f2 move.b d2,d0 */
+	    0x5300,				/* 2f4 subq.b #1,d0 */
+	    0x13C0, 0x00BF, 0xD100,		/* 2f6 move.b d0,$bfd100 */
+	    0x13C2, 0x00BF, 0xD100,		/* 2fc move.b d2,$bfd100 */
+	    0x6100, 0xFF32,			/* 302 bsr $236 */
+	    0x60D6,				/* 306 bra.s $2de */
+	    0x13C2, 0x00BF, 0xD100,		/* 308 move.b d2,$bfd100 */
+	    0x31C4, 0x5002,			/* 30e move.w d4,DISK_CYL.w */
+	    0x3B7C, 0x4000, 0x0024,		/* 312 move.w #$4000,$24(a5)	DSKLEN off */
+	    0x2B7C, 0x0001, 0xF000, 0x0020,	/* 318 move.l #DISK_BUF,$20(a5)	DSKPT */
+	    0x3B7C, 0x7F00, 0x009E,		/* 320 move.w #$7f00,$9e(a5)	ADKCON */
+	    0x3B7C, 0x9500, 0x009E,		/* 326 move.w #$9500,$9e(a5)	MFMPREC, WORDSYNC, FAST */
+	    0x3B7C, 0x4489, 0x007E,		/* 32c move.w #$4489,$7e(a5)	DSKSYNC */
+	    0x3B7C, 0x9770, 0x0024,		/* 332 move.w #$8000+DISK_WORDS,$24(a5) */
+	    0x3B7C, 0x9770, 0x0024,		/* 338 move.w #$8000+DISK_WORDS,$24(a5) */
+	    0x4E75,				/* 33e rts */
+	    0x0028, 0x0128, 0x0229, 0x0300, 0x4F28, 0x4E01, 0x0228, 0x0300	/* 340 tracks: cylinders to visit */
+	};
+	unsigned char *s = rom + WORK + SAMPLES - WORK_CHIP;
+
+	/* the frame loop goes through the hook instead of bra.s $86 */
+	put_word (0xEE, 0x4EF9);
+	put_word (0xF0, ROM_BASE >> 16);
+	put_word (0xF2, STUB);
+	for (i = 0; i < sizeof stub / sizeof stub[0]; i++)
+	    put_word (STUB + i * 2, stub[i]);
+	for (i = 0; i < sizeof work / sizeof work[0]; i++)
+	    put_word (WORK + i * 2, work[i]);
+	put_word (WORK + FLAGS - WORK_CHIP, flags);
+
+	/* signed 8 bit samples */
+	for (i = 0; i < 128; i++)		/* triangle, 64 words */
+	    s[i] = i < 64 ? i * 4 - 128 : 383 - i * 4;
+	for (i = 0; i < 100; i++)		/* square, 50 words */
+	    s[0x80 + i] = i < 50 ? 0x60 : 0xA0;
+	for (i = 0; i < 512; i++)		/* saw, two halves of 128 words */
+	    s[0x100 + i] = i * (i < 256 ? 1 : 3);
+	n = 0x2545F491;
+	for (i = 0; i < 256; i++) {		/* noise, 128 words */
+	    n ^= n << 13;
+	    n ^= n >> 17;
+	    n ^= n << 5;
+	    s[0x300 + i] = n >> 24;
+	}
+    }
+
+    if (disk) {
+	f = fopen (disk, "wb");
+	if (!f) {
+	    fprintf (stderr, "testrom: can't write %s\n", disk);
+	    return 1;
+	}
+	n = 0x9E3779B9;
+	for (i = 0; i < DISK_SIZE; i++) {
+	    n ^= n << 13;
+	    n ^= n >> 17;
+	    n ^= n << 5;
+	    fputc (n >> 24, f);
+	}
+	fclose (f);
+    }
+
+    f = fopen (name, "wb");
+    if (!f || fwrite (rom, 1, sizeof rom, f) != sizeof rom) {
+	fprintf (stderr, "testrom: can't write %s\n", name);
+	return 1;
+    }
+    fclose (f);
+    return 0;
+}
@@ -51,6 +51,7 @@ static struct {
 #include "options.h"
 #include "savestate.h"
 #include "disk.h"  // v055: Disk shuffler
+#include "custom.h"
 
 // v051: Use savestate globals instead of direct function calls
 extern int savestate_state;
@@ -467,6 +468,9 @@ static int count_loaded_adfs(void) {
 void sf2000_feedback_overlay(char *pixels) {
     if (sf2000_feedback_timer <= 0) return;  // No message to show
     sf2000_feedback_timer--;
+#ifdef USE_DIRTY_LINES
+    notice_screen_contents_lost();  // Box covers emulated rows, redraw them next frame
+#endif
 
     // Draw message box at top of screen
     int msg_len = strlen(sf2000_feedback_msg);
@@ -757,6 +761,11 @@ void sf2000_menu_overlay(char *pixels) {
                 }
                 break;
             case 4:
+#ifdef USE_AUTO_FRAMESKIP
+                if (sf2000_frameskip < 0)
+                    snprintf(buf, sizeof(buf), "%s5.Frameskip: Auto", sel);
+                else
+#endif
                 snprintf(buf, sizeof(buf), "%s5.Frameskip: %d", sel, sf2000_frameskip);
                 break;
             case 5:
@@ -1060,7 +1069,11 @@ static void sf2000_handle_menu_input(void) {
                         if (sf2000_mouse_speed > 0) sf2000_mouse_speed--;
                     }
                     break;
+#ifdef USE_AUTO_FRAMESKIP
+                case 4: if (sf2000_frameskip > -1) sf2000_frameskip--; break;  // -1 = Auto
+#else
                 case 4: if (sf2000_frameskip > 0) sf2000_frameskip--; break;
+#endif
                 case 5: if (sf2000_sound_mode > 0) sf2000_sound_mode--; break;
                 case 6: if (sf2000_cpu_timing > 1) sf2000_cpu_timing--; break;
                 case 7: sf2000_pos_correction = !sf2000_pos_correction; break;  // v102: PosCorrect toggle
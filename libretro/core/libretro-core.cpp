@@ -69,6 +69,7 @@ static void apply_menu_patch(void) {
 #include "m68k/uae/newcpu.h"
 
 #include "savestate.h"
+#include "debug_uae4all.h"
 
 /* v158: splash_logo.h removed - no pre-boot */
 
@@ -171,12 +172,22 @@ static retro_audio_sample_t audio_cb;
 static retro_audio_sample_batch_t audio_batch_cb;
 static retro_environment_t environ_cb;
 
+#ifdef USE_STRETCH_ROWS
+// Y-Stretch is done by drawing.cpp while rendering (from drawing.cpp)
+extern int stretch_rows_div, stretch_rows_y_start;
+extern int stretch_rows_drawn_div, stretch_rows_drawn_y_start;
+#else
 // v105: Y-Stretch buffer (320 x 240 x 2 bytes = 153600 bytes)
 static uint16_t stretch_buffer[320 * 240];
+#endif
 
 // v106: LED drawing after stretch - need gui_data for drive status
 #include "gui.h"
 
+#ifdef USE_AUTO_FRAMESKIP
+extern int auto_frameskip_shown;  // from drawing.cpp
+#endif
+
 // v109: Digit patterns for track numbers (from drawing.cpp)
 // Each digit is 7x7 pixels, 'x' = white pixel, '-' = transparent
 static const char *led_numbers =
@@ -192,7 +203,7 @@ static const char *led_numbers =
 #define LED_NUM_HEIGHT 7
 
 // v109: Draw a single digit on stretch_buffer at (x,y)
-static void draw_digit_on_stretch(int x, int y, int digit) {
+static void draw_digit_on_stretch(uint16_t *buf, int x, int y, int digit) {
     if (digit < 0 || digit > 9) return;
 
     for (int row = 0; row < LED_NUM_HEIGHT; row++) {
@@ -206,7 +217,7 @@ static void draw_digit_on_stretch(int x, int y, int digit) {
             if (screen_x < 0 || screen_x >= 320) continue;
 
             if (numptr[col] == 'x') {
-                stretch_buffer[screen_y * 320 + screen_x] = 0xFFFF;  // White
+                buf[screen_y * 320 + screen_x] = 0xFFFF;  // White
             }
         }
     }
@@ -215,7 +226,7 @@ static void draw_digit_on_stretch(int x, int y, int digit) {
 // v109: Draw LEDs directly to stretch_buffer (fixed position at bottom-right)
 // LEDs don't move with stretch and are always at screen bottom
 // Includes track numbers!
-static void draw_leds_on_stretch_buffer(void) {
+static void draw_leds_on_stretch_buffer(uint16_t *buf) {
     // LED dimensions (from drawing.cpp)
     const int TD_PADX = 20;
     const int TD_PADY = 2;
@@ -243,6 +254,9 @@ static void draw_leds_on_stretch_buffer(void) {
             // Power LED
             on = gui_data.powerled;
             color = on ? 0xF800 : 0x4000;  // Red (bright/dim)
+#ifdef USE_AUTO_FRAMESKIP
+            track = auto_frameskip_shown;  // frames skipped per second, -1 = fixed frameskip
+#endif
         }
 
         // Draw LED rectangle
@@ -253,18 +267,19 @@ static void draw_leds_on_stretch_buffer(void) {
                 for (int dx = 0; dx < TD_LED_WIDTH; dx++) {
                     int x = led_x + dx;
                     if (x >= 0 && x < 320) {
-                        stretch_buffer[y * 320 + x] = color;
+                        buf[y * 320 + x] = color;
                     }
                 }
             }
         }
 
-        // v109: Draw track number below LED (only for drives, not power)
+        // v109: Draw track number below LED (only for drives, not power,
+        // unless auto frameskip puts its count there)
         if (track >= 0) {
             int num_offs = (TD_WIDTH - 2 * LED_NUM_WIDTH) / 2 - 4;
             int num_y = base_y + TD_PADY;
-            draw_digit_on_stretch(led_x + num_offs, num_y, track / 10);
-            draw_digit_on_stretch(led_x + num_offs + LED_NUM_WIDTH, num_y, track % 10);
+            draw_digit_on_stretch(buf, led_x + num_offs, num_y, track / 10);
+            draw_digit_on_stretch(buf, led_x + num_offs + LED_NUM_WIDTH, num_y, track % 10);
         }
     }
 }
@@ -743,10 +758,6 @@ void retro_run(void)
    extern overscan_settings_t overscan_config;
    uae_render_y_offset = 0;  // UAE zawsze renderuje te same linie Amiga
 
-   // v017: Only run M68K if not paused (menu or keyboard)
-   if(pauseg==0)
-      m68k_go (1);
-
    // v101: Y-offset calculation with Position Correction support
    extern unsigned gfx_rowbytes;  // from retrogfx.cpp
    int y_start;
@@ -766,6 +777,26 @@ void retro_run(void)
    // v102: Update LED base line for drawing.cpp - LEDs should be at screen bottom
    uae_led_base_line = y_start + 240;
 
+#ifdef USE_STRETCH_ROWS
+   // Y-Stretch levels, see below; drawing.cpp takes them at the next frame
+   stretch_rows_div = 0;
+   if (sf2000_v_stretch > 0 && sf2000_pos_correction)
+       stretch_rows_div = sf2000_v_stretch == 1 ? 32 : sf2000_v_stretch == 3 ? 12 : 16;
+   stretch_rows_y_start = y_start;
+#endif
+
+   // v017: Only run M68K if not paused (menu or keyboard)
+   if(pauseg==0)
+      m68k_go (1);
+
+   uae4all_prof_start(UAE4ALL_PROF_VIDEO_OUT);
+
+#ifdef USE_STRETCH_ROWS
+   // gfx_mem holds the layout of the last drawn frame, not the wanted one
+   if (stretch_rows_drawn_div)
+       y_start = stretch_rows_drawn_y_start;
+#endif
+
    // Overlays rysują do TEJ SAMEJ części co będzie wysłana!
    // KLUCZOWE: overlay_ptr = gfx_mem + (y_start * gfx_rowbytes)
    // To znaczy overlays rysują do środkowej części 240 linii z 288
@@ -782,6 +813,12 @@ void retro_run(void)
    } else if(SHOWKEY==1) {
       retro_virtualkb();  // Keyboard overlay
    }
+#ifdef USE_DIRTY_LINES
+   // Overlays draw into gfx_mem: rows under them must be redrawn next frame
+   if (sf2000_disk_shuffler_active || sf2000_settings_active || sf2000_about_active ||
+       sf2000_menu_active || SHOWKEY==1)
+      notice_screen_contents_lost();
+#endif
 
    // v058: Feedback message (always on top of emulation)
    sf2000_feedback_overlay(overlay_ptr);
@@ -796,6 +833,13 @@ void retro_run(void)
    int overlay_active = sf2000_menu_active || sf2000_settings_active ||
                         sf2000_about_active || sf2000_disk_shuffler_active || (SHOWKEY == 1);
 
+#ifdef USE_STRETCH_ROWS
+   // The frame was drawn stretched: only the LEDs are left to do
+   if (stretch_rows_drawn_div && sf2000_show_leds && !overlay_active)
+       draw_leds_on_stretch_buffer((uint16_t*)overlay_ptr);
+
+   video_cb(overlay_ptr, retrow, retroh, retrow << PIXEL_BYTES);
+#else
    if (sf2000_v_stretch > 0 && sf2000_pos_correction && !overlay_active) {
        // Determine skip divisor based on stretch level
        int skip_div;
@@ -826,7 +870,7 @@ void retro_run(void)
        // v109: Draw LEDs on stretch_buffer AFTER stretch (fixed position)
        // Only draw if show_leds is ON
        if (sf2000_show_leds) {
-           draw_leds_on_stretch_buffer();
+           draw_leds_on_stretch_buffer(stretch_buffer);
        }
 
        video_cb(stretch_buffer, retrow, retroh, retrow << PIXEL_BYTES);
@@ -834,7 +878,9 @@ void retro_run(void)
        // v099: Wysyłaj tę samą część co overlays (ZERO copy!)
        video_cb(overlay_ptr, retrow, retroh, retrow << PIXEL_BYTES);
    }
+#endif
 
+   uae4all_prof_end(UAE4ALL_PROF_VIDEO_OUT);
 }
 
 
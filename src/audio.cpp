@@ -164,6 +164,89 @@ static const int aprox_vol[128]= {-16, 0, 1, 1, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4,
 	}
 #endif
 
+#ifdef USE_AUDIO_TIMELINE
+/*
+ * Batched output: the mixed word only changes when a channel sample,
+ * volume or ADK mask changes, so update_audio() just counts samples and
+ * the output is kept as runs of (count, word). audio_timeline_render()
+ * writes the runs out at frame end (and before the buffer is handed
+ * to the frontend). Same words in the same order as SAMPLE_HANDLER.
+ */
+#define AUDIO_TIMELINE_MAX 1024
+
+static unsigned audio_timeline_count[AUDIO_TIMELINE_MAX];
+static uae_u16 audio_timeline_word[AUDIO_TIMELINE_MAX];
+static int audio_timeline_n;
+static unsigned audio_timeline_run;
+static uae_u16 audio_timeline_cur;
+
+static __inline__ uae_u16 audio_timeline_mix (void)
+{
+    uae_u32 d0 = audio_channel_current_sample[0];
+    uae_u32 d1 = audio_channel_current_sample[1];
+    uae_u32 d2 = audio_channel_current_sample[2];
+    uae_u32 d3 = audio_channel_current_sample[3];
+#ifdef EXACT_AUDIO
+    d0 *= audio_channel_vol[0];
+    d1 *= audio_channel_vol[1];
+    d2 *= audio_channel_vol[2];
+    d3 *= audio_channel_vol[3];
+#else
+    d0 <<= audio_channel_vol[0];
+    d1 <<= audio_channel_vol[1];
+    d2 <<= audio_channel_vol[2];
+    d3 <<= audio_channel_vol[3];
+#endif
+    d0 &= audio_channel_adk_mask[0];
+    d1 &= audio_channel_adk_mask[1];
+    d2 &= audio_channel_adk_mask[2];
+    d3 &= audio_channel_adk_mask[3];
+    return d0 + d1 + d2 + d3;
+}
+
+static __inline__ void audio_timeline_put (unsigned n, uae_u16 word)
+{
+    while (n-- > 0) {
+	PUT_SOUND_WORD (word)
+	CHECK_SOUND_BUFFERS();
+    }
+}
+
+void audio_timeline_render (void)
+{
+    int i;
+
+    for (i = 0; i < audio_timeline_n; i++)
+	audio_timeline_put (audio_timeline_count[i], audio_timeline_word[i]);
+    audio_timeline_n = 0;
+    audio_timeline_put (audio_timeline_run, audio_timeline_cur);
+    audio_timeline_run = 0;
+}
+
+/* A mixer input changed: close the current run if the word differs */
+static void audio_timeline_changed (void)
+{
+    uae_u16 word = audio_timeline_mix ();
+
+    if (word == audio_timeline_cur)
+	return;
+    if (audio_timeline_run) {
+	if (audio_timeline_n == AUDIO_TIMELINE_MAX)
+	    audio_timeline_render ();
+	else {
+	    audio_timeline_count[audio_timeline_n] = audio_timeline_run;
+	    audio_timeline_word[audio_timeline_n++] = audio_timeline_cur;
+	    audio_timeline_run = 0;
+	}
+    }
+    audio_timeline_cur = word;
+}
+
+#define AUDIO_TIMELINE_CHANGED() audio_timeline_changed ()
+#else
+#define AUDIO_TIMELINE_CHANGED()
+#endif
+
 #define SCHEDULE_AUDIO(CHN) \
 	if (audio_channel_state[CHN]) { \
 	    if (best > audio_channel_evtime[CHN]) { \
@@ -189,6 +272,7 @@ void schedule_audio (void)
     SCHEDULE_AUDIO(5)
 #endif
     eventtab[ev_audio].evtime = get_cycles () + best;
+    event_changed (ev_audio);
 #else
     unsigned long best = ~0ul;
     int i;
@@ -203,6 +287,7 @@ void schedule_audio (void)
     	SCHEDULE_AUDIO(i)
     }
     eventtab[ev_audio].evtime = get_cycles () + best;
+    event_changed (ev_audio);
 #endif
 }
 
@@ -621,6 +706,7 @@ static void audio_channel_enable_dma(int n_channel)
 	audio_channel_state[NCHAN] = 0; \
 	cdp->last_sample = 0; \
 	audio_channel_current_sample[NCHAN] = 0; \
+	AUDIO_TIMELINE_CHANGED(); \
     } \
 }
 
@@ -666,6 +752,7 @@ audio_channel_vol[5] = 0;
      * Original comment shows someone changed it FROM 0 TO get_cycles() - BAD! */
     last_cycles = 0;
     next_sample_evtime = scaled_sample_evtime;
+    AUDIO_TIMELINE_CHANGED();
 
     schedule_audio ();
 }
@@ -698,6 +785,7 @@ void check_prefs_changed_audio (void)
     }
     if (!produce_sound) {
 	eventtab[ev_audio].active = 0;
+	event_changed (ev_audio);
 	events_schedule ();
     }
 }
@@ -775,12 +863,22 @@ void check_prefs_changed_audio (void)
 #endif
 
 
+#ifdef USE_AUDIO_TIMELINE
+#define IF_SAMPLE \
+	if (!next_sample_evtime) { \
+		next_sample_evtime = scaled_sample_evtime; \
+		audio_timeline_run++; \
+	} \
+
+#else
 #define IF_SAMPLE \
 	if (!next_sample_evtime) { \
 		next_sample_evtime = scaled_sample_evtime; \
 		SAMPLE_HANDLER \
 	} \
 
+#endif
+
 
 #define IF_SAMPLE_AHI \
 	if (!next_sample_evtime) { \
@@ -789,6 +887,22 @@ void check_prefs_changed_audio (void)
 	} \
 
 
+#ifdef USE_AUDIO_TIMELINE
+#define RUN_HANDLERS \
+	{ \
+	    int ran = 0; \
+	    if (!EVTIME0 && STATE0) { \
+		audio_handler_0(); ran = 1; } \
+	    if (!EVTIME1 && STATE1) { \
+		audio_handler_1(); ran = 1; } \
+	    if (!EVTIME2 && STATE2) { \
+		audio_handler_2(); ran = 1; } \
+	    if (!EVTIME3 && STATE3) { \
+		audio_handler_3(); ran = 1; } \
+	    if (ran) \
+		audio_timeline_changed (); \
+	}
+#else
 #define RUN_HANDLERS \
 	if (!EVTIME0 && STATE0) \
 	    audio_handler_0(); \
@@ -799,6 +913,8 @@ void check_prefs_changed_audio (void)
 	if (!EVTIME3 && STATE3) \
 	    audio_handler_3(); \
 
+#endif
+
 
 #define RUN_HANDLERS_AHI \
 	RUN_HANDLERS \
@@ -812,7 +928,7 @@ void update_audio (void)
 {
     unsigned long int n_cycles;
 
-    uae4all_prof_start(4);
+    uae4all_prof_start(UAE4ALL_PROF_AUDIO);
     n_cycles = get_cycles () - last_cycles;
 #ifdef SOUND_AHI
 	for (;;) {
@@ -834,7 +950,7 @@ void update_audio (void)
 
 	last_cycles = get_cycles () - n_cycles;
 
-    uae4all_prof_end(4);
+    uae4all_prof_end(UAE4ALL_PROF_AUDIO);
 }
 
 void audio_evhandler (void)
@@ -845,7 +961,10 @@ void audio_evhandler (void)
     	schedule_audio ();
     }
     else
+    {
     	eventtab[ev_audio].evtime = get_cycles () + (~0ul);
+    	event_changed (ev_audio);
+    }
 }
 
 void AUDxDAT (int nr, uae_u16 v)
@@ -936,6 +1055,7 @@ void AUDxVOL (int nr, uae_u16 v)
 #else
     audio_channel_vol[nr] = APROX_VOL(v);
 #endif
+    AUDIO_TIMELINE_CHANGED();
 }
 
 int init_audio (void)
@@ -1037,6 +1157,7 @@ void update_adkmasks (void)
     audio_channel_adk_mask[1] = (((t >> 1) & 1) - 1);
     audio_channel_adk_mask[2] = (((t >> 2) & 1) - 1);
     audio_channel_adk_mask[3] = (((t >> 3) & 1) - 1);
+    AUDIO_TIMELINE_CHANGED();
 }
 
 
@@ -1048,6 +1169,7 @@ uae_u8 *restore_audio (uae_u8 *src, int i)
     acd = audio_channel + i;
     audio_channel_state[i]=restore_u8 ();
     audio_channel_vol[i]=restore_u8 ();
+    AUDIO_TIMELINE_CHANGED();
     acd->intreq2 = restore_u8 ();
     acd->data_written = restore_u8 ();
     acd->len = restore_u16 ();
@@ -0,0 +1,243 @@
+/*
+ * Fast blitter kernels, included by blitter.cpp with USE_BLIT_FAST_KERNELS.
+ *
+ * The blitfunc.cpp bodies go through _CHIPMEM_WGET/_CHIPMEM_WPUT with a
+ * pointer check per channel per word, whatever the blit. The minterms
+ * most games spend their blitter time in (clear 0x00, copies 0xF0 and
+ * 0xCC, cookie-cut 0xCA and 0xE2, and area fill with 0xF0) get their own
+ * loops over native chip memory pointers instead; see blit_fast_kernel.h.
+ * The fill kernel is only used with USE_SHORT_BLITTABLE: without it,
+ * blitter.cpp keeps the table index in a uae_u8, the fill bit is lost
+ * and fill blits run as plain copies, so those are left to the table.
+ *
+ * blitfast_dofast() only takes blits where that is exactly equivalent:
+ * every channel in use inside chip memory, even pointers and modulos,
+ * and no source overlapping D unless it walks the same words (in-place
+ * cookie-cut with C = D). Anything else is left to blitfunc_dofast[].
+ * bench/bench-blitfast.cpp checks the kernels against the table.
+ *
+ * The includer provides chipmemory, allocated_chipmem and struct bltinfo.
+ */
+
+#ifndef BLIT_FAST_H
+#define BLIT_FAST_H
+
+#include <string.h>
+
+#if defined(SECURE_BLITTER) || defined(SAFE_MEMORY_ACCESS)
+/* _CHIPMEM_WGET wraps at 1MB there */
+#define BLITFAST_MEMSIZE (allocated_chipmem < 0x100000 ? allocated_chipmem : 0x100000)
+#else
+#define BLITFAST_MEMSIZE allocated_chipmem
+#endif
+
+/* Two chip words at once; p is only word aligned */
+static __inline__ uae_u32 blitfast_get32 (const uae_u16 *p)
+{
+    uae_u32 v;
+    memcpy (&v, p, 4);
+    return v;
+}
+
+static __inline__ void blitfast_put32 (uae_u16 *p, uae_u32 v)
+{
+    memcpy (p, &v, 4);
+}
+
+/* Area fill of one word, bit 0 first: what blit_filltable does a byte at
+   a time. Each bit's fill carry is the incoming one xor the parity of
+   the source bits below it. */
+static __inline__ uae_u32 blitfast_fill (uae_u32 d, int *fc, int ife)
+{
+    uae_u32 p = d << 1;
+
+    p ^= p << 1;
+    p ^= p << 2;
+    p ^= p << 4;
+    p ^= p << 8;
+    if (*fc)
+	p = ~p;
+    p &= 0xFFFF;
+    *fc = ((p ^ d) >> 15) & 1;
+    return ife ? d | p : d ^ p;
+}
+
+#define BLITFAST_NAME blitfast_clear
+#define BLITFAST_DESC 0
+#define BLITFAST_FUNC(a,b,c) 0
+#define BLITFAST_A 0
+#define BLITFAST_B 0
+#define BLITFAST_C 0
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#define BLITFAST_NAME blitfast_desc_clear
+#define BLITFAST_DESC 1
+#define BLITFAST_FUNC(a,b,c) 0
+#define BLITFAST_A 0
+#define BLITFAST_B 0
+#define BLITFAST_C 0
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#define BLITFAST_NAME blitfast_f0
+#define BLITFAST_DESC 0
+#define BLITFAST_FUNC(a,b,c) (a)
+#define BLITFAST_A 1
+#define BLITFAST_B 0
+#define BLITFAST_C 0
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#define BLITFAST_NAME blitfast_desc_f0
+#define BLITFAST_DESC 1
+#define BLITFAST_FUNC(a,b,c) (a)
+#define BLITFAST_A 1
+#define BLITFAST_B 0
+#define BLITFAST_C 0
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#define BLITFAST_NAME blitfast_cc
+#define BLITFAST_DESC 0
+#define BLITFAST_FUNC(a,b,c) (b)
+#define BLITFAST_A 0
+#define BLITFAST_B 1
+#define BLITFAST_C 0
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#define BLITFAST_NAME blitfast_desc_cc
+#define BLITFAST_DESC 1
+#define BLITFAST_FUNC(a,b,c) (b)
+#define BLITFAST_A 0
+#define BLITFAST_B 1
+#define BLITFAST_C 0
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#define BLITFAST_NAME blitfast_ca
+#define BLITFAST_DESC 0
+#define BLITFAST_FUNC(a,b,c) ((c) ^ ((a) & ((b) ^ (c))))
+#define BLITFAST_A 1
+#define BLITFAST_B 1
+#define BLITFAST_C 1
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#define BLITFAST_NAME blitfast_desc_ca
+#define BLITFAST_DESC 1
+#define BLITFAST_FUNC(a,b,c) ((c) ^ ((a) & ((b) ^ (c))))
+#define BLITFAST_A 1
+#define BLITFAST_B 1
+#define BLITFAST_C 1
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#define BLITFAST_NAME blitfast_e2
+#define BLITFAST_DESC 0
+#define BLITFAST_FUNC(a,b,c) ((c) ^ ((b) & ((a) ^ (c))))
+#define BLITFAST_A 1
+#define BLITFAST_B 1
+#define BLITFAST_C 1
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#define BLITFAST_NAME blitfast_desc_e2
+#define BLITFAST_DESC 1
+#define BLITFAST_FUNC(a,b,c) ((c) ^ ((b) & ((a) ^ (c))))
+#define BLITFAST_A 1
+#define BLITFAST_B 1
+#define BLITFAST_C 1
+#define BLITFAST_FILL 0
+#include "blit_fast_kernel.h"
+
+#ifdef USE_SHORT_BLITTABLE
+#define BLITFAST_NAME blitfast_desc_fill_f0
+#define BLITFAST_DESC 1
+#define BLITFAST_FUNC(a,b,c) (a)
+#define BLITFAST_A 1
+#define BLITFAST_B 0
+#define BLITFAST_C 0
+#define BLITFAST_FILL 1
+#include "blit_fast_kernel.h"
+#endif
+
+typedef void blitfast_func (struct bltinfo *_GCCRES_, uae_u16 *, uae_u16 *, uae_u16 *, uae_u16 *);
+
+/* Byte range [*lo, *hi) one channel touches; 0 if it leaves chip memory */
+static __inline__ int blitfast_span (uaecptr pt, int mod, int h, int v, int desc, int *lo, int *hi)
+{
+    int row = (h * 2 + mod) * (v - 1);
+    int first = (int)pt, last = desc ? first - row : first + row;
+
+    if (pt >= BLITFAST_MEMSIZE)
+	return 0;
+    *lo = first < last ? first : last;
+    *hi = first < last ? last : first;
+    if (desc)
+	*lo -= (h - 1) * 2, *hi += 2;
+    else
+	*hi += h * 2;
+    return *lo >= 0 && *hi <= (int)BLITFAST_MEMSIZE;
+}
+
+/* A source may share D's walk, or stay clear of it. blitfunc.cpp writes
+   each D word after reading the next sources, so with a modulo of -2 a
+   row's first source word is read before the previous row's last D word
+   lands on it; the kernels store straight away. */
+static __inline__ int blitfast_apart (uaecptr pt, int mod, int lo, int hi, uaecptr ptd, int dmod, int dlo, int dhi)
+{
+    return (pt == ptd && mod == dmod && mod != -2) || hi <= dlo || dhi <= lo;
+}
+
+/* Runs the blit and returns 1, or returns 0 for blitfunc_dofast[] */
+static int blitfast_dofast (struct bltinfo *_GCCRES_ b, int mt, int desc,
+			    uaecptr pta, uaecptr ptb, uaecptr ptc, uaecptr ptd)
+{
+    const int h = b->hblitsize, v = b->vblitsize;
+    int alo = 0, ahi = 0, blo = 0, bhi = 0, clo = 0, chi = 0, dlo, dhi;
+    int usea = 0, useb = 0, usec = 0;
+    blitfast_func *f;
+
+    if (b->blitfill) {
+#ifdef USE_SHORT_BLITTABLE
+	/* blitdofast_desc_fill also reads the channels 0xF0 ignores */
+	if (mt != 0xF0 || !desc || ptb || ptc)
+	    return 0;
+	f = blitfast_desc_fill_f0;
+	usea = 1;
+#else
+	return 0;
+#endif
+    } else {
+	switch (mt) {
+	case 0x00: f = desc ? blitfast_desc_clear : blitfast_clear; break;
+	case 0xF0: f = desc ? blitfast_desc_f0 : blitfast_f0; usea = 1; break;
+	case 0xCC: f = desc ? blitfast_desc_cc : blitfast_cc; useb = 1; break;
+	case 0xCA: f = desc ? blitfast_desc_ca : blitfast_ca; usea = useb = usec = 1; break;
+	case 0xE2: f = desc ? blitfast_desc_e2 : blitfast_e2; usea = useb = usec = 1; break;
+	default: return 0;
+	}
+    }
+    if (!ptd || (usea && !pta) || (useb && !ptb) || (usec && !ptc) || h < 1 || v < 1)
+	return 0;
+    if (((pta | ptb | ptc | ptd | b->bltamod | b->bltbmod | b->bltcmod | b->bltdmod) & 1)
+	|| !blitfast_span (ptd, b->bltdmod, h, v, desc, &dlo, &dhi))
+	return 0;
+    if (usea && (!blitfast_span (pta, b->bltamod, h, v, desc, &alo, &ahi)
+		 || !blitfast_apart (pta, b->bltamod, alo, ahi, ptd, b->bltdmod, dlo, dhi)))
+	return 0;
+    if (useb && (!blitfast_span (ptb, b->bltbmod, h, v, desc, &blo, &bhi)
+		 || !blitfast_apart (ptb, b->bltbmod, blo, bhi, ptd, b->bltdmod, dlo, dhi)))
+	return 0;
+    if (usec && (!blitfast_span (ptc, b->bltcmod, h, v, desc, &clo, &chi)
+		 || !blitfast_apart (ptc, b->bltcmod, clo, chi, ptd, b->bltdmod, dlo, dhi)))
+	return 0;
+
+    f (b, (uae_u16 *)(chipmemory + pta), (uae_u16 *)(chipmemory + ptb),
+       (uae_u16 *)(chipmemory + ptc), (uae_u16 *)(chipmemory + ptd));
+    return 1;
+}
+
+#endif
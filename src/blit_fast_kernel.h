@@ -0,0 +1,111 @@
+/*
+ * One fast blitter kernel, included by blit_fast.h once per minterm and
+ * direction. The includer defines:
+ *
+ *   BLITFAST_NAME          function name
+ *   BLITFAST_DESC          1 for descending blits
+ *   BLITFAST_FUNC(a,b,c)   the minterm, as in blit.h
+ *   BLITFAST_A/_B/_C       1 for each source the minterm reads
+ *   BLITFAST_FILL          1 to run the area fill on the result
+ *
+ * Words are computed in the same order and with the same A masking, A/B
+ * shift carry (across rows too) and final bltbhold/blitzero as the
+ * blitfunc.cpp bodies. When neither source is shifted the words between
+ * the first and the last of a row are done two at a time with 32-bit
+ * loads and stores; the minterms are bitwise, so word order within the
+ * pair does not matter.
+ */
+
+#if BLITFAST_DESC
+#define BLITFAST_STEP (-1)
+#define BLITFAST_PAIR (-1)
+#define BLITFAST_SHIFT(prev, w, s) ((((uae_u32)(w) << 16) | (prev)) >> (s))
+#else
+#define BLITFAST_STEP 1
+#define BLITFAST_PAIR 0
+#define BLITFAST_SHIFT(prev, w, s) ((((uae_u32)(prev) << 16) | (w)) >> (s))
+#endif
+
+#if BLITFAST_FILL
+#define BLITFAST_FILL_WORD(d) { d = blitfast_fill (d, &fc, ife); lastd = d; }
+#else
+#define BLITFAST_FILL_WORD(d)
+#endif
+
+#define BLITFAST_WORD(mask) { \
+	uae_u32 srca = 0, srcc = 0, d; \
+	if (BLITFAST_A) { uae_u32 w = *pa & (mask); pa += BLITFAST_STEP; srca = BLITFAST_SHIFT (preva, w, sa); preva = w; } \
+	if (BLITFAST_B) { uae_u32 w = *pb; pb += BLITFAST_STEP; srcb = BLITFAST_SHIFT (prevb, w, sb); prevb = w; } \
+	if (BLITFAST_C) { srcc = *pc; pc += BLITFAST_STEP; } \
+	d = (BLITFAST_FUNC (srca, srcb, srcc)) & 0xFFFF; \
+	BLITFAST_FILL_WORD (d); \
+	*pd = d; pd += BLITFAST_STEP; \
+	totald |= d; \
+    }
+
+static void BLITFAST_NAME (struct bltinfo *_GCCRES_ b, uae_u16 *pa, uae_u16 *pb, uae_u16 *pc, uae_u16 *pd)
+{
+    const int h = b->hblitsize, v = b->vblitsize;
+    const int amod = BLITFAST_STEP * b->bltamod / 2, bmod = BLITFAST_STEP * b->bltbmod / 2;
+    const int cmod = BLITFAST_STEP * b->bltcmod / 2, dmod = BLITFAST_STEP * b->bltdmod / 2;
+#if BLITFAST_DESC
+    const int sa = b->blitdownashift, sb = b->blitdownbshift;
+#else
+    const int sa = b->blitashift, sb = b->blitbshift;
+#endif
+    const int pairs = !BLITFAST_FILL && (!BLITFAST_A || !b->blitashift) && (!BLITFAST_B || !b->blitbshift);
+    const uae_u32 firstmask = h == 1 ? b->bltafwm & b->bltalwm : b->bltafwm;
+    uae_u32 preva = 0, prevb = 0, srcb = b->bltbhold, totald = 0;
+#if BLITFAST_FILL
+    int fc = b->blitfc, ife = b->blitife;
+    uae_u32 lastd = b->bltddat;
+#endif
+    int i, j;
+
+    for (j = 0; j < v; j++) {
+	BLITFAST_WORD (firstmask);
+	if (h > 1) {
+	    i = h - 2;
+	    if (pairs) {
+		for (; i >= 2; i -= 2) {
+		    uae_u32 a2 = 0, b2 = 0, c2 = 0, d;
+		    if (BLITFAST_A) { a2 = blitfast_get32 (pa + BLITFAST_PAIR); pa += 2 * BLITFAST_STEP; }
+		    if (BLITFAST_B) { b2 = blitfast_get32 (pb + BLITFAST_PAIR); pb += 2 * BLITFAST_STEP; }
+		    if (BLITFAST_C) { c2 = blitfast_get32 (pc + BLITFAST_PAIR); pc += 2 * BLITFAST_STEP; }
+		    d = BLITFAST_FUNC (a2, b2, c2);
+		    blitfast_put32 (pd + BLITFAST_PAIR, d);
+		    pd += 2 * BLITFAST_STEP;
+		    totald |= d;
+		}
+	    }
+	    for (; i > 0; i--)
+		BLITFAST_WORD (0xFFFF);
+	    BLITFAST_WORD (b->bltalwm);
+	}
+	if (BLITFAST_A) pa += amod;
+	if (BLITFAST_B) pb += bmod;
+	if (BLITFAST_C) pc += cmod;
+	pd += dmod;
+    }
+    if (BLITFAST_B)
+	b->bltbhold = srcb;
+#if BLITFAST_FILL
+    b->blitfc = fc;
+    b->bltddat = lastd;
+#endif
+    if (totald != 0)
+	b->blitzero = 0;
+}
+
+#undef BLITFAST_WORD
+#undef BLITFAST_FILL_WORD
+#undef BLITFAST_SHIFT
+#undef BLITFAST_PAIR
+#undef BLITFAST_STEP
+#undef BLITFAST_NAME
+#undef BLITFAST_DESC
+#undef BLITFAST_FUNC
+#undef BLITFAST_A
+#undef BLITFAST_B
+#undef BLITFAST_C
+#undef BLITFAST_FILL
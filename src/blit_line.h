@@ -0,0 +1,54 @@
+/*
+ * Line mode kernels, included by blitter.cpp with USE_BLIT_LINE_KERNELS.
+ *
+ * blitter_line() goes through blitter_read(), a blit_func_tbl[] call, up
+ * to two step helpers and blitter_write() for every dot, with all the
+ * state in globals. The kernels keep it in locals for the whole line,
+ * with the octant decided once and chip memory accessed directly.
+ * Vector games draw their polygon outlines with 0x4A (XOR, SING for
+ * area fill) and plain lines with 0xCA; those two get the minterm
+ * inlined, any other goes through blit_func().
+ *
+ * The includer provides the blitter_line() state: bltcon0, bltcon1,
+ * bltapt/bltcpt/bltdpt, bltcnxlpt/bltdnxlpt, blinea, blineb,
+ * blinea_shift, blitsing, blitonedot, blitsign, bltstate, blt_info and
+ * blit_func(). bench/bench-blitline.cpp checks the kernels against
+ * blitter_line().
+ */
+
+#ifndef BLIT_LINE_H
+#define BLIT_LINE_H
+
+#if defined(USE_FAME_CORE) && !defined(UAE_MEMORY_ACCESS)
+/* chipmem_wget()/chipmem_wput() without the call */
+extern uae_u32 chipmem_mask;
+#define BLITLINE_WGET(pt) (*(uae_u16 *)(chipmemory + ((pt) & chipmem_mask)))
+#define BLITLINE_WPUT(pt, v) (*(uae_u16 *)(chipmemory + ((pt) & chipmem_mask)) = (v))
+#else
+#define BLITLINE_WGET(pt) chipmem_wget (pt)
+#define BLITLINE_WPUT(pt, v) chipmem_wput (pt, v)
+#endif
+
+#define BLITLINE_NAME blitline_4a
+#define BLITLINE_FUNC(a,b,c) ((c) ^ ((a) & ((b) | (c))))
+#include "blit_line_kernel.h"
+
+#define BLITLINE_NAME blitline_ca
+#define BLITLINE_FUNC(a,b,c) ((c) ^ ((a) & ((b) ^ (c))))
+#include "blit_line_kernel.h"
+
+#define BLITLINE_NAME blitline_any
+#define BLITLINE_FUNC(a,b,c) blit_func (a, b, c, bltcon0 & 0xFF)
+#include "blit_line_kernel.h"
+
+/* Draws the whole line set up by blit_init() */
+static void blitline_do (void)
+{
+    switch (bltcon0 & 0xFF) {
+    case 0x4A: blitline_4a (); break;
+    case 0xCA: blitline_ca (); break;
+    default: blitline_any (); break;
+    }
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * One line mode kernel, included by blit_line.h once per minterm. The
+ * includer defines:
+ *
+ *   BLITLINE_NAME          function name
+ *   BLITLINE_FUNC(a,b,c)   the minterm, as in blit.h
+ *
+ * Does what blitter_line() does, dot for dot: read C, the minterm on the
+ * shifted A dot (cleared after the first dot of a row with SING), the B
+ * pattern bit and C, the error term and octant steps, then the D write
+ * to the previous position, so a C read of the next dot sees it.
+ */
+
+static void BLITLINE_NAME (void)
+{
+    const int usec = bltcon0 & 0x200, used = bltcon0 & 0x100, sing = blitsing;
+    const uae_u32 amod = (uae_s16)blt_info.bltamod, bmod = (uae_s16)blt_info.bltbmod;
+    const uae_u32 ystep = (bltcon1 & 0x10 ? bltcon1 & 0x8 : bltcon1 & 0x4) ? -blt_info.bltcmod : blt_info.bltcmod;
+    const int xmajor = bltcon1 & 0x10;
+    const int xdown = xmajor ? bltcon1 & 0x4 : bltcon1 & 0x8;
+    const uae_u32 a = blinea;
+    uae_u32 apt = bltapt, cpt = bltcpt, dpt = bltdpt, cnx = bltcnxlpt, dnx = bltdnxlpt;
+    uae_u32 c = blt_info.bltcdat, b = blineb, d = 0, totald = 0;
+    int shift = blinea_shift, sign = blitsign, onedot = blitonedot;
+    int n = blt_info.vblitsize;
+
+    do {
+	int ystepped;
+
+	if (usec)
+	    c = BLITLINE_WGET (cpt);
+	d = (BLITLINE_FUNC ((sing && onedot) ? 0 : (a >> shift), (b & 1) ? 0xFFFF : 0, c)) & 0xFFFF;
+	/* the x and y steps; sign clear takes the minor one too */
+	ystepped = !xmajor || !sign;
+	if (!sign) {
+	    apt += amod;
+	    if (!xmajor) {
+		if (xdown) {
+		    if (shift-- == 0) { shift = 15; cnx -= 2; dnx -= 2; }
+		} else {
+		    if (++shift == 16) { shift = 0; cnx += 2; dnx += 2; }
+		}
+	    }
+	} else
+	    apt += bmod;
+	if (xmajor) {
+	    if (xdown) {
+		if (shift-- == 0) { shift = 15; cnx -= 2; dnx -= 2; }
+	    } else {
+		if (++shift == 16) { shift = 0; cnx += 2; dnx += 2; }
+	    }
+	}
+	if (ystepped) {
+	    cnx += ystep;
+	    dnx += ystep;
+	}
+	onedot = !ystepped;
+	sign = 0 > (uae_s16)apt;
+	totald |= d;
+	if (used)
+	    BLITLINE_WPUT (dpt, d);
+	cpt = cnx;
+	dpt = dnx;
+	b = ((b << 1) | (b >> 15)) & 0xFFFF;
+    } while (--n);
+
+    bltapt = apt;
+    bltcpt = cpt;
+    bltdpt = dpt;
+    bltcnxlpt = cnx;
+    bltdnxlpt = dnx;
+    blt_info.bltcdat = c;
+    blt_info.bltddat = d;
+    blt_info.vblitsize = 0;
+    if (totald)
+	blt_info.blitzero = 0;
+    blinea_shift = shift;
+    blineb = b;
+    blitsign = sign;
+    blitonedot = onedot;
+    bltstate = BLT_done;
+}
+
+#undef BLITLINE_NAME
+#undef BLITLINE_FUNC
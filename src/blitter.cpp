@@ -23,6 +23,18 @@
 #include "m68k/m68k_intrf.h"
 #include "blitter.h"
 
+#if defined(USE_BLIT_FAST_KERNELS) && (!defined(USE_FAME_CORE) || defined(UAE_MEMORY_ACCESS))
+/* The kernels read chipmemory directly; chipmem_wget() byte swaps */
+#undef USE_BLIT_FAST_KERNELS
+#endif
+#ifdef USE_BLIT_FAST_KERNELS
+#include "blit_fast.h"
+#endif
+#ifdef USE_BLIT_TRACE
+#include <sys/time.h>
+#include "blittrace.h"
+#endif
+
 #ifdef USE_BLITTER_EXTRA_INLINE
 #define _INLINE_ __inline__
 #else
@@ -58,6 +70,13 @@ static long int bltwait;
 
 struct bltinfo blt_info;
 
+#ifdef USE_BLITTER_CHUNKS
+/* Area blits run a few rows per ev_blitter event, see blitter_event().
+   blit_rows_left counts the rows not done yet; blitter_dofast() only
+   ends the blit when none are left. */
+static int blit_rows_left, blit_chunk_rows, blit_row_cycles, blit_startup_cycles;
+#endif
+
 uae_u8 blit_filltable[256][4][2];
 static uae_u16 blit_trashtable[BLITTER_MAX_WORDS];
 enum blitter_states bltstate;
@@ -240,6 +259,14 @@ static void blitter_dofast(void)
     print_bltinfo(&blt_info);
 #endif
 
+#ifdef USE_BLIT_FAST_KERNELS
+#ifndef USE_LARGE_BLITFUNC
+    if (!blitfast_dofast (&blt_info, bltcon0 & 0xFF, 0, blt_info.pta, blt_info.ptb, blt_info.ptc, blt_info.ptd))
+#else
+    if (!blitfast_dofast (&blt_info, bltcon0 & 0xFF, 0, bltadatptr, bltbdatptr, bltcdatptr, bltddatptr))
+#endif
+    {
+#endif
 #ifdef USE_SHORT_BLITTABLE
     if (!blt_info.blitfill)
     {
@@ -263,11 +290,18 @@ static void blitter_dofast(void)
 #endif
     }
 #endif
+#ifdef USE_BLIT_FAST_KERNELS
+    }
+#endif
 #ifdef USE_BLIT_MASKTABLE
     blit_masktable[0] = 0xFFFF;
     blit_masktable[blt_info.hblitsize - 1] = 0xFFFF;
 #endif
 
+#ifdef USE_BLITTER_CHUNKS
+    if (blit_rows_left)
+	return;
+#endif
     bltstate = BLT_done;
     blitter_done_notify ();
 }
@@ -345,6 +379,14 @@ static void blitter_dofast_desc(void)
     print_bltinfo(&blt_info);
 #endif
 
+#ifdef USE_BLIT_FAST_KERNELS
+#ifndef USE_LARGE_BLITFUNC
+    if (!blitfast_dofast (&blt_info, bltcon0 & 0xFF, 1, blt_info.pta, blt_info.ptb, blt_info.ptc, blt_info.ptd))
+#else
+    if (!blitfast_dofast (&blt_info, bltcon0 & 0xFF, 1, bltadatptr, bltbdatptr, bltcdatptr, bltddatptr))
+#endif
+    {
+#endif
 #ifdef USE_SHORT_BLITTABLE
     if (!blt_info.blitfill)
     {
@@ -368,11 +410,18 @@ static void blitter_dofast_desc(void)
 #endif
     }
 #endif
+#ifdef USE_BLIT_FAST_KERNELS
+    }
+#endif
 #ifdef USE_BLIT_MASKTABLE
     blit_masktable[0] = 0xFFFF;
     blit_masktable[blt_info.hblitsize - 1] = 0xFFFF;
 #endif
 
+#ifdef USE_BLITTER_CHUNKS
+    if (blit_rows_left)
+	return;
+#endif
     bltstate = BLT_done;
     blitter_done_notify ();
 }
@@ -463,6 +512,10 @@ extern blit_func_tbl_t blit_func_tbl[0x100];
 uae_u32 blit_func(uae_u32 srca, uae_u32 srcb, uae_u32 srcc, uae_u8 mt);
 #endif
 
+#ifdef USE_BLIT_LINE_KERNELS
+#include "blit_line.h"
+#endif
+
 static void blitter_line(void)
 {
 	do {
@@ -523,6 +576,227 @@ static void blitter_line(void)
 	} while (bltstate != BLT_done);
 }
 
+#ifdef USE_BLIT_TRACE
+
+extern unsigned int uae4all_numframes;
+
+struct blit_hist {
+    unsigned count;
+    unsigned long long ticks, words;
+};
+
+enum { BLIT_MODE_ASC, BLIT_MODE_DESC, BLIT_MODE_FILL, BLIT_MODE_LINE, BLIT_MODE_SING, BLIT_MODES };
+static const char *blit_mode_name[BLIT_MODES] = { "ascending", "descending", "fill", "line", "line SING" };
+
+/* Size buckets: words (area) or dots (line), bucket n holds up to 2^n */
+#define BLIT_SIZE_BUCKETS 21
+
+static struct blit_hist blit_hist_area[256], blit_hist_line[256];
+static struct blit_hist blit_hist_mode[BLIT_MODES], blit_hist_channels[16];
+static struct blit_hist blit_hist_size[BLIT_SIZE_BUCKETS];
+static unsigned blit_hist_shifted;
+
+static struct blit_trace_record blit_trace_cur;
+static FILE *blit_trace_file;
+static unsigned blit_trace_count;
+
+/* Unwrapped tick clock against gettimeofday, as in profiler.cpp */
+static unsigned long long blit_trace_clock, blit_trace_clock0, blit_trace_usec0;
+static unsigned blit_trace_last_ticks;
+
+static unsigned long long blit_trace_usec (void)
+{
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return (unsigned long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static unsigned long long blit_trace_advance (void)
+{
+    unsigned t = uae4all_prof_ticks ();
+    blit_trace_clock += (unsigned)(t - blit_trace_last_ticks);
+    blit_trace_last_ticks = t;
+    return blit_trace_clock;
+}
+
+static double blit_trace_ticks_per_us (void)
+{
+    unsigned long long dus = blit_trace_usec () - blit_trace_usec0;
+    unsigned long long dt = blit_trace_advance () - blit_trace_clock0;
+    return dus && dt ? (double)dt / dus : 1.0;
+}
+
+/* Clears the histograms; with a file name also starts a trace file */
+int blit_trace_start (const char *filename)
+{
+    struct blit_trace_header h;
+
+    blit_trace_stop ();
+    memset (blit_hist_area, 0, sizeof blit_hist_area);
+    memset (blit_hist_line, 0, sizeof blit_hist_line);
+    memset (blit_hist_mode, 0, sizeof blit_hist_mode);
+    memset (blit_hist_channels, 0, sizeof blit_hist_channels);
+    memset (blit_hist_size, 0, sizeof blit_hist_size);
+    blit_hist_shifted = 0;
+    blit_trace_count = 0;
+    blit_trace_clock0 = blit_trace_advance ();
+    blit_trace_usec0 = blit_trace_usec ();
+    if (!filename)
+	return 1;
+    if (!(blit_trace_file = fopen (filename, "wb"))) {
+	write_log ("blit trace: can't create %s\n", filename);
+	return 0;
+    }
+    h.magic = BLIT_TRACE_MAGIC;
+    h.version = BLIT_TRACE_VERSION;
+    h.record_size = sizeof (struct blit_trace_record);
+    h.ticks_per_ms = 0;
+    fwrite (&h, sizeof h, 1, blit_trace_file);
+    return 1;
+}
+
+void blit_trace_stop (void)
+{
+    struct blit_trace_header h;
+
+    if (!blit_trace_file)
+	return;
+    h.magic = BLIT_TRACE_MAGIC;
+    h.version = BLIT_TRACE_VERSION;
+    h.record_size = sizeof (struct blit_trace_record);
+    h.ticks_per_ms = (uae_u32)(blit_trace_ticks_per_us () * 1000 + 0.5);
+    fseek (blit_trace_file, 0, SEEK_SET);
+    fwrite (&h, sizeof h, 1, blit_trace_file);
+    fclose (blit_trace_file);
+    blit_trace_file = NULL;
+}
+
+static void blit_hist_add (struct blit_hist *h, unsigned ticks, unsigned words)
+{
+    h->count++;
+    h->ticks += ticks;
+    h->words += words;
+}
+
+static void blit_hist_print (const char *name, struct blit_hist *h, double rate)
+{
+    printf ("  %-12s %8u blits %7.1f%% %10.3f ms %8.3f us/blit %8.1f words/blit\n", name, h->count,
+	    blit_trace_count ? 100.0 * h->count / blit_trace_count : 0.0, h->ticks / rate / 1000,
+	    h->count ? h->ticks / rate / h->count : 0.0, h->count ? (double)h->words / h->count : 0.0);
+}
+
+static void blit_hist_print_minterms (const char *title, struct blit_hist *hist, double rate)
+{
+    int order[256], i, j, n = 0;
+
+    for (i = 0; i < 256; i++)
+	if (hist[i].count)
+	    order[n++] = i;
+    /* most host time first */
+    for (i = 1; i < n; i++)
+	for (j = i; j > 0 && hist[order[j]].ticks > hist[order[j - 1]].ticks; j--) {
+	    int t = order[j];
+	    order[j] = order[j - 1];
+	    order[j - 1] = t;
+	}
+    if (n)
+	printf (" %s:\n", title);
+    for (i = 0; i < n; i++) {
+	char name[16];
+	sprintf (name, "%02x", order[i]);
+	blit_hist_print (name, &hist[order[i]], rate);
+    }
+}
+
+void blit_trace_show (void)
+{
+    double rate = blit_trace_ticks_per_us ();
+    char name[16];
+    int i;
+
+    printf ("BLITTER: %u blits, %u with A/B shift\n", blit_trace_count, blit_hist_shifted);
+    blit_hist_print_minterms ("area blits by minterm", blit_hist_area, rate);
+    blit_hist_print_minterms ("line blits by minterm", blit_hist_line, rate);
+    printf (" by mode:\n");
+    for (i = 0; i < BLIT_MODES; i++)
+	if (blit_hist_mode[i].count)
+	    blit_hist_print (blit_mode_name[i], &blit_hist_mode[i], rate);
+    printf (" area blits by channels:\n");
+    for (i = 0; i < 16; i++)
+	if (blit_hist_channels[i].count) {
+	    sprintf (name, "%c%c%c%c", i & 8 ? 'A' : '-', i & 4 ? 'B' : '-', i & 2 ? 'C' : '-', i & 1 ? 'D' : '-');
+	    blit_hist_print (name, &blit_hist_channels[i], rate);
+	}
+    printf (" by size (words, line dots):\n");
+    for (i = 0; i < BLIT_SIZE_BUCKETS; i++)
+	if (blit_hist_size[i].count) {
+	    sprintf (name, "<= %u", 1u << i);
+	    blit_hist_print (name, &blit_hist_size[i], rate);
+	}
+}
+
+static void blit_trace_init (void)
+{
+    struct blit_trace_record *r = &blit_trace_cur;
+
+    r->frame = uae4all_numframes;
+    r->ticks = 0;
+    r->bltapt = bltapt;
+    r->bltbpt = bltbpt;
+    r->bltcpt = bltcpt;
+    r->bltdpt = bltdpt;
+    r->bltcon0 = bltcon0;
+    r->bltcon1 = bltcon1;
+    r->hblitsize = blt_info.hblitsize;
+    r->vblitsize = blt_info.vblitsize;
+    r->bltamod = blt_info.bltamod;
+    r->bltbmod = blt_info.bltbmod;
+    r->bltcmod = blt_info.bltcmod;
+    r->bltdmod = blt_info.bltdmod;
+    r->bltafwm = blt_info.bltafwm;
+    r->bltalwm = blt_info.bltalwm;
+    r->bltadat = blt_info.bltadat;
+    r->bltbdat = blt_info.bltbdat;
+    r->bltcdat = blt_info.bltcdat;
+    r->bltbhold = blt_info.bltbhold;
+}
+
+#ifdef USE_BLITTER_CHUNKS
+static void blit_trace_add (unsigned ticks)
+{
+    blit_trace_cur.ticks += ticks;
+}
+#endif
+
+static void blit_trace_done (unsigned ticks)
+{
+    struct blit_trace_record *r = &blit_trace_cur;
+    int line = r->bltcon1 & 1, mode;
+    unsigned words = line ? r->vblitsize : r->hblitsize * r->vblitsize;
+    int bucket = 0;
+
+    ticks = r->ticks += ticks;
+    blit_trace_count++;
+    while (bucket < BLIT_SIZE_BUCKETS - 1 && words > (1u << bucket))
+	bucket++;
+    if (line) {
+	mode = r->bltcon1 & 2 ? BLIT_MODE_SING : BLIT_MODE_LINE;
+	blit_hist_add (&blit_hist_line[r->bltcon0 & 0xFF], ticks, words);
+    } else {
+	mode = r->bltcon1 & 0x18 ? BLIT_MODE_FILL : r->bltcon1 & 2 ? BLIT_MODE_DESC : BLIT_MODE_ASC;
+	blit_hist_add (&blit_hist_area[r->bltcon0 & 0xFF], ticks, words);
+	blit_hist_add (&blit_hist_channels[(r->bltcon0 >> 8) & 15], ticks, words);
+	if ((r->bltcon0 | r->bltcon1) & 0xF000)
+	    blit_hist_shifted++;
+    }
+    blit_hist_add (&blit_hist_mode[mode], ticks, words);
+    blit_hist_add (&blit_hist_size[bucket], ticks, words);
+    if (blit_trace_file)
+	fwrite (r, sizeof *r, 1, blit_trace_file);
+}
+
+#endif
+
 typedef void (*actually_do_blit_func)(void);
 static actually_do_blit_func actually_do_blit=blitter_dofast;
 
@@ -537,7 +811,11 @@ static _INLINE_ void blit_init(void)
     blt_info.blitdownbshift = 16 - blt_info.blitbshift;
 
     if (blitline) {
+#ifdef USE_BLIT_LINE_KERNELS
+	actually_do_blit=blitline_do;
+#else
 	actually_do_blit=blitter_line;
+#endif
 	if (blt_info.hblitsize != 2)
 	    write_log ("weird hblitsize in linemode: %d\n", blt_info.hblitsize);
 
@@ -589,6 +867,9 @@ static _INLINE_ void blit_init(void)
 	dbgf("blit_init blitfc=0x%X, blitife=0x%X, blitfill=0x%X, blitdesc=0x%X\n",blt_info.blitfc,blt_info.blitife,blt_info.blitfill,blitdesc);
 #endif
     }
+#ifdef USE_BLIT_TRACE
+    blit_trace_init ();
+#endif
 }
 
 #if 0
@@ -608,9 +889,34 @@ static _INLINE_ void actually_do_blit(void)
 #endif
 
 
+#ifdef USE_BLITTER_CHUNKS
+static void blitter_do_rows(int rows)
+{
+    int vblitsize = blt_info.vblitsize;
+
+    /* blitter_dofast() steps the pointers by vblitsize rows */
+    blit_rows_left -= rows;
+    blt_info.vblitsize = rows;
+    actually_do_blit();
+    blt_info.vblitsize = vblitsize;
+}
+#endif
+
+/* Whatever is left of the blit, all at once */
+static __inline__ void blitter_do_rest(void)
+{
+#ifdef USE_BLITTER_CHUNKS
+    if (blit_rows_left) {
+	blitter_do_rows (blit_rows_left);
+	return;
+    }
+#endif
+    actually_do_blit();
+}
+
 void blitter_handler(void)
 {
-	uae4all_prof_start(6);
+	uae4all_prof_start(UAE4ALL_PROF_BLITTER);
 #ifdef DEBUG_BLITTER
     dbg(" blitter_handler(void)");
 #endif
@@ -621,16 +927,26 @@ void blitter_handler(void)
 	eventtab[ev_blitter].active = 1;
 	eventtab[ev_blitter].oldcycles = get_cycles ();
 	eventtab[ev_blitter].evtime = 10 * CYCLE_UNIT + get_cycles (); /* wait a little */
-	uae4all_prof_end(6);
+	event_changed (ev_blitter);
+	uae4all_prof_end(UAE4ALL_PROF_BLITTER);
 	return; /* gotta come back later. */
     }
-    actually_do_blit();
+#ifdef USE_BLIT_TRACE
+    {
+	unsigned t = uae4all_prof_ticks ();
+	blitter_do_rest();
+	blit_trace_done (uae4all_prof_ticks () - t);
+    }
+#else
+    blitter_do_rest();
+#endif
 
     INTREQ(0x8040);
 
     eventtab[ev_blitter].active = 0;
+    event_changed (ev_blitter);
     unset_special (SPCFLAG_BLTNASTY);
-    uae4all_prof_end(6);
+    uae4all_prof_end(UAE4ALL_PROF_BLITTER);
 }
 
 static uae_u8 blit_cycle_diagram_start[][10] =
@@ -658,11 +974,89 @@ static long blit_first_cycle;
 static int blit_last_cycle;
 static uae_u8 *blit_diag;
 
+#ifdef USE_BLITTER_CHUNKS
+/* The blitfunc bodies write each D word after reading the next sources,
+   so between two calls the last D word of a row lands before the first
+   source words of the next row are read, not after. Returns 1 if some
+   source would read that D word at a row boundary. */
+static int blit_chunk_overlap(uaecptr pt, int mod, int desc)
+{
+    int sd = blt_info.hblitsize * 2 + blt_info.bltdmod;
+    int step = blt_info.hblitsize * 2 + mod - sd;
+    int k = (desc ? (int)(pt - bltdpt) : (int)(bltdpt - pt)) - blt_info.bltdmod - 2;
+
+    if (!step)
+	return k == 0;
+    return k % step == 0 && k / step >= 1 && k / step < blt_info.vblitsize;
+}
+
+/* Times the area blit from blit_cycle_diagram_start: the startup cycles,
+   then the steady state cycles per word. Unshifted blits are cut in
+   chunks of about a scanline's worth of rows; with an A or B shift the
+   carry into a row would restart with each blitfunc call, so those run
+   whole, when their last row is due. */
+static int blit_chunk_init(void)
+{
+    int desc = bltcon1 & 2;
+
+    blit_row_cycles = blit_diag[1] * blt_info.hblitsize;
+    blit_startup_cycles = blit_diag[0];
+    blit_rows_left = blt_info.vblitsize;
+    blit_chunk_rows = MAXHPOS / blit_row_cycles;
+    if (blit_chunk_rows < 1)
+	blit_chunk_rows = 1;
+    if (blt_info.blitashift || blt_info.blitbshift
+	|| ((bltcon0 & 0x100) && (((bltcon0 & 0x800) && blit_chunk_overlap (bltapt, blt_info.bltamod, desc))
+				  || ((bltcon0 & 0x400) && blit_chunk_overlap (bltbpt, blt_info.bltbmod, desc))
+				  || ((bltcon0 & 0x200) && blit_chunk_overlap (bltcpt, blt_info.bltcmod, desc)))))
+	blit_chunk_rows = blit_rows_left;
+    return blit_startup_cycles + blit_chunk_rows * blit_row_cycles;
+}
+
+/* ev_blitter for area blits: the rows due by now, then sleep until the
+   next chunk is due. BBUSY stays set meanwhile; a blitter register
+   write or a savestate goes through blitter_handler() and finishes the
+   blit at once. */
+void blitter_event(void)
+{
+    int done, rows;
+
+    if (!blit_rows_left || !dmaen(DMA_BLITTER)) {
+	blitter_handler ();
+	return;
+    }
+    done = blt_info.vblitsize - blit_rows_left;
+    rows = ((long)(get_cycles () - blit_first_cycle) / CYCLE_UNIT - blit_startup_cycles) / blit_row_cycles - done;
+    if (rows >= blit_rows_left) {
+	blitter_handler ();
+	return;
+    }
+    if (rows < 1)
+	rows = 1;
+    uae4all_prof_start(UAE4ALL_PROF_BLITTER);
+#ifdef USE_BLIT_TRACE
+    {
+	unsigned t = uae4all_prof_ticks ();
+	blitter_do_rows (rows);
+	blit_trace_add (uae4all_prof_ticks () - t);
+    }
+#else
+    blitter_do_rows (rows);
+#endif
+    done += rows;
+    eventtab[ev_blitter].oldcycles = get_cycles ();
+    eventtab[ev_blitter].evtime = blit_first_cycle
+	+ (blit_startup_cycles + (done + blit_chunk_rows) * blit_row_cycles) * CYCLE_UNIT;
+    event_changed (ev_blitter);
+    uae4all_prof_end(UAE4ALL_PROF_BLITTER);
+}
+#endif
+
 void do_blitter(void)
 {
     extern int mainMenu_throttle;
     int blit_cycles;
-    uae4all_prof_start(6);
+    uae4all_prof_start(UAE4ALL_PROF_BLITTER);
 #ifdef DEBUG_BLITTER
     dbg("DO_BLITTER");
 #endif
@@ -685,6 +1079,11 @@ void do_blitter(void)
 #endif
 
     blit_init();
+#ifdef USE_BLITTER_CHUNKS
+    blit_rows_left = 0;
+    if (!(bltcon1 & 1))
+	blit_cycles = blit_chunk_init();
+#endif
 
     eventtab[ev_blitter].active = 1;
 #ifdef DEBUG_BLITTER
@@ -692,6 +1091,7 @@ void do_blitter(void)
 #endif
     eventtab[ev_blitter].oldcycles = get_cycles ();
     eventtab[ev_blitter].evtime = blit_cycles *  CYCLE_UNIT + get_cycles ();
+    event_changed (ev_blitter);
     events_schedule();
 
 #ifdef DEBUG_BLITTER
@@ -702,7 +1102,7 @@ void do_blitter(void)
     else
     	unset_special (SPCFLAG_BLTNASTY);
 
-    uae4all_prof_end(6);
+    uae4all_prof_end(UAE4ALL_PROF_BLITTER);
 }
 
 #ifdef USE_MAYBE_BLIT
@@ -727,7 +1127,7 @@ void maybe_blit (int modulo)
 
 int blitnasty (void)
 {
-    uae4all_prof_start(6);
+    uae4all_prof_start(UAE4ALL_PROF_BLITTER);
 #ifdef DEBUG_BLITTER
     dbgf("blitnasty -> bltstate=0x%X, dmaen=0x%X\n",bltstate,dmaen(DMA_BLITTER));
 #endif
@@ -756,6 +1156,6 @@ int blitnasty (void)
 	    return 0;
 	ccnt++;
     }
-    uae4all_prof_end(6);
+    uae4all_prof_end(UAE4ALL_PROF_BLITTER);
     return ccnt;
 }
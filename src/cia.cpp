@@ -245,15 +245,16 @@ void CIA_calctimers (void)
 	if (ciabtimeb != -1 && ciabtimeb < ciatime) ciatime = ciabtimeb;
 	eventtab[ev_cia].evtime = ciatime + get_cycles ();
     }
+    event_changed (ev_cia);
     events_schedule();
 }
 
 void CIA_handler (void)
 {
-    uae4all_prof_start(5);
+    uae4all_prof_start(UAE4ALL_PROF_CIA);
     CIA_update ();
     CIA_calctimers ();
-    uae4all_prof_end(5);
+    uae4all_prof_end(UAE4ALL_PROF_CIA);
 }
 
 void cia_diskindex (void)
@@ -264,7 +265,7 @@ void cia_diskindex (void)
 
 void CIA_hsync_handler (void)
 {
-    uae4all_prof_start(5);
+    uae4all_prof_start(UAE4ALL_PROF_CIA);
     static unsigned int keytime = 0, sleepyhead = 0;
 
     if (ciabtodon)
@@ -311,12 +312,12 @@ void CIA_hsync_handler (void)
 	} else if (!(++sleepyhead & 15))
 	    ciaasdr_unread = 0;          /* give up on this key event after unread for a long time */
     }
-    uae4all_prof_end(5);
+    uae4all_prof_end(UAE4ALL_PROF_CIA);
 }
 
 void CIA_vsync_handler ()
 {
-    uae4all_prof_start(5);
+    uae4all_prof_start(UAE4ALL_PROF_CIA);
     if (ciaatodon)
 	ciaatod++;
     ciaatod &= 0xFFFFFF;
@@ -324,7 +325,7 @@ void CIA_vsync_handler ()
 	ciaaicr |= 4;
 	RethinkICRA();
     }
-    uae4all_prof_end(5);
+    uae4all_prof_end(UAE4ALL_PROF_CIA);
 }
 
 static uae_u8 ReadCIAA (unsigned int addr)
@@ -695,6 +696,7 @@ void CIA_reset (void)
         /* Synchronize event timing */
         eventtab[ev_cia].oldcycles = get_cycles ();
         eventtab[ev_cia].active = 0;  /* Will be set by CIA_calctimers */
+        event_changed (ev_cia);
     }
 
     CIA_calctimers ();
@@ -131,6 +131,11 @@ unsigned int joy0dir, joy1dir;
 
 unsigned long int currcycle, nextevent;
 struct ev eventtab[ev_max];
+#ifdef USE_EVENT_QUEUE
+int event_queue[ev_max];
+int event_queue_pos[ev_max] = { -1, -1, -1, -1, -1, -1 };
+int event_queue_len;
+#endif
 
 static int vpos;
 #ifdef USE_CYCLONE_CORE
@@ -933,7 +938,7 @@ static _INLINE_ void long_fetch_ecs1(int nwords)
 
 static _INLINE_ void do_long_fetch (int nwords)
 {
-    uae4all_prof_start(10);
+    uae4all_prof_start(UAE4ALL_PROF_LONG_FETCH);
     flush_display ();
     if (out_nbits & 15)
 	    long_fetch_ecs0(nwords);
@@ -945,7 +950,7 @@ static _INLINE_ void do_long_fetch (int nwords)
 
     if (toscr_nr_planes > 0)
 	fetch_state = fetch_was_plane0;
-    uae4all_prof_end(10);
+    uae4all_prof_end(UAE4ALL_PROF_LONG_FETCH);
 }
 
 
@@ -1111,9 +1116,9 @@ static __inline__ void decide_fetch (int hpos)
 {
     if (fetch_state != fetch_not_started && hpos > last_fetch_hpos)
     {
-    	    uae4all_prof_start(8);
+    	    uae4all_prof_start(UAE4ALL_PROF_UPDATE_FETCH);
 	    update_fetch(hpos);
-    	    uae4all_prof_end(8);
+    	    uae4all_prof_end(UAE4ALL_PROF_UPDATE_FETCH);
     }
     last_fetch_hpos = hpos;
 }
@@ -1813,6 +1818,7 @@ static _INLINE_ void start_copper (void)
 {
     int was_active = eventtab[ev_copper].active;
     eventtab[ev_copper].active = 0;
+    event_changed (ev_copper);
     if (was_active)
 	events_schedule ();
 
@@ -1860,6 +1866,7 @@ static _INLINE_ void DMACON (uae_u16 v, int hpos)
      * bit in these cases. */
     if ((dmacon & DMA_COPPER) != (oldcon & DMA_COPPER)) {
 	eventtab[ev_copper].active = 0;
+	event_changed (ev_copper);
     }
     if ((dmacon & DMA_COPPER) > (oldcon & DMA_COPPER)) {
 	cop_state.ip = cop1lc;
@@ -1994,7 +2001,7 @@ static void __inline__ custom_fame_raise(int n_int)
 
 static _INLINE_ void SET_INTERRUPT(void)
 {
-    uae4all_prof_start(14);
+    uae4all_prof_start(UAE4ALL_PROF_INTERRUPT);
 #ifdef DEBUG_INTERRUPTS
     dbgf("SET_INTERRUPT intreq=0x%X, intena=0x%X\n",intreq,intena);
 #endif
@@ -2110,7 +2117,7 @@ static _INLINE_ void SET_INTERRUPT(void)
 #else
     set_special (SPCFLAG_INT);
 #endif
-    uae4all_prof_end(14);
+    uae4all_prof_end(UAE4ALL_PROF_INTERRUPT);
 }
 #endif // CYCLONE
 /*static int trace_intena = 0;*/
@@ -2776,6 +2783,7 @@ static _INLINE_ void predict_copper (void)
 	eventtab[ev_copper].active = 1;
 	eventtab[ev_copper].oldcycles = get_cycles ();
 	eventtab[ev_copper].evtime = get_cycles () + cycle_count * CYCLE_UNIT;
+	event_changed (ev_copper);
 	events_schedule ();
     }
 }
@@ -2822,7 +2830,7 @@ static int isagnus[]= {
 
 static _INLINE_ void update_copper (int until_hpos)
 {
-    uae4all_prof_start(3);
+    uae4all_prof_start(UAE4ALL_PROF_COPPER);
 #ifdef DEBUG_CUSTOM
     dbgf("update_copper(%i)\n",until_hpos);
 #endif
@@ -2831,13 +2839,13 @@ static _INLINE_ void update_copper (int until_hpos)
 
     if (eventtab[ev_copper].active)
     {
-	uae4all_prof_end(3);
+	uae4all_prof_end(UAE4ALL_PROF_COPPER);
 	return;
     }
 
     if (cop_state.state == COP_wait && vp < cop_state.vcmp)
     {
-	uae4all_prof_end(3);
+	uae4all_prof_end(UAE4ALL_PROF_COPPER);
 	return;
     }
 
@@ -2921,7 +2929,7 @@ static _INLINE_ void update_copper (int until_hpos)
 
 	switch (cop_state.state) {
 	case COP_read1_wr_in4:
-	    uae4all_prof_end(3);
+	    uae4all_prof_end(UAE4ALL_PROF_COPPER);
 	    return;
 
 	case COP_read1_wr_in2:
@@ -2932,7 +2940,7 @@ static _INLINE_ void update_copper (int until_hpos)
 	    break;
 
 	case COP_read2_wr_in2:
-	    uae4all_prof_end(3);
+	    uae4all_prof_end(UAE4ALL_PROF_COPPER);
 	    return;
 
 	case COP_read2:
@@ -3000,7 +3008,7 @@ static _INLINE_ void update_copper (int until_hpos)
 	case COP_wait:
 	    if (vp < cop_state.vcmp)
 	    {
-		uae4all_prof_end(3);
+		uae4all_prof_end(UAE4ALL_PROF_COPPER);
 		return;
 	    }
 
@@ -3012,7 +3020,7 @@ static _INLINE_ void update_copper (int until_hpos)
 		    /* This will leave c_hpos untouched if it's equal to wait_finish.  */
 		    if (wait_finish < c_hpos)
 		    {
-			uae4all_prof_end(3);
+			uae4all_prof_end(UAE4ALL_PROF_COPPER);
 			return;
 		    }
 		    else if (wait_finish <= until_hpos) {
@@ -3046,7 +3054,7 @@ static _INLINE_ void update_copper (int until_hpos)
 
     if ((_68k_spcflags & SPCFLAG_COPPER) && c_hpos + 8 < maxhpos)
 	predict_copper ();
-    uae4all_prof_end(3);
+    uae4all_prof_end(UAE4ALL_PROF_COPPER);
 }
 
 static _INLINE_ void compute_spcflag_copper (void)
@@ -3078,6 +3086,7 @@ static void copper_handler (void)
 	return;
 
     eventtab[ev_copper].active = 0;
+    event_changed (ev_copper);
 }
 
 void blitter_done_notify (void)
@@ -3117,6 +3126,7 @@ static __inline__ void sync_copper_with_cpu (int hpos, int do_schedule, unsigned
 	}
 
 	eventtab[ev_copper].active = 0;
+	event_changed (ev_copper);
 	if (do_schedule)
 	    events_schedule ();
         setcopper();
@@ -3292,7 +3302,7 @@ static int vsync_handler_cnt_disk_change=0;
 
 static void vsync_handler (void)
 {
-    uae4all_prof_start(7);
+    uae4all_prof_start(UAE4ALL_PROF_VSYNC);
 #ifdef DEBUG_CUSTOM
     dbg("vsync_handler");
 #endif
@@ -3302,6 +3312,11 @@ static void vsync_handler (void)
 
 //    n_frames++;
 
+#ifdef USE_AUDIO_TIMELINE
+    if (produce_sound)
+	audio_timeline_render ();
+#endif
+
     {
 	static int back_joy0button=0;
     	handle_events ();
@@ -3329,7 +3344,7 @@ static void vsync_handler (void)
 
     if (quit_program > 0)
     {
-	uae4all_prof_end(7);
+	uae4all_prof_end(UAE4ALL_PROF_VSYNC);
 	return;
     }
 
@@ -3363,12 +3378,12 @@ static void vsync_handler (void)
     if (ievent_alive > 0)
 	ievent_alive--;
     CIA_vsync_handler ();
-    uae4all_prof_end(7);
+    uae4all_prof_end(UAE4ALL_PROF_VSYNC);
 }
 
 static void hsync_handler (void)
 {
-    uae4all_prof_start(2);
+    uae4all_prof_start(UAE4ALL_PROF_HSYNC);
 #ifdef DEBUG_CUSTOM
     dbg("hsync_handler");
 #endif
@@ -3383,6 +3398,7 @@ static void hsync_handler (void)
 
     eventtab[ev_hsync].evtime += get_cycles () - eventtab[ev_hsync].oldcycles;
     eventtab[ev_hsync].oldcycles = get_cycles ();
+    event_changed (ev_hsync);
     CIA_hsync_handler ();
 
     if (produce_sound)
@@ -3431,7 +3447,7 @@ static void hsync_handler (void)
     /* See if there's a chance of a copper wait ending this line.  */
     cop_state.hpos = 0;
     compute_spcflag_copper ();
-    uae4all_prof_end(2);
+    uae4all_prof_end(UAE4ALL_PROF_HSYNC);
 }
 
 static _INLINE_ void init_regtypes (void)
@@ -3493,16 +3509,27 @@ void init_eventtab (void)
     for (i = 0; i < ev_max; i++) {
 	eventtab[i].active = 0;
 	eventtab[i].oldcycles = 0;
+#ifdef USE_EVENT_QUEUE
+	event_queue_pos[i] = -1;
+#endif
     }
+#ifdef USE_EVENT_QUEUE
+    event_queue_len = 0;
+#endif
 
     eventtab[ev_cia].handler = CIA_handler;
     eventtab[ev_hsync].handler = hsync_handler;
     eventtab[ev_hsync].evtime = maxhpos * CYCLE_UNIT + get_cycles ();
     eventtab[ev_hsync].active = 1;
+    event_changed (ev_hsync);
 
     eventtab[ev_copper].handler = copper_handler;
     eventtab[ev_copper].active = 0;
+#ifdef USE_BLITTER_CHUNKS
+    eventtab[ev_blitter].handler = blitter_event;
+#else
     eventtab[ev_blitter].handler = blitter_handler;
+#endif
     eventtab[ev_blitter].active = 0;
     eventtab[ev_disk].handler = DISK_handler;
     eventtab[ev_disk].active = 0;
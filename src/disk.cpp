@@ -126,6 +126,23 @@ typedef struct {
 #define DRIVE_ID_525DD 0x55555555 /* 40 track 5.25 drive , kickstart does not recognize this */
 
 typedef enum { ADF_NORMAL, ADF_EXT1, ADF_EXT2 } drive_filetype;
+
+#ifdef USE_DISK_TRACK_CACHE
+/* Encoded AmigaDOS tracks of the inserted image, so seeking back to a
+   track swaps bigmfmbuf instead of re-encoding it. Slots are allocated
+   on the first miss and sized for HD tracks. */
+#define DISK_CACHE_SLOTS 12
+#define DISK_CACHE_WORDS (22 * 544 + FLOPPY_GAP_LEN)
+typedef struct {
+    uae_u16 *buf;			/* DISK_CACHE_SLOTS * DISK_CACHE_WORDS */
+    short track[DISK_CACHE_SLOTS];	/* -1 = free */
+    unsigned used[DISK_CACHE_SLOTS];	/* LRU stamp */
+    unsigned clock;
+} trackcache;
+
+unsigned disk_cache_hits, disk_cache_misses;
+#endif
+
 typedef struct {
     FILE *diskfile;
     drive_filetype filetype;
@@ -135,7 +152,13 @@ typedef struct {
     int motoroff;
     int state;
     int wrprot;
+#ifdef USE_DISK_TRACK_CACHE
+    uae_u16 *bigmfmbuf;		/* ownmfmbuf or a cache slot */
+    uae_u16 ownmfmbuf[0x8000];
+    trackcache cache;
+#else
     uae_u16 bigmfmbuf[0x8000];
+#endif
     int mfmpos;
     int tracklen;
     int trackspeed;
@@ -228,6 +251,70 @@ static void update_drive_gui (int num)
 
 static void drive_fill_bigbuf (drive * drv);
 
+#ifdef USE_DISK_TRACK_CACHE
+static void disk_cache_flush (drive * drv)
+{
+    int i;
+    for (i = 0; i < DISK_CACHE_SLOTS; i++)
+	drv->cache.track[i] = -1;
+}
+
+/* Drop track tr, rewritten on the image, from the cache */
+static void disk_cache_forget (drive * drv, int tr)
+{
+    int i;
+    for (i = 0; i < DISK_CACHE_SLOTS; i++)
+	if (drv->cache.track[i] == tr)
+	    drv->cache.track[i] = -1;
+}
+
+/* Stop using a cache slot as the track buffer (write DMA goes into
+   bigmfmbuf and may run past DISK_CACHE_WORDS) and free that slot */
+static void disk_cache_detach (drive * drv)
+{
+    if (drv->bigmfmbuf != drv->ownmfmbuf) {
+	if (drv->bigmfmbuf) {
+	    memcpy (drv->ownmfmbuf, drv->bigmfmbuf, DISK_CACHE_WORDS * 2);
+	    drv->cache.track[(drv->bigmfmbuf - drv->cache.buf) / DISK_CACHE_WORDS] = -1;
+	}
+	drv->bigmfmbuf = drv->ownmfmbuf;
+    }
+}
+
+/* Points bigmfmbuf at track tr: returns 1 if it is already encoded
+   there, 0 if the caller must encode it */
+static int disk_cache_get (drive * drv, int tr)
+{
+    trackcache *c = &drv->cache;
+    int i, slot = 0;
+
+    if (!c->buf) {
+	c->buf = (uae_u16 *)malloc (DISK_CACHE_SLOTS * DISK_CACHE_WORDS * 2);
+	if (!c->buf) {
+	    drv->bigmfmbuf = drv->ownmfmbuf;
+	    return 0;
+	}
+	disk_cache_flush (drv);
+    }
+    c->clock++;
+    for (i = 0; i < DISK_CACHE_SLOTS; i++) {
+	if (c->track[i] == tr) {
+	    c->used[i] = c->clock;
+	    drv->bigmfmbuf = c->buf + i * DISK_CACHE_WORDS;
+	    disk_cache_hits++;
+	    return 1;
+	}
+	if (c->track[i] < 0 || (c->track[slot] >= 0 && c->used[i] < c->used[slot]))
+	    slot = i;
+    }
+    c->track[slot] = tr;
+    c->used[slot] = c->clock;
+    drv->bigmfmbuf = c->buf + slot * DISK_CACHE_WORDS;
+    disk_cache_misses++;
+    return 0;
+}
+#endif
+
 FILE *DISK_validate_filename (const char *fname, int leave_open, int *wrprot)
 {
 #ifdef DEBUG_DISK
@@ -254,6 +341,10 @@ static int drive_insert (drive * drv, int dnum, const char *fname)
 
 #ifdef DEBUG_DISK
     dbgf("disc.c : DRIVE_INSERT %i - %s\n",dnum,fname);
+#endif
+#ifdef USE_DISK_TRACK_CACHE
+    disk_cache_detach (drv);
+    disk_cache_flush (drv);
 #endif
     drv->diskfile = DISK_validate_filename (fname, 1, &drv->wrprot);
     if (drv->diskfile == 0) {
@@ -474,6 +565,9 @@ static void drive_fill_bigbuf (drive * drv)
     trackid *ti = drv->trackdata + tr;
 
     if (!drv->diskfile || tr >= drv->num_tracks) {
+#ifdef USE_DISK_TRACK_CACHE
+	drv->bigmfmbuf = drv->ownmfmbuf;
+#endif
 	drv->tracklen = FLOPPY_WRITE_LEN * drv->ddhd * 2 * 8;
 	drv->trackspeed = floppy_speed;
 	memset (drv->bigmfmbuf, 0xaa, FLOPPY_WRITE_LEN * 2 * drv->ddhd);
@@ -482,6 +576,11 @@ static void drive_fill_bigbuf (drive * drv)
     if (drv->buffered_cyl == drv->cyl && drv->buffered_side == side)
 	return;
 
+#ifdef USE_DISK_TRACK_CACHE
+    if (ti->type == TRACK_AMIGADOS && disk_cache_get (drv, tr)) {
+	drv->tracklen = (drv->num_secs * 544 + FLOPPY_GAP_LEN) * 2 * 8;
+    } else
+#endif
     if (ti->type == TRACK_AMIGADOS) {
 #ifdef DEBUG_DISK
 	dbg("disc.c : drive_fill_bigbuf --- DISCO AMIGADOS ---");
@@ -568,6 +667,9 @@ static void drive_fill_bigbuf (drive * drv)
 #endif
 	int i;
 	int base_offset = ti->type == TRACK_RAW ? 0 : 1;
+#ifdef USE_DISK_TRACK_CACHE
+	drv->bigmfmbuf = drv->ownmfmbuf;
+#endif
 	drv->tracklen = ti->bitlen + 16 * base_offset;
 	drv->bigmfmbuf[0] = ti->sync;
 	read_floppy_data (drv, tr, 0, (unsigned char *) (drv->bigmfmbuf + base_offset), (ti->bitlen + 7) / 8);
@@ -786,6 +888,10 @@ static void drive_write_data (drive * drv)
 	}
 	break;
     }
+#ifdef USE_DISK_TRACK_CACHE
+    disk_cache_detach (drv);
+    disk_cache_forget (drv, drv->cyl * 2 + side);
+#endif
     drv->buffered_side = 2;	/* will force read */
 }
 
@@ -797,6 +903,10 @@ static void drive_eject (drive * drv)
     if (!drive_empty (drv))
 	zfile_close (drv->diskfile);
     drv->diskfile = 0;
+#ifdef USE_DISK_TRACK_CACHE
+    disk_cache_detach (drv);
+    disk_cache_flush (drv);
+#endif
     drv->dskchange = 1;
     drive_settype_id(drv); /* Back to 35 DD */
 #ifdef DEBUG_DISK
@@ -1058,11 +1168,13 @@ static void disk_events (int last)
     dbgf("disc.c : disk_events(%i) -> get_cycles()=%i, maxhpos=%i\n",last,get_cycles (),maxhpos);
 #endif
     eventtab[ev_disk].active = 0;
+    event_changed (ev_disk);
     for (disk_sync_cycle = last; disk_sync_cycle < maxhpos; disk_sync_cycle++) {
 	if (disk_sync[disk_sync_cycle]) {
 	    eventtab[ev_disk].oldcycles = get_cycles ();
 	    eventtab[ev_disk].evtime = get_cycles () + (disk_sync_cycle - last) * CYCLE_UNIT;
 	    eventtab[ev_disk].active = 1;
+	    event_changed (ev_disk);
 #ifdef DEBUG_DISK
     dbgf("disc.c : evtime=%i, active=%i\n",eventtab[ev_disk].evtime,eventtab[ev_disk].active);
 #endif
@@ -1080,6 +1192,7 @@ void DISK_handler (void)
     dbg("disc.c : DISK_handler");
 #endif
     eventtab[ev_disk].active = 0;
+    event_changed (ev_disk);
     if (disk_sync[disk_sync_cycle] & DISK_WORDSYNC)
 	INTREQ (0x9000);
     if (disk_sync[disk_sync_cycle] & DISK_INDEXSYNC)
@@ -1104,6 +1217,10 @@ static void disk_doupdate_write (drive * drv)
     dbg("disc.c : disk_doupdate_write");
 #endif
     int hpos = disk_hpos;
+#ifdef USE_DISK_TRACK_CACHE
+    if (drv->bigmfmbuf != drv->ownmfmbuf)
+	disk_cache_detach (drv);
+#endif
     while (hpos < (maxhpos << 8)) {
 	drv->mfmpos++;
 	drv->mfmpos %= drv->tracklen;
@@ -1132,94 +1249,10 @@ static void disk_doupdate_write (drive * drv)
     disk_hpos = hpos - (maxhpos << 8);
 }
 
-/* get one bit from MFM bit stream */
-static uae_u32 getonebit (uae_u16 * mfmbuf, int mfmpos, uae_u32 word)
-{
-    uae_u16 *buf;
-
-#ifdef DEBUG_DISK
-    dbg("disc.c : getonebit");
-#endif
-    buf = &mfmbuf[mfmpos >> 4];
-    word <<= 1;
-    word |= (buf[0] & (1 << (15 - (mfmpos & 15)))) ? 1 : 0;
-    return word;
-}
-
 #define WORDSYNC_CYCLES 7 /* (~7 * 280ns = 2us) */
 
-/* emulate disk read dma for full horizontal line */
-static void disk_doupdate_read (drive * drv)
-{
-    int hpos = disk_hpos;
-    int is_sync = 0;
-    int j = 0, k = 1, l = 0;
-    uae_u16 synccheck;
-    static int dskbytr_last = 0, wordsync_last = -1;
-
-#ifdef DEBUG_DISK
-    dbg("disc.c : disk_doupdate_read");
-#endif
-    dskbytr_tab[0] = dskbytr_tab[dskbytr_last];
-
-    if (wordsync_last >= 0 && maxhpos - wordsync_cycle[wordsync_last] < WORDSYNC_CYCLES)
-	wordsync_cycle[l++] = (maxhpos - wordsync_cycle[wordsync_last]) - WORDSYNC_CYCLES;
-    wordsync_last = -1;
-
-    while (hpos < (maxhpos << 8)) {
-	if (drv->dskready)
-	    word = getonebit (drv->bigmfmbuf, drv->mfmpos, word);
-	else
-	    word <<= 1;
-	drv->mfmpos++;
-	drv->mfmpos %= drv->tracklen;
-	if (!drv->mfmpos) {
-	    disk_sync[hpos >> 8] |= DISK_INDEXSYNC;
-#ifdef DEBUG_DISK
-    dbgf("disc.c : disk_sync[%i] |= %i =%i\n",(hpos >> 8),DISK_INDEXSYNC,disk_sync[hpos >> 8]);
-#endif
-	    is_sync = 1;
-	}
-	if (bitoffset == 31 && dma_enable) {
-	    dma_tab[j++] = (word >> 16) & 0xffff;
-	    if (j == MAX_DISK_WORDS_PER_LINE - 1) {
-		write_log ("Bug: Disk DMA buffer overflow!\n");
-		j--;
-	    }
-	}
-	if (bitoffset == 15 || bitoffset == 23 || bitoffset == 31) {
-	    dskbytr_tab[k] = (word >> 8) & 0xff;
-	    dskbytr_tab[k] |= 0x8000;
-	    dskbytr_last = k;
-	    dskbytr_cycle[k++] = hpos >> 8;
-	}
-	synccheck = (word >> 8) & 0xffff;
-	if (synccheck == dsksync) {
-	    if (adkcon & 0x400) {
-		if (bitoffset != 23 || !dma_enable)
-		    bitoffset = 7;
-		dma_enable = 1;
-	    }
-	    wordsync_last = l;
-	    wordsync_cycle[l++] = hpos >> 8;
-	    disk_sync[hpos >> 8] |= DISK_WORDSYNC;
-#ifdef DEBUG_DISK
-    dbgf("disc.c : disk_sync[%i] |= %i =%i\n",(hpos >> 8),DISK_WORDSYNC,disk_sync[hpos >> 8]);
-#endif
-	    is_sync = 1;
-	}
-	bitoffset++;
-	if (bitoffset == 32) bitoffset = 16;
-	hpos += drv->trackspeed;
-    }
-    dma_tab[j] = 0xffffffff;
-    dskbytr_cycle[k] = 255;
-    wordsync_cycle[l] = 255;
-    if (is_sync)
-	disk_events (0);
-
-    disk_hpos = hpos - (maxhpos << 8);
-}
+#define DISK_READ_NAME disk_doupdate_read
+#include "disk_read.h"
 
 /* disk DMA fetch happens on real Amiga at the beginning of next horizontal line
    (cycles 9, 11 and 13 according to hardware manual) We transfer all DMA'd
@@ -1521,6 +1554,9 @@ void DISK_init (void)
 
     for (dr = 0; dr < NUM_DRIVES; dr++) {
 	drive *drv = &floppy[dr];
+#ifdef USE_DISK_TRACK_CACHE
+	drv->bigmfmbuf = drv->ownmfmbuf;
+#endif
 	/* reset all drive types to 3.5 DD */
 	drive_settype_id (drv);
 	if (!drive_insert (drv, dr, prefs_df[dr]))
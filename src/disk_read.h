@@ -0,0 +1,164 @@
+/*
+ * Disk read DMA for one horizontal line, included by disk.cpp as
+ * disk_doupdate_read().
+ *
+ * The plain loop shifts one MFM bit per iteration and checks index,
+ * DMA, DSKBYTR and sync after each. With USE_DISK_FAST_READ the run of
+ * bits up to the next DSKBYTR byte boundary is fetched with one read
+ * and the sync word is searched over that window; a chunk stops short
+ * of a sync match or of the index, and the loop below handles that bit
+ * exactly as before. bench/bench-diskread.cpp checks that both give the
+ * same DMA words, DSKBYTR values/cycles and sync/index timing.
+ */
+
+/* get one bit from MFM bit stream */
+static uae_u32 getonebit (uae_u16 * mfmbuf, int mfmpos, uae_u32 word)
+{
+    uae_u16 *buf;
+
+#ifdef DEBUG_DISK
+    dbg("disc.c : getonebit");
+#endif
+    buf = &mfmbuf[mfmpos >> 4];
+    word <<= 1;
+    word |= (buf[0] & (1 << (15 - (mfmpos & 15)))) ? 1 : 0;
+    return word;
+}
+
+
+#ifdef USE_DISK_FAST_READ
+/* n (1..16) bits of the MFM stream from mfmpos, first one in bit n-1.
+   The caller keeps mfmpos + n within the track. */
+static __inline__ uae_u32 getbits (uae_u16 * mfmbuf, int mfmpos, int n)
+{
+    uae_u16 *buf = &mfmbuf[mfmpos >> 4];
+    int shift = mfmpos & 15;
+    uae_u32 v = (uae_u32)buf[0] << 16;
+
+    if (shift + n > 16)
+	v |= buf[1];
+    return (v << shift) >> (32 - n);
+}
+#endif
+
+/* emulate disk read dma for full horizontal line */
+static void DISK_READ_NAME (drive * drv)
+{
+    int hpos = disk_hpos;
+    int is_sync = 0;
+    int j = 0, k = 1, l = 0;
+    uae_u16 synccheck;
+    static int dskbytr_last = 0, wordsync_last = -1;
+
+#ifdef DEBUG_DISK
+    dbg("disc.c : disk_doupdate_read");
+#endif
+    dskbytr_tab[0] = dskbytr_tab[dskbytr_last];
+
+    if (wordsync_last >= 0 && maxhpos - wordsync_cycle[wordsync_last] < WORDSYNC_CYCLES)
+	wordsync_cycle[l++] = (maxhpos - wordsync_cycle[wordsync_last]) - WORDSYNC_CYCLES;
+    wordsync_last = -1;
+
+    while (hpos < (maxhpos << 8)) {
+#ifdef USE_DISK_FAST_READ
+	{
+	    /* bits up to and including the next byte boundary */
+	    int n = (bitoffset <= 15 ? 15 : bitoffset <= 23 ? 23 : 31) - bitoffset + 1;
+	    int left = ((maxhpos << 8) - hpos + drv->trackspeed - 1) / drv->trackspeed;
+	    int i;
+	    uae_u32 bits;
+
+	    if (n > left)
+		n = left;
+	    if (n > drv->tracklen - 1 - drv->mfmpos)
+		n = drv->tracklen - 1 - drv->mfmpos;
+	    bits = drv->dskready && n > 0 ? getbits (drv->bigmfmbuf, drv->mfmpos, n) : 0;
+	    for (i = 1; i <= n; i++)
+		if ((((word << i) | (bits >> (n - i))) >> 8 & 0xffff) == dsksync)
+		    break;
+	    if (i <= n) {
+		bits >>= n - (i - 1);
+		n = i - 1;
+	    }
+	    if (n > 0) {
+		int last = bitoffset + n - 1;
+
+		word = (word << n) | bits;
+		drv->mfmpos += n;
+		hpos += (n - 1) * drv->trackspeed;
+		if (last == 31 && dma_enable) {
+		    dma_tab[j++] = (word >> 16) & 0xffff;
+		    if (j == MAX_DISK_WORDS_PER_LINE - 1) {
+			write_log ("Bug: Disk DMA buffer overflow!\n");
+			j--;
+		    }
+		}
+		if (last == 15 || last == 23 || last == 31) {
+		    dskbytr_tab[k] = (word >> 8) & 0xff;
+		    dskbytr_tab[k] |= 0x8000;
+		    dskbytr_last = k;
+		    dskbytr_cycle[k++] = hpos >> 8;
+		}
+		bitoffset += n;
+		if (bitoffset == 32) bitoffset = 16;
+		hpos += drv->trackspeed;
+		continue;
+	    }
+	}
+#endif
+	if (drv->dskready)
+	    word = getonebit (drv->bigmfmbuf, drv->mfmpos, word);
+	else
+	    word <<= 1;
+	drv->mfmpos++;
+	drv->mfmpos %= drv->tracklen;
+	if (!drv->mfmpos) {
+	    disk_sync[hpos >> 8] |= DISK_INDEXSYNC;
+#ifdef DEBUG_DISK
+    dbgf("disc.c : disk_sync[%i] |= %i =%i\n",(hpos >> 8),DISK_INDEXSYNC,disk_sync[hpos >> 8]);
+#endif
+	    is_sync = 1;
+	}
+	if (bitoffset == 31 && dma_enable) {
+	    dma_tab[j++] = (word >> 16) & 0xffff;
+	    if (j == MAX_DISK_WORDS_PER_LINE - 1) {
+		write_log ("Bug: Disk DMA buffer overflow!\n");
+		j--;
+	    }
+	}
+	if (bitoffset == 15 || bitoffset == 23 || bitoffset == 31) {
+	    dskbytr_tab[k] = (word >> 8) & 0xff;
+	    dskbytr_tab[k] |= 0x8000;
+	    dskbytr_last = k;
+	    dskbytr_cycle[k++] = hpos >> 8;
+	}
+	synccheck = (word >> 8) & 0xffff;
+	if (synccheck == dsksync) {
+	    if (adkcon & 0x400) {
+		if (bitoffset != 23 || !dma_enable)
+		    bitoffset = 7;
+		dma_enable = 1;
+	    }
+	    wordsync_last = l;
+	    wordsync_cycle[l++] = hpos >> 8;
+	    disk_sync[hpos >> 8] |= DISK_WORDSYNC;
+#ifdef DEBUG_DISK
+    dbgf("disc.c : disk_sync[%i] |= %i =%i\n",(hpos >> 8),DISK_WORDSYNC,disk_sync[hpos >> 8]);
+#endif
+	    is_sync = 1;
+	}
+	bitoffset++;
+	if (bitoffset == 32) bitoffset = 16;
+	hpos += drv->trackspeed;
+    }
+    dma_tab[j] = 0xffffffff;
+    dskbytr_cycle[k] = 255;
+    wordsync_cycle[l] = 255;
+    if (is_sync)
+	disk_events (0);
+
+    disk_hpos = hpos - (maxhpos << 8);
+}
+
+
+#undef DISK_READ_NAME
@@ -50,6 +50,13 @@
 #include "savestate.h"
 #include "sound.h"
 #include "debug_uae4all.h"
+#include "pfield_c2p.h"
+#ifdef USE_SPRITE_MERGE
+#include "sprite_merge.h"
+#endif
+#ifdef USE_BLIT_TRACE
+#include "blittrace.h"
+#endif
 
 #ifdef USE_DRAWING_EXTRA_INLINE
 #define _INLINE_ __inline__
@@ -100,6 +107,23 @@ extern int sf2000_v_stretch;
 // v109: Show LEDs option (0=OFF, 1=ON)
 extern int sf2000_show_leds;
 
+#ifdef USE_STRETCH_ROWS
+/* Y-stretch without the copy. retro_run() used to build every stretched
+   frame in a separate buffer: output row d shows gfx row y_start + d + d/div,
+   clamped to the last gfx row. Instead init_aspect_maps() sends each Amiga
+   line straight to the gfx row it is shown in, lines in the dropped rows
+   are not drawn at all, and finish_drawing_frame() repeats the row above
+   for the clamped rows at the bottom. retro_run() asks for a layout with
+   stretch_rows_div (0 = no stretch) and stretch_rows_y_start; a drawing
+   frame takes it when it starts, and the _drawn pair tells which one is
+   in gfx_mem. */
+#define STRETCH_ROWS_SHOWN 240
+int stretch_rows_div, stretch_rows_y_start;
+int stretch_rows_drawn_div, stretch_rows_drawn_y_start;
+/* First shown row repeating the one above it */
+static int stretch_rows_dup = STRETCH_ROWS_SHOWN;
+#endif
+
 /* Lookup tables for dual playfields.  The dblpf_*1 versions are for the case
    that playfield 1 has the priority, dbplpf_*2 are used if playfield 2 has
    priority.  If we need an array for non-dual playfield mode, it has no number.  */
@@ -127,6 +151,16 @@ xcolnr xcolors[4096];
 
 struct color_entry colors_for_drawing;
 
+#ifdef USE_PALETTE_POINTER
+/* The colors of the line being drawn: the recorded color table itself,
+   or colors_for_drawing once a color changes within the line. The tables
+   only ever hold colors 0-31, so that is all there is to copy. */
+static xcolnr *drawing_acolors = colors_for_drawing.acolors;
+#define DRAWING_ACOLORS drawing_acolors
+#else
+#define DRAWING_ACOLORS colors_for_drawing.acolors
+#endif
+
 /* The size of these arrays is pretty arbitrary; it was chosen to be "more
    than enough".  The coordinates used for indexing into these arrays are
    almost, but not quite, Amiga coordinates (there's a constant offset).  */
@@ -162,6 +196,21 @@ static char *line_drawn;
 static char linestate[(MAXVPOS + 1)*2 + 32] UAE4ALL_ALIGN;
 #endif
 
+#ifdef USE_DIRTY_LINES
+/* Amiga line last drawn into each output row, -1 when the row contents
+   are unknown (overlays, status line, lost screen). A line recorded as
+   LINE_DONE (decisions, colors, sprites and bitplane data all match the
+   last drawn frame) is not drawn again if its row still holds it. */
+static short row_line_drawn[2049];
+
+static void invalidate_drawn_rows (void)
+{
+    int i;
+    for (i = 0; i < sizeof row_line_drawn / sizeof *row_line_drawn; i++)
+	row_line_drawn[i] = -1;
+}
+#endif
+
 uae_u8 line_data[(MAXVPOS + 1) * 2][MAX_PLANES * MAX_WORDS_PER_LINE * 2] UAE4ALL_ALIGN;
 
 /* Centering variables.  */
@@ -230,10 +279,73 @@ int old_nb_frame_skipped = 0;
 int old_nb_frame_skipped2 = 0;
 extern uae_sem_t vsync_wait_sem;
 
+#ifdef USE_RENDER_THREAD
+#if defined(SF2000)
+#error "USE_RENDER_THREAD needs pthreads and a second core"
+#endif
+#if defined(USE_LINESTATE) || defined(USE_DIRTY_LINES) || defined(USE_RASTER_DRAW) || !defined(USE_ALL_LINES)
+#error "USE_RENDER_THREAD draws every line of a frame: USE_ALL_LINES only"
+#endif
+#include <pthread.h>
+#ifdef __LIBRETRO__
+extern int libretro_frame_end;
+#endif
+#endif
+
+#ifdef USE_AUTO_FRAMESKIP
+/* Auto frameskip (frameskip -1): every frame has AFS_FRAME_US of host
+   time, and afs_due is when the one being emulated should be done. A
+   frame finished late means the next one must make up for it, and the
+   only thing we can leave out is finish_drawing_frame(), whose cost is
+   measured in vsync_handle_redraw(). So skipping starts when the lag is
+   more than half a drawing, goes on while there is any lag left, and
+   never covers more than AFS_MAX_SKIP frames in a row. A lag that many
+   frames cannot make up (a pause, the menu, a slow emulation) is
+   dropped. SDL_GetTicks() is GetTicks(), in microseconds. */
+#define AFS_FRAME_US 20000
+#define AFS_MAX_SKIP 4
+#define AFS_MAX_LAG (AFS_MAX_SKIP * AFS_FRAME_US)
+
+static Uint32 afs_due, afs_second, afs_draw_us;
+static int afs_run, afs_frames, afs_skips;
+
+/* frames skipped in the last second, on the power LED; -1 when off */
+int auto_frameskip_shown = -1;
+
+static __inline__ int auto_frameskip (void)
+{
+    Uint32 now = SDL_GetTicks ();
+    int late = (int)(now - afs_due);
+
+    if (afs_frames == 0 || late > AFS_MAX_LAG || late < 0) {
+	afs_due = now;
+	late = 0;
+    }
+    afs_due += AFS_FRAME_US;
+
+    if (afs_run ? late > 0 && afs_run < AFS_MAX_SKIP : late > (int)afs_draw_us / 2)
+	afs_run++;
+    else
+	afs_run = 0;
+
+    afs_skips += afs_run != 0;
+    if (++afs_frames >= 50 && (int)(now - afs_second) >= 1000000) {
+	auto_frameskip_shown = afs_skips;
+	afs_second = now;
+	afs_frames = 1;
+	afs_skips = 0;
+    }
+    return afs_run != 0;
+}
+#endif
+
 
 static __inline__ void count_frame (void)
 {
     uae4all_numframes++;
+#ifdef PROFILER_UAE4ALL
+    uae4all_prof_frame();
+#endif
 #ifdef AUTO_PROFILER
     if (uae4all_numframes==AUTO_PROFILER)
     {
@@ -245,11 +357,30 @@ static __inline__ void count_frame (void)
 	    check_prefs_changed_audio();
 #endif
 	    uae4all_prof_init();
+	    uae4all_prof_trace_start();
+#ifdef USE_BLIT_TRACE
+	    blit_trace_start(SAVE_PREFIX "uae4all_blits.trace");
+#endif
     }
 #ifdef MAX_AUTO_PROFILER
     else if (uae4all_numframes==MAX_AUTO_PROFILER)
     {
 	    uae4all_prof_show();
+	    uae4all_prof_dump_csv(SAVE_PREFIX "uae4all_prof.csv");
+	    uae4all_prof_dump_trace(SAVE_PREFIX "uae4all_trace.json");
+#ifdef USE_BLIT_TRACE
+	    blit_trace_stop();
+	    blit_trace_show();
+#endif
+#ifdef USE_CPU_IDLE_SKIP
+	    m68k_idle_show();
+#endif
+#ifdef FAME_PREDECODE
+	    m68k_predecode_show();
+#endif
+#ifdef USE_MIPS_DYNAREC
+	    m68k_dynarec_show();
+#endif
 	    exit(0);
     }
 #endif
@@ -311,8 +442,16 @@ static __inline__ void count_frame (void)
 #ifdef DEBUG_FRAMERATE
 	else
 		uae4all_frameskipped++;
+#endif
+#ifdef USE_AUTO_FRAMESKIP
+	afs_frames = 0;
+	auto_frameskip_shown = -1;
 #endif
     }
+#ifdef USE_AUTO_FRAMESKIP
+    else
+	fsframecnt = auto_frameskip ();
+#else
     else
     {
 	static int nb_frame_skipped=0;
@@ -364,6 +503,7 @@ static __inline__ void count_frame (void)
 		nb_frame_skipped=0;
 	}
     }
+#endif
 }
 
 int coord_native_to_amiga_x (int x)
@@ -392,11 +532,17 @@ static __inline__ int res_shift_from_amiga (int x)
     return x << -res_shift;
 }
 
-#ifdef USE_RASTER_DRAW
+#if defined(USE_RASTER_DRAW) || defined(USE_DIRTY_LINES)
 void notice_screen_contents_lost (void)
 {
+#ifdef USE_RASTER_DRAW
     frame_redraw_necessary = 2;
-
+#endif
+#ifdef USE_DIRTY_LINES
+    extern int back_drive_track0;
+    back_drive_track0 = -1;
+    invalidate_drawn_rows ();
+#endif
 }
 #endif
 
@@ -456,7 +602,7 @@ static line_draw_func *pfield_do_linetoscr=(line_draw_func *)pfiled_do_linetoscr
 static void pfield_do_fill_line(int start, int stop)
 {
     register uae_u16 *b = &(((uae_u16 *)xlinebuffer)[start]);
-    register xcolnr col = colors_for_drawing.acolors[0];
+    register xcolnr col = DRAWING_ACOLORS[0];
     register int i;
     register int max=(stop-start);
     for (i = 0; i < max; i++,b++)
@@ -549,7 +695,7 @@ static __inline__ void fill_line (void)
     nrem = nints & 7;
     nints &= ~7;
     start = (int *)(((char *)xlinebuffer) + (VISIBLE_LEFT_BORDER << 1));
-    val = colors_for_drawing.acolors[0];
+    val = DRAWING_ACOLORS[0];
     val |= val << 16;
 #ifdef DEBUG_BLITTER
     dbgf("fill_line -> nints=%i, nrem=%i, val=%i\n",nints,nrem,val);
@@ -696,7 +842,7 @@ static __inline__ void draw_sprites_1 (struct sprite_entry *_GCCRES_ e, int dual
 
 static __inline__ void draw_sprites_ecs (struct sprite_entry *_GCCRES_ e)
 {
-    uae4all_prof_start(12);
+    uae4all_prof_start(UAE4ALL_PROF_SPRITES);
     if (e->has_attached)
 	if (bplres == 1)
 		if (bpldualpf)
@@ -719,7 +865,7 @@ static __inline__ void draw_sprites_ecs (struct sprite_entry *_GCCRES_ e)
 		    draw_sprites_normal_dp_lo_nat (e);
 		else
 		    draw_sprites_normal_sp_lo_nat (e);
-    uae4all_prof_end(12);
+    uae4all_prof_end(UAE4ALL_PROF_SPRITES);
 }
 
 
@@ -1138,13 +1284,35 @@ static __inline__ void decide_draw_sprites(void) {
 
 static __inline__ void draw_sprites_ecs (struct sprite_entry *_GCCRES_ e)
 {
-	uae4all_prof_start(12);
+	uae4all_prof_start(UAE4ALL_PROF_SPRITES);
 	draw_sprites_punt[e->has_attached](e);
-	uae4all_prof_end(12);
+	uae4all_prof_end(UAE4ALL_PROF_SPRITES);
 }
 
 #endif
 
+#ifdef USE_SPRITE_MERGE
+/* All sprite entries of the line, see sprite_merge.h */
+static void draw_sprites_line (void)
+{
+    int *shift_lookup = bpldualpf ? (bpldualpfpri ? dblpf_ms2 : dblpf_ms1) : dblpf_ms;
+    struct sprite_entry *e = curr_sprite_entries + dip_for_drawing->first_sprite_entry;
+    int i;
+
+    uae4all_prof_start(UAE4ALL_PROF_SPRITES);
+    sprite_merge_set_front (shift_lookup, plf_sprite_mask);
+    for (i = 0; i < dip_for_drawing->nr_sprites; i++, e++) {
+	int window_pos = e->pos + (DIW_DDF_OFFSET - DISPLAY_LEFT_SHIFT);
+
+	if (bplres == 1)
+	    window_pos <<= 1;
+	sprite_composite (pixdata.apixels, window_pos + pixels_offset,
+			  spixels + e->first_pixel, spixstate.bytes + e->first_pixel,
+			  e->max - e->pos, e->has_attached, bpldualpf ? 128 : 0, bplres == 1);
+    }
+    uae4all_prof_end(UAE4ALL_PROF_SPRITES);
+}
+#endif
 
 
 #define MERGE(a,b,mask,shift) {\
@@ -1236,9 +1404,11 @@ static __inline__ void pfield_doline_1 (uae_u32 *_GCCRES_ pixels, int wordcount,
 #define pfield_doline_n7(DTA,CNT) pfield_doline_1 (DTA, CNT, 7)
 #define pfield_doline_n8(DTA,CNT) pfield_doline_1 (DTA, CNT, 8)
 
+#define pfield_init_doline()
+
 static _INLINE_ void pfield_doline (int lineno)
 {
-    uae4all_prof_start(11);
+    uae4all_prof_start(UAE4ALL_PROF_PFIELD_DOLINE);
     int wordcount = dp_for_drawing->plflinelen;
     uae_u32 *data = pixdata.apixels_l + MAX_PIXELS_PER_LINE/4;
 
@@ -1263,7 +1433,7 @@ static _INLINE_ void pfield_doline (int lineno)
     case 7: pfield_doline_n7 (data, wordcount); break;
     case 8: pfield_doline_n8 (data, wordcount); break;
     }
-    uae4all_prof_end(11);
+    uae4all_prof_end(UAE4ALL_PROF_PFIELD_DOLINE);
 }
 
 #else
@@ -1667,12 +1837,51 @@ static pfield_doline_func pfield_doline_n[16]={
 	pfield_doline_dummy,pfield_doline_dummy,pfield_doline_dummy,pfield_doline_dummy
 };
 
+#ifdef PFIELD_C2P_VECTOR
+/* Four plane words per iteration, see pfield_c2p.h */
+#define PFIELD_DOLINE_V(N) \
+static void pfield_doline_v##N (uae_u32 *_GCCRES_ pixels, int wordcount, int lineno) \
+{ \
+    int i; \
+    for (i = 0; i < N; i++) \
+	real_bplpt[i] = DATA_POINTER (i); \
+    pfield_c2p_vector (pixels, wordcount, real_bplpt, N); \
+}
+PFIELD_DOLINE_V(1)
+PFIELD_DOLINE_V(2)
+PFIELD_DOLINE_V(3)
+PFIELD_DOLINE_V(4)
+PFIELD_DOLINE_V(5)
+PFIELD_DOLINE_V(6)
+PFIELD_DOLINE_V(7)
+PFIELD_DOLINE_V(8)
+#endif
+
+/* Select the planar to chunky backend for this CPU */
+static void pfield_init_doline (void)
+{
+#ifdef PFIELD_C2P_VECTOR
+#if defined(__i386__) || defined(__x86_64__)
+    if (!__builtin_cpu_supports ("sse2"))
+	return;
+#endif
+    pfield_doline_n[1] = pfield_doline_v1;
+    pfield_doline_n[2] = pfield_doline_v2;
+    pfield_doline_n[3] = pfield_doline_v3;
+    pfield_doline_n[4] = pfield_doline_v4;
+    pfield_doline_n[5] = pfield_doline_v5;
+    pfield_doline_n[6] = pfield_doline_v6;
+    pfield_doline_n[7] = pfield_doline_v7;
+    pfield_doline_n[8] = pfield_doline_v8;
+#endif
+}
+
 
 static __inline__ void pfield_doline (int lineno)
 {
-    uae4all_prof_start(11);
+    uae4all_prof_start(UAE4ALL_PROF_PFIELD_DOLINE);
     pfield_doline_n[bplplanecnt](pixdata.apixels_l + MAX_PIXELS_PER_LINE/4,dp_for_drawing->plflinelen,lineno);
-    uae4all_prof_end(11);
+    uae4all_prof_end(UAE4ALL_PROF_PFIELD_DOLINE);
 }
 
 #endif
@@ -1687,6 +1896,32 @@ static _INLINE_ void init_row_map (void)
         row_map[i] = gfx_mem + gfx_rowbytes * i;
 }
 
+#ifdef USE_STRETCH_ROWS
+/* gfx row r of the stretched layout: output row d = r - r/(div+1) of the
+   window, with the rows r % (div+1) == div dropped, except the last gfx
+   row, which the clamped rows after it repeat */
+static void stretch_aspect_map (void)
+{
+    const int div = stretch_rows_drawn_div, y0 = stretch_rows_drawn_y_start;
+    const int last = GFXVIDINFO_HEIGHT - 1 - y0;
+    int i, d;
+
+    for (i = 0; i < (MAXVPOS + 1); i++) {
+	int r = amiga2aspect_line_map[i] - y0;
+
+	if (r < 0)
+	    continue;
+	d = r / (div + 1) * div + r % (div + 1);
+	if ((r % (div + 1) == div && r != last) || d >= STRETCH_ROWS_SHOWN)
+	    amiga2aspect_line_map[i] = -1;
+	else
+	    amiga2aspect_line_map[i] = y0 + d;
+    }
+    d = last / (div + 1) * div + last % (div + 1);
+    stretch_rows_dup = d < STRETCH_ROWS_SHOWN ? d + 1 : STRETCH_ROWS_SHOWN;
+}
+#endif
+
 static _INLINE_ void init_aspect_maps (void)
 {
     int i, maxl;
@@ -1733,6 +1968,11 @@ static _INLINE_ void init_aspect_maps (void)
 	}
     }
 
+#ifdef USE_STRETCH_ROWS
+    if (stretch_rows_drawn_div)
+	stretch_aspect_map ();
+#endif
+
     for (i = maxl-1; i >= min_ypos_for_screen; i--) {
 	int j;
 	if (amiga2aspect_line_map[i] == -1)
@@ -1791,8 +2031,12 @@ static enum { color_match_acolors, color_match_full } color_match_type;
 static __inline__ void adjust_drawing_colors (int ctable)
 {
     if (drawing_color_matches != ctable) {
+#ifdef USE_PALETTE_POINTER
+	    drawing_acolors = curr_color_tables[ctable].acolors;
+#else
 	    uae4all_memcpy(colors_for_drawing.acolors, curr_color_tables[ctable].acolors,
 	        sizeof colors_for_drawing.acolors);
+#endif
 	    color_match_type = color_match_acolors;
 	drawing_color_matches = ctable;
     }
@@ -1838,6 +2082,12 @@ static _INLINE_ void do_color_changes (line_draw_func worker_border, line_draw_f
 	if (i != dip_for_drawing->last_color_change) {
 	    if (regno != -1)
 	    {
+#ifdef USE_PALETTE_POINTER
+		if (drawing_acolors != colors_for_drawing.acolors) {
+		    uae4all_memcpy (colors_for_drawing.acolors, drawing_acolors, sizeof (xcolnr) * 32);
+		    drawing_acolors = colors_for_drawing.acolors;
+		}
+#endif
 		color_reg_set (&colors_for_drawing, regno, value);
 		colors_for_drawing.acolors[regno] = getxcolor (value);
 	    }
@@ -1890,6 +2140,10 @@ static __inline__ void pfield_draw_line (int lineno, int gfx_ypos, int follow_yp
 
 	adjust_drawing_colors (dp_for_drawing->ctable);
 
+#ifdef USE_SPRITE_MERGE
+	if (dip_for_drawing->nr_sprites)
+	    draw_sprites_line ();
+#else
 	{
 	    int i;
 	    decide_draw_sprites();
@@ -1897,6 +2151,7 @@ static __inline__ void pfield_draw_line (int lineno, int gfx_ypos, int follow_yp
 		    draw_sprites_ecs (curr_sprite_entries + dip_for_drawing->first_sprite_entry + i);
 	    }
 	}
+#endif
 	do_color_changes (pfield_do_fill_line, (void (*)(int, int))pfield_do_linetoscr);
 	do_flush_line (gfx_ypos);
     } else {
@@ -1916,8 +2171,29 @@ static __inline__ void pfield_draw_line (int lineno, int gfx_ypos, int follow_yp
     }
 }
 
+#ifdef USE_RENDER_THREAD
+static void render_thread_frame (void);
+#endif
+
 static _INLINE_ void init_drawing_frame (void)
 {
+#ifdef USE_RENDER_THREAD
+    render_thread_frame ();
+#endif
+#ifdef USE_STRETCH_ROWS
+    if (stretch_rows_div != stretch_rows_drawn_div
+	|| (stretch_rows_div && stretch_rows_y_start != stretch_rows_drawn_y_start)) {
+	stretch_rows_drawn_div = stretch_rows_div;
+	stretch_rows_drawn_y_start = stretch_rows_y_start;
+	stretch_rows_dup = STRETCH_ROWS_SHOWN;
+	init_aspect_maps ();
+	/* rows no line is drawn to any more would keep the old layout */
+	uae4all_memclr (gfx_mem, gfx_rowbytes * GFXVIDINFO_HEIGHT);
+#ifdef USE_DIRTY_LINES
+	invalidate_drawn_rows ();
+#endif
+    }
+#endif
     init_hardware_for_drawing_frame ();
 
 #ifdef USE_LINESTATE
@@ -1987,6 +2263,9 @@ static int back_drive_track1=-1,back_drive_motor1=-1;
 static int back_drive_track2=-1,back_drive_motor2=-1;
 static int back_drive_track3=-1,back_drive_motor3=-1;
 static int back_powerled=-1;
+#ifdef USE_AUTO_FRAMESKIP
+static int back_frameskip=-1;
+#endif
 
 static __inline__ void putpixel (int x, xcolnr c8)
 {
@@ -2042,6 +2321,9 @@ static _INLINE_ void draw_status_line (int line)
 	    //if (track < 0)  track+=4;            
 	    //track = old_nb_frame_skipped2;
 	    //track = uae_sem_getvalue(&vsync_wait_sem);
+#ifdef USE_AUTO_FRAMESKIP
+	    track = auto_frameskip_shown;
+#endif
 	    on = gui_data.powerled;
 	    on_rgb = 0xf00;
 	    off_rgb = 0x400;
@@ -2063,8 +2345,169 @@ static _INLINE_ void draw_status_line (int line)
     }
 }
 
+/* Draws line i of the drawing frame; 0 when the rest of the frame is not
+   to be drawn */
+static __inline__ int draw_frame_line (int i)
+{
+    int where,i1;
+    int line = i + thisframe_y_adjust_real;
+
+#ifdef USE_LINESTATE
+    if (linestate[line] == LINE_UNDECIDED) {
+#ifdef USE_DIRTY_LINES
+	/* The remaining lines were not recorded, their rows go stale */
+	invalidate_drawn_rows ();
+#endif
+	return 0;
+    }
+#endif
+
+    i1 = i + min_ypos_for_screen;
+    where = amiga2aspect_line_map[i1];
+#ifndef USE_ALL_LINES
+    if (where >= GFXVIDINFO_HEIGHT - TD_TOTAL_HEIGHT)
+	return 0;
+#endif
+    if (where == -1)
+	return 1;
+#ifdef USE_DIRTY_LINES
+    if (linestate[line] == LINE_DONE && row_line_drawn[where] == line)
+	return 1;
+    row_line_drawn[where] = line;
+#endif
+    pfield_draw_line (line, where, amiga2aspect_line_map[i1 + 1]);
+    return 1;
+}
+
+#ifdef USE_RENDER_THREAD
+/*
+ * Render thread, for hosts with a core to spare. custom.cpp finishes the
+ * decisions of a line at its hsync, and nothing it recorded for that line
+ * (line_decisions, line_data, the drawinfo, the color table, color changes
+ * and sprite entries and pixels) changes again before the next drawing
+ * frame. So hsync_record_line_state() hands the decided lines over in
+ * batches to a worker that draws them while the CPU and the chips go on
+ * with the rest of the frame, and finish_drawing_frame() only waits for
+ * the last batch. The worker runs draw_frame_line() over the same lines
+ * in the same order, so the picture is bit for bit the serial one; with
+ * render_thread_enabled = 0, or if the thread can't start, frames are
+ * drawn serially as before.
+ *
+ * Under __LIBRETRO__ no line is handed over between flush_screen() and
+ * the end of retro_run(): the frontend gets gfx_mem with nothing of the
+ * next frame in it.
+ */
+#define RT_BATCH 16	/* lines per wakeup */
+
+int render_thread_enabled = 1;
+static pthread_t rt_thread;
+static pthread_mutex_t rt_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rt_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t rt_done = PTHREAD_COND_INITIALIZER;
+static int rt_state;		/* 1 running, -1 failed to start */
+static int rt_quit;
+static int rt_frame;		/* the worker draws this frame */
+/* lines of the frame handed over and drawn, as draw_frame_line() counts */
+static int rt_ready, rt_drawn;
+
+static void *render_thread (void *arg)
+{
+    int i, n;
+
+    pthread_mutex_lock (&rt_lock);
+    for (;;) {
+	while (rt_drawn == rt_ready && !rt_quit)
+	    pthread_cond_wait (&rt_work, &rt_lock);
+	if (rt_quit)
+	    break;
+	i = rt_drawn;
+	n = rt_ready;
+	pthread_mutex_unlock (&rt_lock);
+	for (; i < n; i++)
+	    draw_frame_line (i);
+	pthread_mutex_lock (&rt_lock);
+	rt_drawn = n;
+	pthread_cond_signal (&rt_done);
+    }
+    pthread_mutex_unlock (&rt_lock);
+    return NULL;
+}
+
+static void render_thread_post (int n)
+{
+    pthread_mutex_lock (&rt_lock);
+    rt_ready = n;
+    pthread_cond_signal (&rt_work);
+    pthread_mutex_unlock (&rt_lock);
+}
+
+/* Waits until the worker has drawn all it was given */
+static void render_thread_sync (void)
+{
+    if (rt_state != 1)
+	return;
+    pthread_mutex_lock (&rt_lock);
+    while (rt_drawn != rt_ready)
+	pthread_cond_wait (&rt_done, &rt_lock);
+    pthread_mutex_unlock (&rt_lock);
+}
+
+/* A new drawing frame, or the same one recorded again from its start */
+static void render_thread_frame (void)
+{
+    render_thread_sync ();
+    pthread_mutex_lock (&rt_lock);
+    rt_ready = rt_drawn = 0;
+    pthread_mutex_unlock (&rt_lock);
+    drawing_color_matches = -1;
+#ifndef PROFILER_UAE4ALL
+    /* (not with the profiler, whose zones are not thread safe) */
+    if (render_thread_enabled && rt_state == 0)
+	rt_state = pthread_create (&rt_thread, NULL, render_thread, NULL) ? -1 : 1;
+#endif
+    rt_frame = render_thread_enabled && rt_state == 1;
+}
+
+static __inline__ void render_thread_line (int lineno)
+{
+    int n = lineno - thisframe_y_adjust_real + 1;
+
+#ifdef __LIBRETRO__
+    if (libretro_frame_end)
+	return;
+#endif
+    if (n > max_ypos_thisframe)
+	n = max_ypos_thisframe;
+    if (n - rt_ready >= RT_BATCH || (n == max_ypos_thisframe && n > rt_ready))
+	render_thread_post (n);
+}
+
+static void render_thread_finish (void)
+{
+    if (rt_ready < max_ypos_thisframe)
+	render_thread_post (max_ypos_thisframe);
+    render_thread_sync ();
+}
+
+void render_thread_stop (void)
+{
+    if (rt_state != 1)
+	return;
+    pthread_mutex_lock (&rt_lock);
+    rt_quit = 1;
+    pthread_cond_signal (&rt_work);
+    pthread_mutex_unlock (&rt_lock);
+    pthread_join (rt_thread, NULL);
+    rt_state = rt_quit = rt_frame = 0;
+    rt_ready = rt_drawn = 0;
+}
+#endif
+
 void check_all_prefs(void)
 {
+#ifdef USE_RENDER_THREAD
+    render_thread_sync ();
+#endif
 
 	check_prefs_changed_audio ();
 	check_prefs_changed_custom ();
@@ -2088,25 +2531,25 @@ static _INLINE_ void finish_drawing_frame (void)
     }
 #endif
 
-    for (i = 0; i < max_ypos_thisframe; i++) {
-	int where,i1;
-	int line = i + thisframe_y_adjust_real;
-
-#ifdef USE_LINESTATE
-	if (linestate[line] == LINE_UNDECIDED)
-	    break;
+#ifdef USE_RENDER_THREAD
+    if (rt_frame)
+	render_thread_finish ();
+    else
 #endif
-
-	i1 = i + min_ypos_for_screen;
-	where = amiga2aspect_line_map[i1];
-#ifndef USE_ALL_LINES
-	if (where >= GFXVIDINFO_HEIGHT - TD_TOTAL_HEIGHT)
+    for (i = 0; i < max_ypos_thisframe; i++)
+	if (!draw_frame_line (i))
 	    break;
+#ifdef USE_STRETCH_ROWS
+    for (i = stretch_rows_dup; i < STRETCH_ROWS_SHOWN; i++)
+	uae4all_memcpy (row_map[stretch_rows_drawn_y_start + i],
+			row_map[stretch_rows_drawn_y_start + i - 1], gfx_rowbytes);
+#ifdef USE_DIRTY_LINES
+    /* retro_run() draws the LEDs over the bottom rows of a stretched frame */
+    if (stretch_rows_drawn_div && sf2000_show_leds)
+	for (i = STRETCH_ROWS_SHOWN - TD_TOTAL_HEIGHT; i < STRETCH_ROWS_SHOWN; i++)
+	    row_line_drawn[stretch_rows_drawn_y_start + i] = -1;
+#endif
 #endif
-	if (where == -1)
-	    continue;
-	pfield_draw_line (line, where, amiga2aspect_line_map[i1 + 1]);
-    }
 // DEACTIVATE FOR DEBUG
 #ifndef USE_ALL_LINES
 #ifdef USE_RASTER_DRAW
@@ -2128,8 +2571,15 @@ static _INLINE_ void finish_drawing_frame (void)
 	|| (back_drive_track3!=gui_data.drive_track[3])
 	|| (back_drive_motor3!=gui_data.drive_motor[3])
 #endif
-	|| (back_powerled!=gui_data.powerled)	)
+	|| (back_powerled!=gui_data.powerled)
+#ifdef USE_AUTO_FRAMESKIP
+	|| (back_frameskip!=auto_frameskip_shown)
+#endif
+	)
     {
+#ifdef USE_AUTO_FRAMESKIP
+	back_frameskip=auto_frameskip_shown;
+#endif
 	back_drive_track0=gui_data.drive_track[0];
 	back_drive_motor0=gui_data.drive_motor[0];
 #if NUM_DRIVES > 1
@@ -2152,6 +2602,9 @@ static _INLINE_ void finish_drawing_frame (void)
 			int line = uae_led_base_line - TD_TOTAL_HEIGHT + i;
 			draw_status_line (line);
 			do_flush_line (line);
+#ifdef USE_DIRTY_LINES
+			row_line_drawn[line] = -1;
+#endif
 		}
 	}
     }
@@ -2178,6 +2631,9 @@ static _INLINE_ void finish_drawing_frame (void)
 			int line = uae_led_base_line - TD_TOTAL_HEIGHT + i;
 			draw_status_line (line);
 			do_flush_line (line);
+#ifdef USE_DIRTY_LINES
+			row_line_drawn[line] = -1;
+#endif
 		}
 	}
 
@@ -2217,7 +2673,18 @@ void vsync_handle_redraw (int long_frame, int lof_changed)
 	    wait_for_vsync = 1;
 
 	    framecnt = 0;
+	    uae4all_prof_start(UAE4ALL_PROF_DRAWING);
+#ifdef USE_AUTO_FRAMESKIP
+	    {
+		Uint32 t = SDL_GetTicks ();
+		finish_drawing_frame ();
+		t = SDL_GetTicks () - t;
+		afs_draw_us += ((int)t - (int)afs_draw_us) / 4;
+	    }
+#else
 	    finish_drawing_frame ();
+#endif
+	    uae4all_prof_end(UAE4ALL_PROF_DRAWING);
 	}
 	
 #ifndef USE_ALL_LINES
@@ -2269,15 +2736,24 @@ void vsync_handle_redraw (int long_frame, int lof_changed)
 	if (framecnt == 0)
 	    init_drawing_frame ();
     }
+#ifdef USE_RENDER_THREAD
+    else if (rt_frame)
+	/* Not drawn: the next field records the lines again */
+	render_thread_frame ();
+#endif
 }
 
-#if defined(USE_LINESTATE) || !defined(USE_ALL_LINES)
+#if defined(USE_LINESTATE) || !defined(USE_ALL_LINES) || defined(USE_RENDER_THREAD)
 void hsync_record_line_state (int lineno, int changed)
 {
     char *state;
 
     if (framecnt != 0)
 	return;
+#ifdef USE_RENDER_THREAD
+    if (rt_frame)
+	render_thread_line (lineno);
+#endif
 #ifdef USE_LINESTATE
     state = linestate + lineno;
 #ifdef USE_RASTER_DRAW
@@ -2304,6 +2780,9 @@ void reset_drawing (void)
 {
     int i;
 
+#ifdef USE_RENDER_THREAD
+    render_thread_sync ();
+#endif
     inhibit_frame = 0;
 
     max_diwstop = 0;
@@ -2316,6 +2795,9 @@ void reset_drawing (void)
     xlinebuffer = gfx_mem;
 
     init_aspect_maps ();
+#ifdef USE_DIRTY_LINES
+    invalidate_drawn_rows ();
+#endif
 
     if (line_drawn == 0)
 	line_drawn = (char *)xmalloc (GFXVIDINFO_HEIGHT);
@@ -2337,5 +2819,9 @@ void drawing_init ()
     line_drawn = 0;
 
     gen_pfield_tables();
+#ifdef USE_SPRITE_MERGE
+    sprite_merge_init ();
+#endif
+    pfield_init_doline();
 }
 
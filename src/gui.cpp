@@ -27,12 +27,6 @@
 
 #include <SDL.h>
 
-#ifdef PROFILER_UAE4ALL
-unsigned long long uae4all_prof_initial[UAE4ALL_PROFILER_MAX];
-unsigned long long uae4all_prof_sum[UAE4ALL_PROFILER_MAX];
-unsigned long long uae4all_prof_executed[UAE4ALL_PROFILER_MAX];
-#endif
-
 #ifdef DREAMCAST
 #include <SDL_dreamcast.h>
 #define VIDEO_FLAGS_INIT SDL_HWSURFACE|SDL_FULLSCREEN
@@ -154,31 +148,6 @@ extern char *gfx_mem;
 #endif
 #ifdef PROFILER_UAE4ALL
 	uae4all_prof_init();
-	uae4all_prof_add("M68K");			// 0
-	uae4all_prof_add("EVENTS");			// 1
-	uae4all_prof_add("HSync");			// 2
-	uae4all_prof_add("Copper");			// 3
-	uae4all_prof_add("Audio");			// 4
-	uae4all_prof_add("CIA");			// 5
-	uae4all_prof_add("Blitter");			// 6
-	uae4all_prof_add("Vsync");			// 7
-	uae4all_prof_add("update_fetch");		// 8
-	uae4all_prof_add("linetoscr");			// 9
-	uae4all_prof_add("do_long_fetch");		// 10
-	uae4all_prof_add("pfield_doline");		// 11
-	uae4all_prof_add("draw_sprites_ecs");		// 12
-	uae4all_prof_add("flush_block");		// 13
-	uae4all_prof_add("SET_INTERRUPT");		// 14
-/*
-	uae4all_prof_add("15");		// 15
-	uae4all_prof_add("16");		// 16
-	uae4all_prof_add("17");		// 17
-	uae4all_prof_add("18");		// 18
-	uae4all_prof_add("19");		// 19
-	uae4all_prof_add("20");		// 20
-	uae4all_prof_add("21");		// 21
-	uae4all_prof_add("22");		// 22
-*/
 #endif
 #ifdef DREAMCAST
 	SDL_DC_EmulateKeyboard(SDL_FALSE);
@@ -859,68 +828,3 @@ int run_menuControl() {}
 */
 
 
-#ifdef PROFILER_UAE4ALL
-
-static unsigned uae4all_prof_total_initial=0;
-unsigned uae4all_prof_total=0;
-static char *uae4all_prof_msg[UAE4ALL_PROFILER_MAX];
-
-void uae4all_prof_init(void)
-{
-	unsigned i;
-#ifndef DREAMCAST
-	unsigned long long s=SDL_GetTicks();
-#else
-	unsigned long long s=timer_us_gettime64();
-#endif
-	for(i=0;i<UAE4ALL_PROFILER_MAX;i++)
-	{
-		uae4all_prof_initial[i]=s;
-		uae4all_prof_sum[i]=0;
-		uae4all_prof_executed[i]=0;
-		if (!uae4all_prof_total)
-			uae4all_prof_msg[i]=NULL;
-	}
-	uae4all_prof_total_initial=s;
-}
-
-void uae4all_prof_add(char *msg)
-{
-	if (uae4all_prof_total<UAE4ALL_PROFILER_MAX)
-	{
-		uae4all_prof_msg[uae4all_prof_total]=msg;	
-		uae4all_prof_total++;
-	}
-}
-
-void uae4all_prof_show(void)
-{
-	unsigned i;
-	double toper=0;
-#ifndef DREAMCAST
-	unsigned long long to=SDL_GetTicks()-uae4all_prof_total_initial;
-#else
-	unsigned long long to=uae4all_prof_sum[0]+uae4all_prof_sum[1];
-	for(i=0;i<uae4all_prof_total;i++)
-		if (uae4all_prof_sum[i]>to)
-			uae4all_prof_sum[i]=0;
-#endif
-
-	puts("\n\n\n\n");
-	puts("--------------------------------------------");
-	for(i=0;i<uae4all_prof_total;i++)
-	{
-		unsigned long long t0=uae4all_prof_sum[i];
-		double percent=(double)t0;
-		percent*=100.0;
-		percent/=(double)to;
-		toper+=percent;
-#ifdef DREAMCAST
-		t0/=1000;
-#endif
-		printf("%s: %.2f%% -> Ticks=%i -> %iK veces\n",uae4all_prof_msg[i],percent,((unsigned)t0),(unsigned)(uae4all_prof_executed[i]>>10));
-	}
-	printf("TOTAL: %.2f%% -> Ticks=%i\n",toper,to);
-	puts("--------------------------------------------"); fflush(stdout);
-}
-#endif
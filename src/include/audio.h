@@ -103,3 +103,10 @@ extern void audio_reset_sample_evtime(void); /* v116: reset static next_sample_e
 extern void check_dma_audio(void);
 extern void fetch_audio(void);
 extern void update_adkmasks (void);
+/* Batched sample output, channels 4/5 (AHI) are not covered */
+#if defined(USE_AUDIO_TIMELINE) && defined(SOUND_AHI)
+#undef USE_AUDIO_TIMELINE
+#endif
+#ifdef USE_AUDIO_TIMELINE
+extern void audio_timeline_render (void);
+#endif
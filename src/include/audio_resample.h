@@ -0,0 +1,104 @@
+/*
+ * Band-limited block resampler for the libretro sound output
+ *
+ * Paula is point-sampled at scaled_sample_evtime intervals, and the
+ * per-m68k_speed evtime values in sound_default_evtime() do not give
+ * exactly sound_rate samples per emulated second, so the frontend sees
+ * a drifting, aliased stream. audio_resample_block() takes whatever a
+ * frame produced and turns it into the number of samples the frame
+ * should have had, through an 8 tap windowed-sinc polyphase FIR
+ * (64 phases, Q14 coefficients built once by audio_resample_init()).
+ *
+ * Input and output are the interleaved stereo words sndbuffer holds;
+ * the mixer writes the same word to both channels, so only the left
+ * one is filtered. Output lags the input by RESAMPLE_TAPS/2 + 1 samples.
+ * bench/bench-resample.cpp checks length, DC gain and the alias level.
+ *
+ * The includer provides uae_u16.
+ */
+
+#ifndef AUDIO_RESAMPLE_H
+#define AUDIO_RESAMPLE_H
+
+#include <math.h>
+#include <string.h>
+
+#define RESAMPLE_TAPS 8
+#define RESAMPLE_PHASE_BITS 6
+#define RESAMPLE_PHASES (1 << RESAMPLE_PHASE_BITS)
+#define RESAMPLE_COEF_BITS 14
+/* Passband edge as a fraction of the input Nyquist frequency */
+#define RESAMPLE_CUTOFF 0.90
+/* Longest block, in frames */
+#define RESAMPLE_MAX_IN 2048
+
+struct audio_resample {
+	short coef[RESAMPLE_PHASES][RESAMPLE_TAPS];
+	/* Last RESAMPLE_TAPS input samples, then the current block */
+	short x[RESAMPLE_TAPS + RESAMPLE_MAX_IN];
+};
+
+static __inline__ void audio_resample_init (struct audio_resample *r)
+{
+	int p, j;
+
+	for (p = 0; p < RESAMPLE_PHASES; p++) {
+		double h[RESAMPLE_TAPS], sum = 0;
+		int isum = 0;
+
+		for (j = 0; j < RESAMPLE_TAPS; j++) {
+			/* Distance of tap j from the output position */
+			double d = (j - RESAMPLE_TAPS / 2 + 1) - (double)p / RESAMPLE_PHASES;
+			double w = 0.42 + 0.5 * cos (M_PI * d / (RESAMPLE_TAPS / 2))
+				+ 0.08 * cos (2 * M_PI * d / (RESAMPLE_TAPS / 2));
+			double s = d == 0 ? 1.0 : sin (M_PI * RESAMPLE_CUTOFF * d) / (M_PI * RESAMPLE_CUTOFF * d);
+			h[j] = s * (fabs (d) < RESAMPLE_TAPS / 2 ? w : 0);
+			sum += h[j];
+		}
+		/* Unity DC gain for every phase, rounding error on the centre tap */
+		for (j = 0; j < RESAMPLE_TAPS; j++) {
+			r->coef[p][j] = (short)floor (h[j] / sum * (1 << RESAMPLE_COEF_BITS) + 0.5);
+			isum += r->coef[p][j];
+		}
+		r->coef[p][RESAMPLE_TAPS / 2 - 1 + (p >= RESAMPLE_PHASES / 2)] += (1 << RESAMPLE_COEF_BITS) - isum;
+	}
+	memset (r->x, 0, sizeof r->x);
+}
+
+/* n input frames to target output frames; returns target */
+static __inline__ int audio_resample_block (struct audio_resample *r, const uae_u16 *in, int n,
+					    uae_u16 *out, int target)
+{
+	short *x = r->x;
+	unsigned pos, step;
+	int i, k;
+
+	if (n <= 0 || target <= 0)
+		return 0;
+	if (n > RESAMPLE_MAX_IN)
+		n = RESAMPLE_MAX_IN;
+	for (i = 0; i < n; i++)
+		x[RESAMPLE_TAPS + i] = (short)in[i * 2];
+
+	/* 16.16 position in x, first output where the previous block's
+	   next one would have been */
+	step = ((unsigned)n << 16) / (unsigned)target;
+	pos = (RESAMPLE_TAPS / 2 - 1) << 16;
+	for (k = 0; k < target; k++, pos += step) {
+		const short *c = r->coef[(pos & 0xffff) >> (16 - RESAMPLE_PHASE_BITS)];
+		const short *s = x + (pos >> 16) - (RESAMPLE_TAPS / 2 - 1);
+		int v = s[0] * c[0] + s[1] * c[1] + s[2] * c[2] + s[3] * c[3]
+			+ s[4] * c[4] + s[5] * c[5] + s[6] * c[6] + s[7] * c[7];
+		v = (v + (1 << (RESAMPLE_COEF_BITS - 1))) >> RESAMPLE_COEF_BITS;
+		if (v > 32767)
+			v = 32767;
+		else if (v < -32768)
+			v = -32768;
+		out[k * 2] = out[k * 2 + 1] = (uae_u16)v;
+	}
+
+	memmove (x, x + n, RESAMPLE_TAPS * sizeof *x);
+	return target;
+}
+
+#endif
@@ -39,6 +39,9 @@ extern void maybe_blit (int);
 #endif
 extern int blitnasty (void);
 extern void blitter_handler (void);
+#ifdef USE_BLITTER_CHUNKS
+extern void blitter_event (void);
+#endif
 extern void build_blitfilltable (void);
 extern void do_blitter (void);
 extern void blitter_done_notify (void);
@@ -0,0 +1,41 @@
+ /*
+  * UAE - The Un*x Amiga Emulator
+  *
+  * Blitter workload trace (USE_BLIT_TRACE)
+  *
+  * blit_init() notes the registers of every blit and blitter_handler()
+  * the host time it took. The counts and times are kept as histograms by
+  * minterm, mode, channels and size for blit_trace_show(); with a file
+  * name, blit_trace_start() also writes one blit_trace_record per blit,
+  * which bench/blit-replay.cpp runs through the blitfunc tables again.
+  */
+
+#ifndef BLITTRACE_H
+#define BLITTRACE_H
+
+#define BLIT_TRACE_MAGIC 0x54544c42	/* "BLTT" */
+#define BLIT_TRACE_VERSION 1
+
+/* Written first, in host byte order. ticks_per_ms is filled in by
+   blit_trace_stop(), 0 if the trace was not stopped. */
+struct blit_trace_header {
+    uae_u32 magic, version, record_size;
+    uae_u32 ticks_per_ms;
+};
+
+struct blit_trace_record {
+    uae_u32 frame;
+    uae_u32 ticks;		/* host time of all its chunks, uae4all_prof_ticks() units */
+    uae_u32 bltapt, bltbpt, bltcpt, bltdpt;
+    uae_u16 bltcon0, bltcon1;
+    uae_u16 hblitsize, vblitsize;
+    uae_s16 bltamod, bltbmod, bltcmod, bltdmod;
+    uae_u16 bltafwm, bltalwm;
+    uae_u16 bltadat, bltbdat, bltcdat, bltbhold;
+};
+
+extern int blit_trace_start (const char *filename);
+extern void blit_trace_stop (void);
+extern void blit_trace_show (void);
+
+#endif
@@ -26,7 +26,7 @@ extern void do_disk (void);
 extern void do_copper (void);
 
 extern void notice_new_xcolors (void);
-#ifdef USE_RASTER_DRAW
+#if defined(USE_RASTER_DRAW) || defined(USE_DIRTY_LINES)
 extern void notice_screen_contents_lost (void);
 #else
 #define notice_screen_contents_lost() { extern int back_drive_track0; back_drive_track0=-1; }
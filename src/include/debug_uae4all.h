@@ -79,6 +79,32 @@ static __inline__ void dbgsum(char *str, void *buff, unsigned len)
 
 
 
+#if defined(PROFILER_UAE4ALL) || defined(USE_BLIT_TRACE)
+
+#ifndef SF2000
+#include <time.h>
+#endif
+
+/* Raw timestamp: CP0 Count on SF2000 (half the CPU clock), microseconds
+   on Dreamcast, nanoseconds elsewhere. Only differences are used, so
+   wrapping at 32 bits is fine for anything shorter than a frame. */
+static __inline__ unsigned uae4all_prof_ticks(void)
+{
+#if defined(SF2000)
+	unsigned c;
+	__asm__ __volatile__ ("mfc0 %0, $9" : "=r" (c));
+	return c;
+#elif defined(DREAMCAST)
+	return (unsigned)timer_us_gettime64();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned)ts.tv_sec*1000000000U+(unsigned)ts.tv_nsec;
+#endif
+}
+
+#endif
+
 #ifndef PROFILER_UAE4ALL
 
 #define uae4all_prof_start(A)
@@ -86,39 +112,60 @@ static __inline__ void dbgsum(char *str, void *buff, unsigned len)
 
 #else
 
-#define UAE4ALL_PROFILER_MAX 256
-
-extern unsigned long long uae4all_prof_initial[UAE4ALL_PROFILER_MAX];
-extern unsigned long long uae4all_prof_sum[UAE4ALL_PROFILER_MAX];
-extern unsigned long long uae4all_prof_executed[UAE4ALL_PROFILER_MAX];
+/* Profiler zones, one per uae4all_prof_start()/uae4all_prof_end() site */
+enum {
+	UAE4ALL_PROF_M68K,		/* m68k_emulate */
+	UAE4ALL_PROF_EVENTS,		/* do_cycles */
+	UAE4ALL_PROF_HSYNC,
+	UAE4ALL_PROF_COPPER,
+	UAE4ALL_PROF_AUDIO,
+	UAE4ALL_PROF_CIA,
+	UAE4ALL_PROF_BLITTER,
+	UAE4ALL_PROF_VSYNC,
+	UAE4ALL_PROF_UPDATE_FETCH,
+	UAE4ALL_PROF_LINETOSCR,
+	UAE4ALL_PROF_LONG_FETCH,
+	UAE4ALL_PROF_PFIELD_DOLINE,
+	UAE4ALL_PROF_SPRITES,
+	UAE4ALL_PROF_FLUSH_BLOCK,
+	UAE4ALL_PROF_INTERRUPT,
+	UAE4ALL_PROF_DRAWING,		/* finish_drawing_frame */
+	UAE4ALL_PROF_VIDEO_OUT,		/* retro_run overlays, stretch, video_cb */
+	UAE4ALL_PROF_RESAMPLE,		/* sound_retro.cpp output resampler */
+	UAE4ALL_PROF_ZONES
+};
+
+extern unsigned uae4all_prof_initial[UAE4ALL_PROF_ZONES];
+extern unsigned uae4all_prof_sum[UAE4ALL_PROF_ZONES];		/* current frame */
+extern unsigned uae4all_prof_executed[UAE4ALL_PROF_ZONES];	/* current frame */
+extern int uae4all_prof_tracing;
+
+void uae4all_prof_trace(unsigned zone, int end, unsigned t);
 
 static __inline__ void uae4all_prof_start(unsigned a)
 {
+	unsigned t=uae4all_prof_ticks();
 	uae4all_prof_executed[a]++;
-#ifndef DREAMCAST
-	uae4all_prof_initial[a]=SDL_GetTicks();
-#else
-	uae4all_prof_initial[a]=timer_us_gettime64();
-#endif
+	uae4all_prof_initial[a]=t;
+	if (uae4all_prof_tracing)
+		uae4all_prof_trace(a,0,t);
 }
 
 
 static __inline__ void uae4all_prof_end(unsigned a)
 {
-#ifndef DREAMCAST
-	uae4all_prof_sum[a]+=SDL_GetTicks()-uae4all_prof_initial[a];
-#else
-	extern unsigned uae4all_prof_total;
-	int i;
-	for(i=0;i<uae4all_prof_total;i++)
-		uae4all_prof_initial[i]+=6;
-	uae4all_prof_sum[a]+=timer_us_gettime64()-uae4all_prof_initial[a]+2;
-#endif
+	unsigned t=uae4all_prof_ticks();
+	uae4all_prof_sum[a]+=t-uae4all_prof_initial[a];
+	if (uae4all_prof_tracing)
+		uae4all_prof_trace(a,1,t);
 }
 
 void uae4all_prof_init(void);
-void uae4all_prof_add(char *msg);
+void uae4all_prof_frame(void);
+void uae4all_prof_trace_start(void);
 void uae4all_prof_show(void);
+void uae4all_prof_dump_csv(const char *filename);
+void uae4all_prof_dump_trace(const char *filename);
 
 #endif
 
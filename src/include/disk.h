@@ -22,6 +22,9 @@ extern FILE *DISK_validate_filename (const char *, int, int *);
 extern void DISK_handler (void);
 extern void DISK_update (int vpos);
 extern void DISK_reset (void);
+#ifdef USE_DISK_TRACK_CACHE
+extern unsigned disk_cache_hits, disk_cache_misses;
+#endif
 
 extern void DSKLEN (uae_u16 v, int hpos);
 extern uae_u16 DSKDATR (int hpos);
@@ -14,6 +14,11 @@
 #error UAE4ALL_ALIGN NO DEFINIDO
 #endif
 
+/* Dirty-line skipping is driven by the per-line change state */
+#if defined(USE_DIRTY_LINES) && !defined(USE_LINESTATE)
+#define USE_LINESTATE
+#endif
+
 /* calculate shift depending on resolution (replaced "decided_hires ? 4 : 8") (TW) */
 #define RES_SHIFT(res) ((res) == RES_LORES ? 8 : (res) == RES_HIRES ? 4 : 2)
 
@@ -54,6 +59,13 @@ static __inline__ int coord_window_to_diw_x (int x)
 }
 
 extern int framecnt;
+#ifdef USE_RENDER_THREAD
+extern int render_thread_enabled;
+extern void render_thread_stop (void);
+#endif
+#ifdef USE_AUTO_FRAMESKIP
+extern int auto_frameskip_shown;
+#endif
 
 
 /* color values in two formats: 12 (OCS/ECS) or 24 (AJA) bit Amiga RGB (color_uae_regs),
@@ -201,7 +213,7 @@ enum nln_how {
     nln_nblack
 };
 
-#if defined(USE_LINESTATE) || !defined(USE_ALL_LINES)
+#if defined(USE_LINESTATE) || !defined(USE_ALL_LINES) || defined(USE_RENDER_THREAD)
 extern void hsync_record_line_state (int lineno, int changed);
 #else
 #define hsync_record_line_state(LN,CH)
@@ -35,6 +35,93 @@ enum {
 
 extern struct ev eventtab[ev_max];
 
+#ifdef USE_EVENT_QUEUE
+
+/* Active events kept in a binary min-heap ordered by time to go
+ * (evtime - currcycle), ties broken by index like the eventtab scan.
+ * Advancing currcycle shifts every key by the same amount, so the heap
+ * only has to be fixed up when an event is changed: anything that
+ * writes eventtab[].active or .evtime must call event_changed(). */
+
+extern int event_queue[ev_max];
+extern int event_queue_pos[ev_max];	/* -1 when not queued */
+extern int event_queue_len;
+
+static __inline__ int event_queue_before (int a, int b)
+{
+    unsigned long int ta = eventtab[a].evtime - currcycle;
+    unsigned long int tb = eventtab[b].evtime - currcycle;
+    return ta < tb || (ta == tb && a < b);
+}
+
+static __inline__ void event_queue_up (int pos)
+{
+    int ev = event_queue[pos];
+    while (pos > 0) {
+	int parent = (pos - 1) >> 1;
+	if (!event_queue_before (ev, event_queue[parent]))
+	    break;
+	event_queue[pos] = event_queue[parent];
+	event_queue_pos[event_queue[pos]] = pos;
+	pos = parent;
+    }
+    event_queue[pos] = ev;
+    event_queue_pos[ev] = pos;
+}
+
+static __inline__ void event_queue_down (int pos)
+{
+    int ev = event_queue[pos];
+    for (;;) {
+	int child = 2 * pos + 1;
+	if (child >= event_queue_len)
+	    break;
+	if (child + 1 < event_queue_len && event_queue_before (event_queue[child + 1], event_queue[child]))
+	    child++;
+	if (!event_queue_before (event_queue[child], ev))
+	    break;
+	event_queue[pos] = event_queue[child];
+	event_queue_pos[event_queue[pos]] = pos;
+	pos = child;
+    }
+    event_queue[pos] = ev;
+    event_queue_pos[ev] = pos;
+}
+
+static __inline__ void event_changed (int ev)
+{
+    int pos = event_queue_pos[ev];
+
+    if (eventtab[ev].active) {
+	if (pos < 0) {
+	    pos = event_queue_len++;
+	    event_queue[pos] = ev;
+	}
+	event_queue_up (pos);
+	event_queue_down (event_queue_pos[ev]);
+    } else if (pos >= 0) {
+	int last = event_queue[--event_queue_len];
+	event_queue_pos[ev] = -1;
+	if (last != ev) {
+	    event_queue[pos] = last;
+	    event_queue_up (pos);
+	    event_queue_down (event_queue_pos[last]);
+	}
+    }
+}
+
+static __inline__ void events_schedule (void)
+{
+    if (event_queue_len)
+	nextevent = eventtab[event_queue[0]].evtime;
+    else
+	nextevent = currcycle + ~0L;
+}
+
+#else
+
+#define event_changed(ev)
+
 static __inline__ void events_schedule (void)
 {
     int i;
@@ -50,6 +137,8 @@ static __inline__ void events_schedule (void)
     nextevent = currcycle + mintime;
 }
 
+#endif
+
 static __inline__ void do_cycles_slow (unsigned long cycles_to_add)
 {
 #ifdef DEBUG_CYCLES
@@ -0,0 +1,176 @@
+/*
+ * Planar to chunky conversion for pfield_doline
+ *
+ * pfield_c2p_scalar() is the MERGE butterfly of pfield_doline_1 in
+ * drawing.cpp: one 32-bit word per plane in, 32 pixel bytes out.
+ * pfield_c2p_vector() runs the same butterfly on four words per plane
+ * at a time in 128-bit vectors (GCC vector extensions, so SSE2, NEON
+ * or MSA code depending on the target) and must stay bit-exact with
+ * the scalar version; bench/bench-c2p.cpp checks that.
+ *
+ * The includer provides uae_u8/uae_u32.
+ */
+
+#ifndef PFIELD_C2P_H
+#define PFIELD_C2P_H
+
+#define C2P_MERGE(a,b,mask,shift) {\
+    uae_u32 tmp = mask & (a ^ (b >> shift)); \
+    a ^= tmp; \
+    b ^= (tmp << shift); \
+}
+
+#define C2P_SWLONG(A,V) {\
+	uae_u8 *b = (uae_u8 *)(A); \
+	uae_u32 v = (V); \
+	*b++ = v >> 24; \
+	*b++ = v >> 16; \
+	*b++ = v >> 8; \
+	*b = v; \
+}
+
+/* bplpt[n] is advanced past the words converted, as real_bplpt is */
+static __inline__ void pfield_c2p_scalar (uae_u32 *pixels, int wordcount, uae_u8 **bplpt, int planes)
+{
+    while (wordcount-- > 0) {
+	uae_u32 b0, b1, b2, b3, b4, b5, b6, b7;
+
+	b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0, b7 = 0;
+	switch (planes) {
+	case 8: b0 = *(uae_u32 *)bplpt[7]; bplpt[7] += 4;
+	case 7: b1 = *(uae_u32 *)bplpt[6]; bplpt[6] += 4;
+	case 6: b2 = *(uae_u32 *)bplpt[5]; bplpt[5] += 4;
+	case 5: b3 = *(uae_u32 *)bplpt[4]; bplpt[4] += 4;
+	case 4: b4 = *(uae_u32 *)bplpt[3]; bplpt[3] += 4;
+	case 3: b5 = *(uae_u32 *)bplpt[2]; bplpt[2] += 4;
+	case 2: b6 = *(uae_u32 *)bplpt[1]; bplpt[1] += 4;
+	case 1: b7 = *(uae_u32 *)bplpt[0]; bplpt[0] += 4;
+	}
+
+	C2P_MERGE (b0, b1, 0x55555555, 1);
+	C2P_MERGE (b2, b3, 0x55555555, 1);
+	C2P_MERGE (b4, b5, 0x55555555, 1);
+	C2P_MERGE (b6, b7, 0x55555555, 1);
+
+	C2P_MERGE (b0, b2, 0x33333333, 2);
+	C2P_MERGE (b1, b3, 0x33333333, 2);
+	C2P_MERGE (b4, b6, 0x33333333, 2);
+	C2P_MERGE (b5, b7, 0x33333333, 2);
+
+	C2P_MERGE (b0, b4, 0x0f0f0f0f, 4);
+	C2P_MERGE (b1, b5, 0x0f0f0f0f, 4);
+	C2P_MERGE (b2, b6, 0x0f0f0f0f, 4);
+	C2P_MERGE (b3, b7, 0x0f0f0f0f, 4);
+
+	C2P_MERGE (b0, b1, 0x00ff00ff, 8);
+	C2P_MERGE (b2, b3, 0x00ff00ff, 8);
+	C2P_MERGE (b4, b5, 0x00ff00ff, 8);
+	C2P_MERGE (b6, b7, 0x00ff00ff, 8);
+
+	C2P_MERGE (b0, b2, 0x0000ffff, 16);
+	C2P_MERGE (b1, b3, 0x0000ffff, 16);
+	C2P_MERGE (b4, b6, 0x0000ffff, 16);
+	C2P_MERGE (b5, b7, 0x0000ffff, 16);
+	C2P_SWLONG (pixels, b0);
+	C2P_SWLONG (pixels + 1, b4);
+	C2P_SWLONG (pixels + 2, b1);
+	C2P_SWLONG (pixels + 3, b5);
+	C2P_SWLONG (pixels + 4, b2);
+	C2P_SWLONG (pixels + 5, b6);
+	C2P_SWLONG (pixels + 6, b3);
+	C2P_SWLONG (pixels + 7, b7);
+	pixels += 8;
+    }
+}
+
+/* Only where the vector extensions map onto a real 128-bit unit; on
+   plain MIPS32 GCC would split them back into scalar code. The byte
+   swap before the stores assumes a little-endian target. */
+#if defined(__GNUC__) && !defined(__clang__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && \
+    (defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__mips_msa))
+#define PFIELD_C2P_VECTOR
+
+typedef uae_u32 c2p_v4 __attribute__ ((vector_size (16)));
+/* Plane rows and apixels are only 32-bit aligned */
+typedef uae_u32 c2p_v4u __attribute__ ((vector_size (16), aligned (4), may_alias));
+
+#define C2P_VMERGE(a,b,mask,shift) {\
+    c2p_v4 tmp = (a ^ (b >> shift)) & (c2p_v4){ mask, mask, mask, mask }; \
+    a ^= tmp; \
+    b ^= (tmp << shift); \
+}
+
+#define C2P_VSWAP(v) \
+    (((v) << 24) | (((v) << 8) & (c2p_v4){ 0xff0000, 0xff0000, 0xff0000, 0xff0000 }) \
+     | (((v) >> 8) & (c2p_v4){ 0xff00, 0xff00, 0xff00, 0xff00 }) | ((v) >> 24))
+
+/* Lane n of each input belongs to plane word n; store the four 8-long
+   pixel groups, longs ordered b0 b4 b1 b5 b2 b6 b3 b7 as in the scalar
+   version. a/b/c/d are transposed 4x4 into pixels + 8n + off. */
+#define C2P_VSTORE4(p,off,a,b,c,d) {\
+    c2p_v4 t0 = __builtin_shuffle (a, b, (c2p_v4){ 0, 4, 1, 5 }); \
+    c2p_v4 t1 = __builtin_shuffle (c, d, (c2p_v4){ 0, 4, 1, 5 }); \
+    c2p_v4 t2 = __builtin_shuffle (a, b, (c2p_v4){ 2, 6, 3, 7 }); \
+    c2p_v4 t3 = __builtin_shuffle (c, d, (c2p_v4){ 2, 6, 3, 7 }); \
+    *(c2p_v4u *)((p) + (off)) = __builtin_shuffle (t0, t1, (c2p_v4){ 0, 1, 4, 5 }); \
+    *(c2p_v4u *)((p) + 8 + (off)) = __builtin_shuffle (t0, t1, (c2p_v4){ 2, 3, 6, 7 }); \
+    *(c2p_v4u *)((p) + 16 + (off)) = __builtin_shuffle (t2, t3, (c2p_v4){ 0, 1, 4, 5 }); \
+    *(c2p_v4u *)((p) + 24 + (off)) = __builtin_shuffle (t2, t3, (c2p_v4){ 2, 3, 6, 7 }); \
+}
+
+static __inline__ void pfield_c2p_vector (uae_u32 *pixels, int wordcount, uae_u8 **bplpt, int planes)
+{
+    for (; wordcount >= 4; wordcount -= 4) {
+	c2p_v4 b0, b1, b2, b3, b4, b5, b6, b7;
+
+	b0 = b1 = b2 = b3 = b4 = b5 = b6 = b7 = (c2p_v4){ 0, 0, 0, 0 };
+	switch (planes) {
+	case 8: b0 = *(c2p_v4u *)bplpt[7]; bplpt[7] += 16;
+	case 7: b1 = *(c2p_v4u *)bplpt[6]; bplpt[6] += 16;
+	case 6: b2 = *(c2p_v4u *)bplpt[5]; bplpt[5] += 16;
+	case 5: b3 = *(c2p_v4u *)bplpt[4]; bplpt[4] += 16;
+	case 4: b4 = *(c2p_v4u *)bplpt[3]; bplpt[3] += 16;
+	case 3: b5 = *(c2p_v4u *)bplpt[2]; bplpt[2] += 16;
+	case 2: b6 = *(c2p_v4u *)bplpt[1]; bplpt[1] += 16;
+	case 1: b7 = *(c2p_v4u *)bplpt[0]; bplpt[0] += 16;
+	}
+
+	C2P_VMERGE (b0, b1, 0x55555555, 1);
+	C2P_VMERGE (b2, b3, 0x55555555, 1);
+	C2P_VMERGE (b4, b5, 0x55555555, 1);
+	C2P_VMERGE (b6, b7, 0x55555555, 1);
+
+	C2P_VMERGE (b0, b2, 0x33333333, 2);
+	C2P_VMERGE (b1, b3, 0x33333333, 2);
+	C2P_VMERGE (b4, b6, 0x33333333, 2);
+	C2P_VMERGE (b5, b7, 0x33333333, 2);
+
+	C2P_VMERGE (b0, b4, 0x0f0f0f0f, 4);
+	C2P_VMERGE (b1, b5, 0x0f0f0f0f, 4);
+	C2P_VMERGE (b2, b6, 0x0f0f0f0f, 4);
+	C2P_VMERGE (b3, b7, 0x0f0f0f0f, 4);
+
+	C2P_VMERGE (b0, b1, 0x00ff00ff, 8);
+	C2P_VMERGE (b2, b3, 0x00ff00ff, 8);
+	C2P_VMERGE (b4, b5, 0x00ff00ff, 8);
+	C2P_VMERGE (b6, b7, 0x00ff00ff, 8);
+
+	C2P_VMERGE (b0, b2, 0x0000ffff, 16);
+	C2P_VMERGE (b1, b3, 0x0000ffff, 16);
+	C2P_VMERGE (b4, b6, 0x0000ffff, 16);
+	C2P_VMERGE (b5, b7, 0x0000ffff, 16);
+
+	b0 = C2P_VSWAP (b0); b1 = C2P_VSWAP (b1);
+	b2 = C2P_VSWAP (b2); b3 = C2P_VSWAP (b3);
+	b4 = C2P_VSWAP (b4); b5 = C2P_VSWAP (b5);
+	b6 = C2P_VSWAP (b6); b7 = C2P_VSWAP (b7);
+	C2P_VSTORE4 (pixels, 0, b0, b4, b1, b5);
+	C2P_VSTORE4 (pixels, 4, b2, b6, b3, b7);
+	pixels += 32;
+    }
+    pfield_c2p_scalar (pixels, wordcount, bplpt, planes);
+}
+
+#endif
+
+#endif
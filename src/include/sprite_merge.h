@@ -0,0 +1,113 @@
+/*
+ * Sprite compositing for drawing.cpp
+ *
+ * draw_sprites_1() decodes every pixel of a sprite entry against the
+ * playfield pixel under it: the playfield priority mask, then the lowest
+ * sprite pair left, then its color. Both halves can be split, because
+ * the masks from pfield_expand_dp_bplcon() always hide a pair and all
+ * pairs behind it. A sprite pixel is then shown exactly when its lowest
+ * pair is in front of the playfield, whatever the pairs behind it are.
+ *
+ * So the pixel loop of sprite_composite() works from two tables instead.
+ * sprite_merge_lo/hi turn the spixels value of a pixel into one merged
+ * byte: its color (16-31) with its lowest pair above it. Which pair is
+ * that does not depend on the playfield. sprite_merge_front holds, for
+ * each playfield pixel value, the first pair hidden behind it, as a
+ * merged byte. The priority check is then one compare, and the table is
+ * only rebuilt when BPLCON2 or the playfield mode changes.
+ * bench/bench-sprites.cpp checks the result against draw_sprites_1()
+ * bit for bit.
+ *
+ * The includer provides uae_u8/uae_u16/uae_u32.
+ */
+
+#ifndef SPRITE_MERGE_H
+#define SPRITE_MERGE_H
+
+/* merged byte: color 16-31 in bits 0-4, sprite pair in bits 5-6,
+   SPRITE_MERGE_NONE for no sprite */
+#define SPRITE_MERGE_NONE 0xFF
+#define SPRITE_MERGE_COL(S) ((S) & 31)
+
+/* Merged bytes for the two pairs in the low and in the high byte of a
+   spixels value */
+static uae_u8 sprite_merge_lo[256], sprite_merge_hi[256];
+
+static void sprite_merge_init (void)
+{
+    int i;
+
+    sprite_merge_lo[0] = sprite_merge_hi[0] = SPRITE_MERGE_NONE;
+    for (i = 1; i < 256; i++) {
+	int pair = (i & 15) ? 0 : 1;
+	int v = (i >> (pair * 4)) & 15;
+	int col = (v & 3) ? (v & 3) : v >> 2;
+	sprite_merge_lo[i] = (pair << 5) | (16 + pair * 4 + col);
+	sprite_merge_hi[i] = ((pair + 2) << 5) | (16 + (pair + 2) * 4 + col);
+    }
+}
+
+/* For every playfield pixel value, the merged bytes shown over it: those
+   below front[value]. Depends on shift_lookup and plf_sprite_mask only,
+   so it is only worked out again when one of them changes. */
+static uae_u8 sprite_merge_front[256];
+
+static __inline__ void sprite_merge_set_front (const int *shift_lookup, uae_u32 plf_sprite_mask)
+{
+    static const int *last_lookup;
+    static uae_u32 last_mask;
+    uae_u8 front[3];
+    int i;
+
+    if (shift_lookup == last_lookup && plf_sprite_mask == last_mask)
+	return;
+    last_lookup = shift_lookup;
+    last_mask = plf_sprite_mask;
+
+    /* the first pair hidden at each maskshift (0, 8 and 16) */
+    for (i = 0; i < 3; i++) {
+	int maskshift = i * 8;
+	uae_u32 plfmask = ((plf_sprite_mask >> maskshift) >> maskshift) & 0xFFFF;
+	int pair = 0;
+
+	while (pair < 4 && !((plfmask >> (pair * 4)) & 15))
+	    pair++;
+	front[i] = pair << 5;
+    }
+    for (i = 0; i < 256; i++)
+	sprite_merge_front[i] = front[shift_lookup[i] >> 3];
+}
+
+/* The n sprite pixels at spix/stbuf over apixels from window_pos on,
+   2 apixels per sprite pixel when doubling; add is 128 in dual playfield */
+static __inline__ void sprite_composite (uae_u8 *apixels, int window_pos, const uae_u16 *spix,
+					 const uae_u8 *stbuf, int n, int has_attached,
+					 int add, int doubling)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	unsigned int v = spix[i], s;
+	int wp;
+
+	if (v == 0)
+	    continue;
+	s = (v & 255) ? sprite_merge_lo[v & 255] : sprite_merge_hi[v >> 8];
+	wp = window_pos + (i << doubling);
+	if (s >= sprite_merge_front[apixels[wp]])
+	    continue;
+	if (has_attached) {
+	    /* an attached pair shows its four bits as one color */
+	    unsigned int pair = s >> 5;
+	    if (stbuf[i] & (1 << (pair * 2)))
+		s = 16 + ((v >> (pair * 4)) & 15);
+	}
+	if (doubling)
+	    /* the pixel pair apixels_w[wp >> 1], as draw_sprites_1() */
+	    apixels[wp & ~1] = apixels[wp | 1] = SPRITE_MERGE_COL (s) + add;
+	else
+	    apixels[wp] = SPRITE_MERGE_COL (s) + add;
+    }
+}
+
+#endif
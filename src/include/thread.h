@@ -36,6 +36,7 @@ typedef int smp_comm_pipe;
 #define comm_pipe_has_data(a) 0
 
 typedef int uae_thread_id;
+#define uae_wait_thread(a)
 
 
 #else
@@ -68,6 +69,8 @@ static __inline__ int uae_start_thread (void *(*f) (void *), void *arg, uae_thre
     return *foo == 0;
 }
 
+#define uae_wait_thread(TID) SDL_WaitThread (TID, NULL)
+
 /* Do nothing; thread exits if thread function returns.  */
 #define UAE_THREAD_EXIT do {} while (0)
 
@@ -1,3 +1,26 @@
+/* Pixel pairs packed for one 32-bit store, leftmost pixel at the lower
+   address; 64-bit targets store four pixels at once. */
+#ifndef LINETOSCR_PAIR
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define LINETOSCR_PAIR(a,b) (((uae_u32)(uae_u16)(a) << 16) | (uae_u16)(b))
+#else
+#define LINETOSCR_PAIR(a,b) ((uae_u16)(a) | ((uae_u32)(uae_u16)(b) << 16))
+#endif
+#if defined(__LP64__) && !(defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+typedef uae_u64 linetoscr_word __attribute__ ((may_alias));
+#define LINETOSCR_STORE4(d,a,b,c,e) { \
+    *d++ = LINETOSCR_PAIR (a, b) | ((uae_u64)LINETOSCR_PAIR (c, e) << 32); \
+}
+#else
+typedef uae_u32 linetoscr_word __attribute__ ((may_alias));
+#define LINETOSCR_STORE4(d,a,b,c,e) { \
+    d[0] = LINETOSCR_PAIR (a, b); \
+    d[1] = LINETOSCR_PAIR (c, e); \
+    d += 2; \
+}
+#endif
+#endif
+
 
 static void LNAME (int dpix, int stoppos)
 {
@@ -7,6 +30,7 @@ static void LNAME (int dpix, int stoppos)
 
     unsigned short *buf = ((unsigned short *)xlinebuffer);
     int spix=src_pixel;
+    xcolnr *acolors = DRAWING_ACOLORS;
 #if defined(DREAMCAST)
 	    register int resto=(((unsigned)&buf[dpix])&0x1f);
 	    if (resto)
@@ -14,7 +38,7 @@ static void LNAME (int dpix, int stoppos)
 	    if (resto>(stoppos-dpix))
 		resto=(stoppos-dpix);
 	    while (resto>0) {
-	    	buf[dpix++]= (colors_for_drawing.acolors[pixdata.apixels[spix]]);
+	    	buf[dpix++]= (acolors[pixdata.apixels[spix]]);
 	    	spix += SRC_INC;
 		resto-=2;
 	    }
@@ -25,7 +49,7 @@ static void LNAME (int dpix, int stoppos)
 
 	    unsigned int *d = (unsigned int *)(void *)
 		    (0xe0000000 | (((unsigned long)&buf[dpix]) & 0x03ffffe0));
-	    unsigned short *s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]];
+	    unsigned short *s = (unsigned short *)&acolors[pixdata.apixels[spix]];
 	    unsigned n=((stoppos-dpix)>>4);
 	    {
 		    register unsigned tmp=n<<4;
@@ -38,22 +62,22 @@ static void LNAME (int dpix, int stoppos)
 //		    asm("pref @%0" : : "r" (s + 8));
 		    register unsigned dato;
 
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
-		    d[0] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
-		    d[1] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
-		    d[2] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
-		    d[3] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
-		    d[4] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
-		    d[5] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
-		    d[6] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
-		    d[7] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[pixdata.apixels[spix]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
+		    d[0] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
+		    d[1] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
+		    d[2] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
+		    d[3] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
+		    d[4] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
+		    d[5] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
+		    d[6] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]]; dato|=(((unsigned)*s)<<16);
+		    d[7] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[pixdata.apixels[spix]];
 		    asm("pref @%0" : : "r" (d));
 		    d+=8;
 	    }
@@ -61,16 +85,32 @@ static void LNAME (int dpix, int stoppos)
 	    d[0] = d[8] = 0;
 
 	    while (resto>0) {
-		    buf[dpix++]= (colors_for_drawing.acolors[pixdata.apixels[spix]]);
+		    buf[dpix++]= (acolors[pixdata.apixels[spix]]);
 		    spix += SRC_INC;
 		    resto--;
 	    }
 
 #else
+#define LINETOSCR_COL(o) acolors[pixdata.apixels[spix + (o) * SRC_INC]]
+	/* Four pixels per iteration as aligned word stores */
+	while ((((unsigned long)&buf[dpix]) & (sizeof (linetoscr_word) - 1)) && dpix < stoppos) {
+	    buf[dpix++] = LINETOSCR_COL (0);
+	    spix += SRC_INC;
+	}
+	{
+	    linetoscr_word *d = (linetoscr_word *)&buf[dpix];
+	    int n = (stoppos - dpix) >> 2;
+	    dpix += n << 2;
+	    while (n-- > 0) {
+		LINETOSCR_STORE4 (d, LINETOSCR_COL (0), LINETOSCR_COL (1), LINETOSCR_COL (2), LINETOSCR_COL (3));
+		spix += 4 * SRC_INC;
+	    }
+	}
 	while (dpix < stoppos) {
-	    buf[dpix++]= (colors_for_drawing.acolors[pixdata.apixels[spix]]);
+	    buf[dpix++] = LINETOSCR_COL (0);
 	    spix += SRC_INC;
 	}
+#undef LINETOSCR_COL
 #endif
     src_pixel = (int)spix;
 }
@@ -7,6 +7,7 @@ static void LNAME (int dpix, int stoppos)
 
     unsigned short *buf = ((unsigned short *)xlinebuffer);
     int spix=src_pixel;
+    xcolnr *acolors = DRAWING_ACOLORS;
 
 	    // OCS/ECS Dual playfield 
 	    int *lookup = bpldualpfpri ? dblpf_ind2 : dblpf_ind1;
@@ -18,7 +19,7 @@ static void LNAME (int dpix, int stoppos)
 	    if (resto>(stoppos-dpix))
 		resto=(stoppos-dpix);
 	    while (resto>0) {
-		register unsigned short d = colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
+		register unsigned short d = acolors[lookup[pixdata.apixels[spix]]];
 		buf[dpix++]= d;
 	    	spix += SRC_INC;
 		resto-=2;
@@ -30,7 +31,7 @@ static void LNAME (int dpix, int stoppos)
 
 	    unsigned int *d = (unsigned int *)(void *)
 		    (0xe0000000 | (((unsigned long)&buf[dpix]) & 0x03ffffe0));
-	    unsigned short *s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
+	    unsigned short *s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]];
 	    unsigned n=((stoppos-dpix)>>4);
 	    {
 		    register unsigned tmp=n<<4;
@@ -43,22 +44,22 @@ static void LNAME (int dpix, int stoppos)
 //		    asm("pref @%0" : : "r" (s + 8));
 		    register unsigned dato;
 
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
-		    d[0] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
-		    d[1] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
-		    d[2] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
-		    d[3] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
-		    d[4] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
-		    d[5] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
-		    d[6] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
-		    dato=*s; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
-		    d[7] = dato; spix += SRC_INC; s = (unsigned short *)&colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
+		    d[0] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
+		    d[1] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
+		    d[2] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
+		    d[3] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
+		    d[4] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
+		    d[5] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
+		    d[6] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]];
+		    dato=*s; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]]; dato|=(((unsigned)*s)<<16);
+		    d[7] = dato; spix += SRC_INC; s = (unsigned short *)&acolors[lookup[pixdata.apixels[spix]]];
 		    asm("pref @%0" : : "r" (d));
 		    d+=8;
 	    }
@@ -66,7 +67,7 @@ static void LNAME (int dpix, int stoppos)
 	    d[0] = d[8] = 0;
 
 	    while (resto>0) {
-		    register unsigned short d = colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
+		    register unsigned short d = acolors[lookup[pixdata.apixels[spix]]];
 		    buf[dpix++]= d;
 		    spix += SRC_INC;
 		    resto--;
@@ -75,11 +76,26 @@ static void LNAME (int dpix, int stoppos)
 
 
 #else
+#define LINETOSCR_COL(o) acolors[lookup[pixdata.apixels[spix + (o) * SRC_INC]]]
+	    /* Four pixels per iteration as aligned word stores */
+	    while ((((unsigned long)&buf[dpix]) & (sizeof (linetoscr_word) - 1)) && dpix < stoppos) {
+		buf[dpix++] = LINETOSCR_COL (0);
+		spix += SRC_INC;
+	    }
+	    {
+		linetoscr_word *d = (linetoscr_word *)&buf[dpix];
+		int n = (stoppos - dpix) >> 2;
+		dpix += n << 2;
+		while (n-- > 0) {
+		    LINETOSCR_STORE4 (d, LINETOSCR_COL (0), LINETOSCR_COL (1), LINETOSCR_COL (2), LINETOSCR_COL (3));
+		    spix += 4 * SRC_INC;
+		}
+	    }
 	    while (dpix < stoppos) {
-		register unsigned short d = colors_for_drawing.acolors[lookup[pixdata.apixels[spix]]];
-		buf[dpix++] = d;
+		buf[dpix++] = LINETOSCR_COL (0);
 		spix += SRC_INC;
 	    }
+#undef LINETOSCR_COL
 #endif
 
 
@@ -183,6 +183,13 @@ void     m68k_stop_emulating(void);
 void     m68k_add_cycles(int cycles);
 void     m68k_release_cycles(int cycles);
 
+#ifdef FAME_PREDECODE
+/* Opcode handlers cached per word of a range of code (FAME_PREDECODE) */
+void m68k_predecode_range(unsigned low_addr, unsigned high_addr);
+void m68k_predecode_invalidate(unsigned low_addr, unsigned high_addr);
+void m68k_predecode_stats(unsigned *hits, unsigned *misses);
+#endif
+
 #if defined(__cplusplus) && !defined(USE_FAME_CORE_C)
 }
 #endif
@@ -34,6 +34,7 @@
 /* #define FAME_GLOBAL_CONTEXT */
 /* #define FAME_DEBUG */
 /* #define FAME_GOTOS */
+/* #define FAME_PREDECODE */
 /* #define FAME_BIG_ENDIAN */
 
 #define FAME_SECURE_ALL_BANKS
@@ -264,11 +265,17 @@
 #define DEBUG_OPCODE(OP)
 #endif
 
+#ifdef FAME_PREDECODE
+#define OPCODE_HANDLER famec_Predecoded()
+#else
+#define OPCODE_HANDLER JumpTable[Opcode]
+#endif
+
 #ifdef FAME_GOTOS
 #define NEXT                    \
     FETCH_WORD(Opcode);         \
     DEBUG_OPCODE(Opcode) \
-    goto *JumpTable[Opcode];
+    goto *OPCODE_HANDLER;
 
 #ifdef FAME_INLINE_LOOP
 #define RET(A)                                      \
@@ -293,7 +300,7 @@
 	do { \
 		FETCH_WORD(Opcode); \
 		DEBUG_OPCODE(Opcode) \
-		JumpTable[Opcode](); \
+		OPCODE_HANDLER(); \
 	} while(io_cycle_counter>0);
 
 #ifdef FAME_INLINE_LOOP
@@ -303,7 +310,7 @@
     { \
 	    FETCH_WORD(Opcode); \
 	    DEBUG_OPCODE(Opcode) \
-	    JumpTable[Opcode](); \
+	    OPCODE_HANDLER(); \
     } \
     return;
 
@@ -338,6 +345,9 @@
 
 #define INC_PC(I) (PC += I)
 
+/* byte offset of the opcode just fetched from the predecoded range */
+#define PREDECODE_OFFSET (((PC - 2) & M68K_ADDR_MASK) - PredecodeLow)
+
 #else
 
 #define UNBASED_PC ((u32)PC - BasePC)
@@ -352,6 +362,8 @@
 
 #define INC_PC(I) (PC += (I) >> 1)
 
+#define PREDECODE_OFFSET ((u32)((u8 *)(PC - 1) - PredecodeBase))
+
 #endif
 
 #define READ_BYTE_F(A, D)           \
@@ -4761,6 +4773,17 @@ typedef void (*opcode_func)(void);
 
 static opcode_func JumpTable[0x10000];
 
+#ifdef FAME_PREDECODE
+/* The handlers of the opcodes in one range of code that only changes
+   through m68k_predecode_invalidate() (the Kickstart ROM), one per word,
+   filled from the JumpTable at the first fetch of the word */
+static opcode_func *Predecode;
+static u8 *PredecodeBase;		/* host address of PredecodeLow */
+static u32 PredecodeLow, PredecodeHigh;
+static u32 PredecodeSize;		/* bytes; 0 while not mapped */
+static u32 predecode_hits, predecode_misses;
+#endif
+
 
 static u32 initialised = 0;
 
@@ -4948,11 +4971,42 @@ static void famec_SetDataWW(u32 low_adr, u32 high_adr, void *mh, void *dt)
 }
 #endif
 
+#ifdef FAME_PREDECODE
+/* Finds the predecoded range in host memory again after the fetch banks
+   changed: it has to be one block, and the handlers of another block
+   are forgotten */
+static void famec_SetPredecode(void)
+{
+    u32 bank = (PredecodeLow >> M68K_FETCHSFT) & M68K_FETCHMASK;
+    u32 last = (PredecodeHigh >> M68K_FETCHSFT) & M68K_FETCHMASK;
+    u32 size = PredecodeHigh - PredecodeLow + 1;
+    u8 *base = (u8 *)(Fetch[bank] + PredecodeLow);
+
+    if (!Predecode)
+        return;
+    if (base != PredecodeBase)
+        memset(Predecode, 0, (size >> 1) * sizeof(opcode_func));
+    PredecodeBase = base;
+    PredecodeSize = size;
+    while (bank < last)
+        if (Fetch[++bank] != Fetch[last])
+            PredecodeSize = 0;
+}
+#endif
+
+#ifdef USE_MIPS_DYNAREC
+/* the block translator keeps page tables of its own (m68k_dynarec.h) */
+void m68k_dynarec_set_banks(void);
+#endif
+
 static void famec_SetBanks(void)
 {
     famec_SetDummyFetch();
 
 	SETUP_FETCH_BANK(famec_SetFetch, FAME_CONTEXT.fetch)
+#ifdef FAME_PREDECODE
+    famec_SetPredecode();
+#endif
 
 #ifdef FAME_DIRECT_MAPPING
     famec_SetDummyData();
@@ -4962,6 +5016,9 @@ static void famec_SetBanks(void)
 	SETUP_DATA_BANK(famec_SetDataWB, FAME_CONTEXT.write_byte)
 	SETUP_DATA_BANK(famec_SetDataWW, FAME_CONTEXT.write_word)
 #endif
+#ifdef USE_MIPS_DYNAREC
+    m68k_dynarec_set_banks();
+#endif
 }
 
 #ifdef FAME_ACCURATE_TIMING
@@ -5209,6 +5266,26 @@ static EXTRA_INLINE void Write_Word(u32 addr, u32 data)
 
 static u32 Opcode;
 
+#ifdef FAME_PREDECODE
+/* The handler of the opcode just fetched */
+static EXTRA_INLINE opcode_func famec_Predecoded(void)
+{
+    u32 off = PREDECODE_OFFSET;
+    opcode_func *p;
+
+    if (off >= PredecodeSize)
+        return JumpTable[Opcode];
+    p = &Predecode[off >> 1];
+    if (*p)
+    {
+        predecode_hits++;
+        return *p;
+    }
+    predecode_misses++;
+    return *p = JumpTable[Opcode];
+}
+#endif
+
 /*
  Chequea las interrupciones y las inicia
 */
@@ -5899,6 +5976,51 @@ u32 FAME_API(get_cpu_state)(void)
     return FAME_CONTEXT.execinfo;
 }
 
+#ifdef FAME_PREDECODE
+/*****************************************************************************/
+/* m68k_predecode_range(low_addr, high_addr)                                 */
+/* Caches the opcode handlers of the code from low_addr to high_addr, which  */
+/* must only change through m68k_predecode_invalidate()                      */
+/*****************************************************************************/
+void FAME_API(predecode_range)(u32 low_addr, u32 high_addr)
+{
+    free(Predecode);
+    PredecodeLow = low_addr & M68K_ADDR_MASK & ~1;
+    PredecodeHigh = high_addr & M68K_ADDR_MASK;
+    Predecode = (opcode_func *)calloc((PredecodeHigh - PredecodeLow + 1) >> 1, sizeof(opcode_func));
+    PredecodeBase = NULL;
+    PredecodeSize = 0;
+    predecode_hits = predecode_misses = 0;
+    famec_SetPredecode();
+}
+
+/*****************************************************************************/
+/* m68k_predecode_invalidate(low_addr, high_addr)                            */
+/* Forgets the handlers cached for the words from low_addr to high_addr      */
+/*****************************************************************************/
+void FAME_API(predecode_invalidate)(u32 low_addr, u32 high_addr)
+{
+    if (!Predecode || high_addr < PredecodeLow || low_addr > PredecodeHigh)
+        return;
+    if (low_addr < PredecodeLow)
+        low_addr = PredecodeLow;
+    if (high_addr > PredecodeHigh)
+        high_addr = PredecodeHigh;
+    memset(&Predecode[(low_addr - PredecodeLow) >> 1], 0,
+           (((high_addr - PredecodeLow) >> 1) - ((low_addr - PredecodeLow) >> 1) + 1) * sizeof(opcode_func));
+}
+
+/*****************************************************************************/
+/* m68k_predecode_stats(&hits, &misses)                                      */
+/* Opcodes fetched from the range with their handler cached, and without     */
+/*****************************************************************************/
+void FAME_API(predecode_stats)(u32 *hits, u32 *misses)
+{
+    *hits = predecode_hits;
+    *misses = predecode_misses;
+}
+#endif
+
 
 /*
  main exec function
@@ -0,0 +1,318 @@
+/*
+ * Idle loop skipping, included by m68k_intrf.cpp with USE_CPU_IDLE_SKIP.
+ *
+ * The beam counters, CIA timers, DMA and the blitter only move in
+ * do_cycles() between two m68k_emulate() calls, so a loop that just
+ * polls VHPOSR, INTREQR, DMACONR, the CIAs or memory reads the same
+ * values over and over until the slice ends. When two slices in a row
+ * end a few bytes apart, m68k_idle_emulate() single steps the next two
+ * passes of the loop: every instruction must be one that writes nothing
+ * and reads nothing with side effects, and the second pass must leave
+ * the registers, SR and cycle count exactly as the first did. Then all
+ * passes but the last ones of the slice are skipped by adding their
+ * cycles, and the slice ends on the same instruction and state as it
+ * would have.
+ *
+ * A start PC whose probes keep failing is blacklisted; loops that were
+ * skipped are counted per PC, for m68k_idle_show().
+ */
+
+#ifndef M68K_IDLE_H
+#define M68K_IDLE_H
+
+#define IDLE_MAX_INSNS 8	/* per pass */
+#define IDLE_NEAR 32		/* bytes between the PCs two slices ended at */
+#define IDLE_MIN_SLICE 128	/* cycles; shorter slices just run */
+#define IDLE_MAX_FAILS 4	/* probes in a row without a skip before blacklisting */
+#define IDLE_CACHE 256
+
+enum { IDLE_UNKNOWN, IDLE_LOOP, IDLE_NOT };
+
+struct idle_entry {
+    uae_u32 pc;
+    uae_u16 opcode;		/* at pc, to notice new code */
+    uae_u8 verdict;
+    uae_u8 fails;
+    uae_u32 hits;
+    uae_u32 skipped;		/* cycles */
+};
+
+static struct idle_entry idle_cache[IDLE_CACHE];
+static uae_u32 idle_last_pc = 1;
+static unsigned idle_probes, idle_hits, idle_failed, idle_rejected, idle_blacklisted;
+static double idle_skipped;
+
+/* Custom registers that only change at events: DMACONR, VPOSR, VHPOSR,
+   JOY0DAT, JOY1DAT, ADKCONR, POTGOR, INTENAR, INTREQR */
+static int idle_custom_ok (uae_u32 r)
+{
+    switch (r & 0x1FE) {
+    case 0x002: case 0x004: case 0x006: case 0x00A: case 0x00C:
+    case 0x010: case 0x016: case 0x01C: case 0x01E:
+	return 1;
+    }
+    return 0;
+}
+
+static int idle_read_ok (uae_u32 addr, int size)
+{
+    addrbank *b;
+    uae_u32 r;
+
+    addr &= 0xFFFFFF;
+    b = &get_mem_bank (addr);
+    if (b->baseaddr)
+	return 1;
+    if (b == &custom_bank)
+	return idle_custom_ok (addr) && (size < 4 || idle_custom_ok (addr + 2));
+    if (b == &cia_bank) {
+	/* not the TOD latch, SDR or ICR */
+	r = (addr >> 8) & 0xF;
+	return r <= 7 || r >= 14;
+    }
+    return 0;
+}
+
+/* Extension words a source <ea> takes, -1 if it is not a register, an
+   immediate or a read that idle_read_ok() accepts */
+static int idle_ea (int mode, int reg, int size, uae_u32 ext)
+{
+    uae_u32 addr;
+    int n;
+
+    switch (mode) {
+    case 0:
+    case 1:
+	return 0;
+    case 2:
+	addr = _68k_areg (reg);
+	n = 0;
+	break;
+    case 5:
+	addr = _68k_areg (reg) + (uae_s16)get_word (ext);
+	n = 1;
+	break;
+    case 7:
+	switch (reg) {
+	case 0:
+	    addr = (uae_s16)get_word (ext);
+	    n = 1;
+	    break;
+	case 1:
+	    addr = get_long (ext);
+	    n = 2;
+	    break;
+	case 2:
+	    addr = ext + (uae_s16)get_word (ext);
+	    n = 1;
+	    break;
+	case 4:
+	    return size == 4 ? 2 : 1;
+	default:
+	    return -1;
+	}
+	break;
+    default:
+	return -1;
+    }
+    return idle_read_ok (addr, size) ? n : -1;
+}
+
+/* Whether the instruction at pc writes only data registers and flags,
+   and reads only what idle_ea() accepts: MOVE and MOVEQ to Dn, TST,
+   BTST, CMP, CMPA, CMPI, AND to Dn, ANDI and ORI to Dn, NOP and Bcc */
+static int idle_insn_ok (uae_u32 pc)
+{
+    uae_u32 op, ext = pc + 2;
+    int size, imm, mode, reg;
+
+    /* the whole instruction in one RAM or ROM bank */
+    if (!get_mem_bank (pc).baseaddr || (pc & 0xFFFF) > 0xFFF0)
+	return 0;
+    op = get_word (pc);
+    mode = (op >> 3) & 7;
+    reg = op & 7;
+    switch (op >> 12) {
+    case 0x0:
+	if ((op & 0xFFC0) == 0x0800)		/* BTST #n,<ea> */
+	    return idle_ea (mode, reg, 1, ext + 2) >= 0;
+	if ((op & 0xF1C0) == 0x0100)		/* BTST Dn,<ea> */
+	    return idle_ea (mode, reg, 1, ext) >= 0;
+	if ((op & 0xC0) == 0xC0)
+	    return 0;
+	size = 1 << ((op >> 6) & 3);
+	imm = size == 4 ? 2 : 1;
+	if ((op & 0xFF00) == 0x0C00)		/* CMPI */
+	    return idle_ea (mode, reg, size, ext + imm * 2) >= 0;
+	if (((op & 0xFF00) == 0x0000 || (op & 0xFF00) == 0x0200) && mode == 0)
+	    return 1;				/* ORI, ANDI to Dn */
+	return 0;
+    case 0x1:
+    case 0x2:
+    case 0x3:
+	if (op & 0x01C0)			/* MOVE to anything but Dn */
+	    return 0;
+	size = (op >> 12) == 1 ? 1 : (op >> 12) == 3 ? 2 : 4;
+	return idle_ea (mode, reg, size, ext) >= 0;
+    case 0x4:
+	if (op == 0x4E71)			/* NOP */
+	    return 1;
+	if ((op & 0xFF00) == 0x4A00 && (op & 0xC0) != 0xC0)
+	    return idle_ea (mode, reg, 1 << ((op >> 6) & 3), ext) >= 0;
+	return 0;
+    case 0x6:					/* Bcc, BRA; not BSR */
+	return (op & 0x0F00) != 0x0100 && (op & 0xFF) != 0xFF;
+    case 0x7:					/* MOVEQ */
+	return !(op & 0x100);
+    case 0xB:
+	if ((op & 0xC0) == 0xC0)		/* CMPA */
+	    size = op & 0x100 ? 4 : 2;
+	else if (op & 0x100)			/* EOR, CMPM */
+	    return 0;
+	else					/* CMP */
+	    size = 1 << ((op >> 6) & 3);
+	return idle_ea (mode, reg, size, ext) >= 0;
+    case 0xC:
+	if ((op & 0x100) || (op & 0xC0) == 0xC0)	/* only AND <ea>,Dn */
+	    return 0;
+	return idle_ea (mode, reg, 1 << ((op >> 6) & 3), ext) >= 0;
+    }
+    return 0;
+}
+
+/* all 32 bit, so that memcmp() sees no padding */
+struct idle_state {
+    uae_u32 dreg[8], areg[8], asp;
+    uae_u32 sr;
+};
+
+static void idle_save (struct idle_state *s)
+{
+    memcpy (s->dreg, M68KCONTEXT.dreg, sizeof s->dreg);
+    memcpy (s->areg, M68KCONTEXT.areg, sizeof s->areg);
+    s->asp = M68KCONTEXT.asp;
+    s->sr = M68KCONTEXT.sr;
+}
+
+/* A probe that found no idle loop: the loop may just have ended, so only
+   a run of them, or a start PC that is no idle instruction itself,
+   blacklists it */
+static void idle_fail (struct idle_entry *e, int now)
+{
+    idle_failed++;
+    if (now || ++e->fails >= IDLE_MAX_FAILS) {
+	e->verdict = IDLE_NOT;
+	idle_rejected++;
+    }
+}
+
+/* m68k_emulate (cycles), skipping the passes of an idle loop */
+static void m68k_idle_emulate (int cycles)
+{
+    uae_u32 pc = m68k_get_pc (), start = M68KCONTEXT.cycles_counter, used = 0;
+    uae_u32 mark, period[2];
+    struct idle_state s[2];
+    struct idle_entry *e;
+    uae_u8 irq = M68KCONTEXT.interrupts[0];
+    int pass, n;
+#ifdef FAME_INTERRUPTS_PATCH
+    int go = uae4all_go_interrupt;
+#endif
+
+    /* not with trace, STOP, an interrupt to take first, or code outside
+       RAM and ROM */
+    if (cycles < IDLE_MIN_SLICE || pc - idle_last_pc + IDLE_NEAR > 2 * IDLE_NEAR
+	|| (M68KCONTEXT.sr & 0x8000) || (M68KCONTEXT.execinfo & 0x0080)
+	|| (irq & ((0xFF << (_68k_intmask + 1)) | 0x80))
+	|| !get_mem_bank (pc).baseaddr) {
+	m68k_emulate (cycles);
+	goto out;
+    }
+    e = &idle_cache[(pc >> 1) & (IDLE_CACHE - 1)];
+    if (e->pc != pc || e->opcode != get_word (pc)) {
+	memset (e, 0, sizeof *e);
+	e->pc = pc;
+	e->opcode = get_word (pc);
+    }
+    if (e->verdict == IDLE_NOT) {
+	idle_blacklisted++;
+	m68k_emulate (cycles);
+	goto out;
+    }
+
+    idle_probes++;
+    for (pass = 0; pass < 2; pass++) {
+	mark = M68KCONTEXT.cycles_counter;
+	n = 0;
+	do {
+	    if (!idle_insn_ok (m68k_get_pc ())) {
+		idle_fail (e, pass == 0 && n == 0);
+		goto finish;
+	    }
+	    m68k_emulate (1);
+	    used = M68KCONTEXT.cycles_counter - start;
+	    /* an interrupt raised by a copper sync ends the slice, as
+	       custom.cpp asks for with IO_CYCLE */
+	    if (M68KCONTEXT.interrupts[0] != irq)
+		goto out;
+#ifdef FAME_INTERRUPTS_PATCH
+	    if (uae4all_go_interrupt != go)
+		goto out;
+#endif
+	    if (used >= (uae_u32)cycles)
+		goto out;
+	} while (m68k_get_pc () != pc && ++n < IDLE_MAX_INSNS);
+	if (m68k_get_pc () != pc) {
+	    idle_fail (e, 0);
+	    goto finish;
+	}
+	period[pass] = M68KCONTEXT.cycles_counter - mark;
+	idle_save (&s[pass]);
+    }
+
+    if (period[0] != period[1] || memcmp (&s[0], &s[1], sizeof s[0])) {
+	/* no fixed point (yet), e.g. a counter in the loop */
+	idle_fail (e, 0);
+    } else {
+	/* the state after every further pass is s[1]; leave the last
+	   one or two passes to the core for the exact end */
+	uae_u32 skip = (cycles - used) / period[1];
+
+	if (skip > 1) {
+	    skip = (skip - 1) * period[1];
+	    M68KCONTEXT.cycles_counter += skip;
+	    used += skip;
+	    e->verdict = IDLE_LOOP;
+	    e->fails = 0;
+	    e->hits++;
+	    e->skipped += skip;
+	    idle_hits++;
+	    idle_skipped += skip;
+	}
+    }
+
+finish:
+    if (used < (uae_u32)cycles)
+	m68k_emulate (cycles - used);
+out:
+    idle_last_pc = m68k_get_pc ();
+}
+
+static void m68k_idle_reset (void)
+{
+    memset (idle_cache, 0, sizeof idle_cache);
+    idle_last_pc = 1;
+}
+
+void m68k_idle_show (void)
+{
+    int i;
+
+    printf ("IDLE: %u probes, %u skips of %.0f cycles, %u failed, %u PCs blacklisted, %u slices run on them\n",
+	    idle_probes, idle_hits, idle_skipped, idle_failed, idle_rejected, idle_blacklisted);
+    for (i = 0; i < IDLE_CACHE; i++)
+	if (idle_cache[i].verdict == IDLE_LOOP)
+	    printf (" loop at %06x: %u skips, %u cycles\n", idle_cache[i].pc, idle_cache[i].hits, idle_cache[i].skipped);
+}
+
+#endif
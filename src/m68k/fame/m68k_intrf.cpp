@@ -28,6 +28,13 @@
 
 #include "m68k/debug_m68k.h"
 
+#ifdef USE_CPU_IDLE_SKIP
+#include "m68k_idle.h"
+#endif
+#ifdef USE_MIPS_DYNAREC
+#include "m68k/mips/m68k_dynarec.h"
+#endif
+
 #ifdef FAME_INTERRUPTS_PATCH
 int uae4all_go_interrupt=0;
 #endif
@@ -249,6 +256,12 @@ static void uae4all_reset(void)
 #endif
     M68KCONTEXT.interrupts[0]=0;
     mispcflags=0;
+#ifdef USE_CPU_IDLE_SKIP
+    m68k_idle_reset();
+#endif
+#ifdef USE_MIPS_DYNAREC
+    m68k_dynarec_reset();
+#endif
     _68k_areg(7) = get_long (0x00f80000);
     _68k_setpc(get_long (0x00f80004));
     _68k_sreg = 0x2700;
@@ -277,7 +290,7 @@ static void m68k_run (void)
 		m68k_emulate(1);
 
 #else
-		uae4all_prof_start(0);
+		uae4all_prof_start(UAE4ALL_PROF_M68K);
 #ifdef DEBUG_TIMESLICE
 		unsigned ts=(nextevent - currcycle)>>timeslice_shift;
 #endif
@@ -290,11 +303,17 @@ static void m68k_run (void)
 			m68k_emulate(FAME_INTERRUPTS_PATCH);
 		else
 #endif
+#ifdef USE_CPU_IDLE_SKIP
+			m68k_idle_emulate((nextevent - currcycle)>>timeslice_shift);
+#elif defined(USE_MIPS_DYNAREC)
+			m68k_dynarec_emulate((nextevent - currcycle)>>timeslice_shift);
+#else
 			m68k_emulate((nextevent - currcycle)>>timeslice_shift);
+#endif
 #ifdef DEBUG_CYCLES
 		dbg("!m68k_emulate");
 #endif
-		uae4all_prof_end(0);
+		uae4all_prof_end(UAE4ALL_PROF_M68K);
 #endif
 #ifdef FAME_INTERRUPTS_PATCH
 		if (uae4all_go_interrupt)
@@ -310,7 +329,7 @@ static void m68k_run (void)
 		if (M68KCONTEXT.execinfo & 0x0080)
 			mispcflags|=SPCFLAG_STOP;
 #endif
-                uae4all_prof_start(1);
+                uae4all_prof_start(UAE4ALL_PROF_EVENTS);
 
 #ifdef DEBUG_M68K
 		cycles=3413;
@@ -367,7 +386,7 @@ static void m68k_run (void)
 #endif
 		cycles_actual=M68KCONTEXT.cycles_counter;
 #endif
-                uae4all_prof_end(1);
+                uae4all_prof_end(UAE4ALL_PROF_EVENTS);
 
 #ifdef __LIBRETRO__
 		if (libretro_frame_end)
@@ -447,8 +466,21 @@ void m68k_go (int may_quit)
 void init_m68k (void)
 {
 	m68k_init();
+#ifdef FAME_PREDECODE
+	m68k_predecode_range(kickmem_start, 0xFFFFFF);
+#endif
 }
 
+#ifdef FAME_PREDECODE
+void m68k_predecode_show(void)
+{
+	unsigned hits, misses;
+
+	m68k_predecode_stats(&hits, &misses);
+	printf("PREDECODE: %u hits, %u misses in the Kickstart\n", hits, misses);
+}
+#endif
+
 static void m68k_exception(unsigned n)
 {
 	unsigned pc=m68k_get_pc();
@@ -711,6 +743,16 @@ void map_zone(unsigned addr, addrbank* banco, unsigned realstart)
 		midato_write_16[addr].high_addr=high_addr;
 		midato_write_16[addr].mem_handler=NULL;
 		midato_write_16[addr].data=(void *)(offset-low_addr);
+#ifdef FAME_PREDECODE
+		/* the predecoded Kickstart may only change in kickmem_*put() */
+		if (banco==&kickmem_bank)
+		{
+			midato_write_8[addr].mem_handler=(void*)banco->bput;
+			midato_write_8[addr].data=NULL;
+			midato_write_16[addr].mem_handler=(void*)banco->wput;
+			midato_write_16[addr].data=NULL;
+		}
+#endif
 	}
 	else
 	{
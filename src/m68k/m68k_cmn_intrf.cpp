@@ -261,7 +261,7 @@ static void m68k_run (void)
 		m68k_emulate(1);
 
 #else
-		uae4all_prof_start(0);
+		uae4all_prof_start(UAE4ALL_PROF_M68K);
 		cycles = nextevent - currcycle;
 #ifdef __LIBRETRO__
 		// On libretro don't use the timeslice hack
@@ -283,7 +283,7 @@ static void m68k_run (void)
 		else
 #endif
 			m68k_emulate(cycles);
-		uae4all_prof_end(0);
+		uae4all_prof_end(UAE4ALL_PROF_M68K);
 #endif
 #if 0 // def FAME_INTERRUPTS_PATCH
 		if (uae4all_go_interrupt)
@@ -300,7 +300,7 @@ static void m68k_run (void)
 		if (M68KCONTEXT.execinfo & 0x0080)
 			mispcflags|=SPCFLAG_STOP;
 #endif
-                uae4all_prof_start(1);
+                uae4all_prof_start(UAE4ALL_PROF_EVENTS);
 
 		//cycles=((unsigned)(((double)(M68KCONTEXT.cycles_counter-cycles_actual))*cycles_factor))<<8;
 #ifdef __LIBRETRO__
@@ -340,7 +340,7 @@ static void m68k_run (void)
 #endif
 		cycles_actual=M68KCONTEXT.cycles_counter;
 #endif
-                uae4all_prof_end(1);
+                uae4all_prof_end(UAE4ALL_PROF_EVENTS);
 #ifdef __LIBRETRO__
 		if (libretro_frame_end)
 			return;
@@ -32,6 +32,16 @@ extern int uae4all_go_interrupt;
 
 extern M68K_CONTEXT M68KCONTEXT;
 
+#ifdef USE_CPU_IDLE_SKIP
+void m68k_idle_show(void);
+#endif
+#ifdef FAME_PREDECODE
+void m68k_predecode_show(void);
+#endif
+#ifdef USE_MIPS_DYNAREC
+void m68k_dynarec_show(void);
+#endif
+
 #define flush_icache(X) do {} while (0)
 
 #define _68k_dreg(num) (M68KCONTEXT.dreg[(num)])
@@ -0,0 +1,1041 @@
+/*
+ * 68000 basic block translator to MIPS32 (USE_MIPS_DYNAREC)
+ *
+ * m68k_dynarec_emulate() replaces m68k_emulate() in m68k_run(). It
+ * translates the code at the PC up to the first instruction it does not
+ * know, or a BRA, and runs the block; FAME runs the instruction the
+ * block stopped at with m68k_emulate(1), and whole slices that start
+ * with an interrupt pending, in trace mode or stopped. The registers stay
+ * in the FAME context, so both can take over from each other at any
+ * instruction.
+ *
+ * A block is called as int block(M68K_CONTEXT *ctx, int cycles, sr) and
+ * returns the cycles left: a0 holds the context, a1 the cycles and a2
+ * the SR, whose flags every instruction computes as FAME does. After
+ * every instruction its FAME cycle count comes off a1, and the block
+ * leaves when it is spent, so a slice ends on the same instruction as
+ * with FAME alone. A branch back to the start of the block loops inside
+ * it. Exits store the 68k PC and the SR into the context.
+ *
+ * Memory goes through the 64K page tables of the FAME data banks, built
+ * by m68k_dynarec_set_banks(): a page with a memory handler, an odd
+ * address or a long across two pages leave the block before the
+ * instruction, and FAME runs it. Each block keeps a copy of the 68k
+ * words it was translated from and is only entered when they are still
+ * there, which catches code rewritten by the CPU, the blitter or disk
+ * DMA alike; a block that rewrites its own code runs to its end first.
+ *
+ * On a MIPS host the blocks run natively from a static buffer, which
+ * the SF2000 executes as is. Anywhere else mips_sim.cpp runs them, and
+ * with MIPS_DYNAREC_LOCKSTEP every block run is undone and run again
+ * through FAME, and the registers, SR, PC, cycles and stored memory of
+ * both are compared (make -f Makefile.bench bench-cpu-dynarec).
+ *
+ * Interrupts, STOP and trace are left to FAME, so is anything touching
+ * bytes, the stack or the SR. m68k_stop_emulating() from a memory
+ * handler only ends the instruction FAME runs, not the slice.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+#include "m68k/fame/fame.h"
+#include "mips_emit.h"
+#include "m68k_dynarec.h"
+#ifndef __mips__
+#include "mips_sim.h"
+#endif
+
+#ifndef FAME_GLOBAL_CONTEXT
+#error USE_MIPS_DYNAREC needs the FAME_GLOBAL_CONTEXT build of famec.cpp
+#endif
+#if defined(MIPS_DYNAREC_LOCKSTEP) && defined(__mips__)
+#error MIPS_DYNAREC_LOCKSTEP checks emulated blocks, on a host that is not MIPS
+#endif
+
+extern M68K_CONTEXT m68kcontext;
+#define CTX m68kcontext
+
+#define DYN_CODE_WORDS (128 * 1024)	/* MIPS code buffer, 512 KB */
+#define DYN_CODE_BLOCK 4096		/* MIPS words a block may take */
+#define DYN_SRC_WORDS (64 * 1024)	/* copies of the 68k code of the blocks */
+#define DYN_BLOCKS 4096			/* direct mapped by PC, a power of 2 */
+#define DYN_MAX_INSNS 32
+#define DYN_MAX_EXITS 256
+#define DYN_LOCKSTEP_CYCLES 1024	/* per block run, for the store log */
+
+#define ADDR_MASK 0xFFFFFF
+#define SR_MASK 0xA71F			/* what FAME keeps of the SR */
+
+#define DREG(n) (offsetof(M68K_CONTEXT, dreg) + 4 * (n))
+#define AREG(n) (offsetof(M68K_CONTEXT, areg) + 4 * (n))
+#define HOSTADDR(p) ((uae_u32)(uintptr_t)(p))
+
+struct dyn_block {
+    uae_u32 pc;			/* odd: free */
+    const uae_u16 *host;	/* where the 68k code was read */
+    uae_u16 *src;		/* copy of it */
+    uae_u32 *code;		/* NULL: FAME runs the first instruction */
+    uae_u16 words;
+    uae_u16 insns;
+};
+
+struct dyn_exit {
+    uae_u32 *at;		/* branch to patch */
+    uae_u32 pc;			/* 68k PC to leave with */
+};
+
+struct m68k_dynarec_stats m68k_dynarec_stats;
+
+static uae_u32 dyn_code[DYN_CODE_WORDS];
+static uae_u32 *dyn_code_end;
+static uae_u16 dyn_src[DYN_SRC_WORDS];
+static unsigned dyn_src_used;
+static struct dyn_block dyn_blocks[DYN_BLOCKS];
+
+/* host address of 68k address 0 for each 64K page, 0 if FAME must go */
+static uae_u32 dyn_fetch[256], dyn_read[256], dyn_write[256];
+
+/* the block being translated */
+static uae_u32 *emit, *dyn_start;
+static uae_u32 dyn_start_pc;
+static struct dyn_exit dyn_exits[DYN_MAX_EXITS];
+static unsigned dyn_nexits;
+
+#define E(insn) (*emit++ = (insn))
+
+/* A branch out of the block to 68k pc, patched to its exit stub */
+static void emit_exit(uae_u32 branch, uae_u32 pc)
+{
+    dyn_exits[dyn_nexits].at = emit;
+    dyn_exits[dyn_nexits++].pc = pc;
+    E(branch);
+    E(MIPS_NOP);
+}
+
+static void emit_li(int r, uae_u32 v)
+{
+    if (v < 0x10000)
+	E(MIPS_ORI(r, MIPS_ZERO, v));
+    else {
+	E(MIPS_LUI(r, v >> 16));
+	if (v & 0xFFFF)
+	    E(MIPS_ORI(r, r, v & 0xFFFF));
+    }
+}
+
+/* The instruction took c cycles: leave at next_pc once they run out */
+static void emit_cycles(int c, uae_u32 next_pc)
+{
+    E(MIPS_ADDIU(MIPS_A1, MIPS_A1, -c));
+    emit_exit(MIPS_BLEZ(MIPS_A1, 0), next_pc);
+}
+
+/* A taken branch: loops back into the block while there are cycles */
+static void emit_jump(uae_u32 target)
+{
+    if (target == dyn_start_pc) {
+	uae_u32 *at = emit;
+	E(MIPS_BGTZ(MIPS_A1, 0));
+	E(MIPS_NOP);
+	mips_patch_branch(at, dyn_start);
+    }
+    emit_exit(MIPS_B(0), target);
+}
+
+/* Flags, from a result shifted up to bit 31 */
+static void emit_nz(int r)
+{
+    E(MIPS_SRL(MIPS_T9, r, 31));
+    E(MIPS_SLL(MIPS_T9, MIPS_T9, 3));
+    E(MIPS_OR(MIPS_A2, MIPS_A2, MIPS_T9));
+    E(MIPS_SLTIU(MIPS_T9, r, 1));
+    E(MIPS_SLL(MIPS_T9, MIPS_T9, 2));
+    E(MIPS_OR(MIPS_A2, MIPS_A2, MIPS_T9));
+}
+
+static void emit_flags_logic(int r)
+{
+    E(MIPS_ANDI(MIPS_A2, MIPS_A2, 0xFFF0));
+    emit_nz(r);
+}
+
+/* c holds the carry in bit 0; x: X follows it */
+static void emit_flags_shift(int r, int c, int x)
+{
+    E(MIPS_ANDI(MIPS_A2, MIPS_A2, x ? 0xFFE0 : 0xFFF0));
+    E(MIPS_OR(MIPS_A2, MIPS_A2, c));
+    if (x) {
+	E(MIPS_SLL(MIPS_T9, c, 4));
+	E(MIPS_OR(MIPS_A2, MIPS_A2, MIPS_T9));
+    }
+    emit_nz(r);
+}
+
+/* r = d + s or r = d - s, all three shifted up to bit 31 */
+static void emit_flags_arith(int sub, int d, int s, int r, int x)
+{
+    E(MIPS_ANDI(MIPS_A2, MIPS_A2, x ? 0xFFE0 : 0xFFF0));
+    if (sub)
+	E(MIPS_SLTU(MIPS_T9, d, s));
+    else
+	E(MIPS_SLTU(MIPS_T9, r, s));
+    E(MIPS_OR(MIPS_A2, MIPS_A2, MIPS_T9));
+    if (x) {
+	E(MIPS_SLL(MIPS_T9, MIPS_T9, 4));
+	E(MIPS_OR(MIPS_A2, MIPS_A2, MIPS_T9));
+    }
+    if (sub) {
+	E(MIPS_XOR(MIPS_T8, s, d));
+	E(MIPS_XOR(MIPS_T9, r, d));
+    } else {
+	E(MIPS_XOR(MIPS_T8, s, r));
+	E(MIPS_XOR(MIPS_T9, d, r));
+    }
+    E(MIPS_AND(MIPS_T8, MIPS_T8, MIPS_T9));
+    E(MIPS_SRL(MIPS_T8, MIPS_T8, 31));
+    E(MIPS_SLL(MIPS_T8, MIPS_T8, 1));
+    E(MIPS_OR(MIPS_A2, MIPS_A2, MIPS_T8));
+    emit_nz(r);
+}
+
+/* Dn shifted up to bit 31 */
+static void emit_dreg_up(int r, int n, int size)
+{
+    E(MIPS_LW(r, DREG(n), MIPS_A0));
+    if (size == 2)
+	E(MIPS_SLL(r, r, 16));
+}
+
+/* Dn = r, a result shifted up to bit 31 */
+static void emit_dreg_down(int n, int r, int size)
+{
+    if (size == 2) {
+	E(MIPS_SRL(r, r, 16));
+	E(MIPS_SH(r, DREG(n), MIPS_A0));
+    } else
+	E(MIPS_SW(r, DREG(n), MIPS_A0));
+}
+
+/* effective addresses: extension words and FAME cycles */
+static int ea_ok(int mode, int reg, int src)
+{
+    if (mode == 6)
+	return 0;
+    if (mode == 7)
+	return reg == 0 || reg == 1 || (src && reg == 4);
+    return 1;
+}
+
+static int ea_words(int mode, int reg, int size)
+{
+    if (mode == 5)
+	return 1;
+    if (mode == 7)
+	return reg == 1 || (reg == 4 && size == 4) ? 2 : 1;
+    return 0;
+}
+
+static int ea_cycles(int mode, int reg, int size, int src)
+{
+    int l = size == 4 ? 4 : 0;
+
+    switch (mode) {
+    case 2: case 3: return 4 + l;
+    case 4: return (src ? 6 : 4) + l;
+    case 5: return 8 + l;
+    case 7: return (reg == 0 ? 8 : reg == 1 ? 12 : 4) + l;
+    }
+    return 0;
+}
+
+/* ra = the address of a memory operand; for (An)+ and -(An), ru = the
+   new An, written back by the caller. base: a register holding An
+   instead of the context. */
+static void emit_ea_addr(int mode, int reg, int size, const uae_u16 *ext, int ra, int ru, int base)
+{
+    if (mode >= 2 && mode <= 5 && base < 0) {
+	E(MIPS_LW(ra, AREG(reg), MIPS_A0));
+	base = ra;
+    }
+    switch (mode) {
+    case 2:
+	if (base != ra)
+	    E(MIPS_MOVE(ra, base));
+	break;
+    case 3:
+	if (base != ra)
+	    E(MIPS_MOVE(ra, base));
+	E(MIPS_ADDIU(ru, ra, size));
+	break;
+    case 4:
+	E(MIPS_ADDIU(ra, base, -size));
+	E(MIPS_MOVE(ru, ra));
+	break;
+    case 5:
+	E(MIPS_ADDIU(ra, base, (uae_s16)ext[0]));
+	break;
+    case 7:
+	if (reg == 0)
+	    emit_li(ra, (uae_s32)(uae_s16)ext[0]);
+	else
+	    emit_li(ra, (ext[0] << 16) | ext[1]);
+	break;
+    }
+}
+
+/* host = where the 68k address ra is, or leave before the instruction
+   at pc for FAME to run it */
+static void emit_host(int ra, int host, int size, const uae_u32 *table, uae_u32 pc)
+{
+    E(MIPS_ANDI(MIPS_T9, ra, 1));
+    emit_exit(MIPS_BNE(MIPS_T9, MIPS_ZERO, 0), pc);
+    E(MIPS_SLL(host, ra, 8));
+    E(MIPS_SRL(host, host, 8));
+    if (size == 4) {
+	E(MIPS_ANDI(MIPS_T9, host, 0xFFFF));
+	E(MIPS_XORI(MIPS_T9, MIPS_T9, 0xFFFE));
+	emit_exit(MIPS_BEQ(MIPS_T9, MIPS_ZERO, 0), pc);
+    }
+    E(MIPS_SRL(MIPS_T9, host, 16));
+    E(MIPS_SLL(MIPS_T9, MIPS_T9, 2));
+    E(MIPS_LUI(MIPS_T8, MIPS_HI(HOSTADDR(table))));
+    E(MIPS_ADDU(MIPS_T9, MIPS_T9, MIPS_T8));
+    E(MIPS_LW(MIPS_T9, MIPS_LO(HOSTADDR(table)), MIPS_T9));
+    emit_exit(MIPS_BEQ(MIPS_T9, MIPS_ZERO, 0), pc);
+    E(MIPS_ADDU(host, host, MIPS_T9));
+}
+
+/* 68k words are host words; a long is its high word first */
+static void emit_load(int r, int host, int size)
+{
+    if (size == 4) {
+	E(MIPS_LHU(MIPS_T9, 0, host));
+	E(MIPS_LHU(r, 2, host));
+	E(MIPS_SLL(MIPS_T9, MIPS_T9, 16));
+	E(MIPS_OR(r, r, MIPS_T9));
+    } else
+	E(MIPS_LHU(r, 0, host));
+}
+
+static void emit_store(int r, int host, int size)
+{
+    if (size == 4) {
+	E(MIPS_SRL(MIPS_T9, r, 16));
+	E(MIPS_SH(MIPS_T9, 0, host));
+	E(MIPS_SH(r, 2, host));
+    } else
+	E(MIPS_SH(r, 0, host));
+}
+
+/* MOVE and MOVEA, .W and .L */
+static int dyn_move(uae_u32 pc, const uae_u16 *p, int size)
+{
+    int op = p[0];
+    int sm = (op >> 3) & 7, sr = op & 7, dm = (op >> 6) & 7, dr = (op >> 9) & 7;
+    int sw, upd_s = sm == 3 || sm == 4, upd_d = dm == 3 || dm == 4;
+    int mem_s = sm >= 2 && !(sm == 7 && sr == 4), mem_d = dm >= 2;
+
+    if (!ea_ok(sm, sr, 1) || !ea_ok(dm, dr, 0))
+	return 0;
+    sw = ea_words(sm, sr, size);
+
+    if (mem_s)
+	emit_ea_addr(sm, sr, size, p + 1, MIPS_T0, MIPS_T1, -1);
+    if (mem_d)
+	emit_ea_addr(dm, dr, size, p + 1 + sw, MIPS_T2, MIPS_T3,
+		     upd_s && dm >= 2 && dm <= 5 && dr == sr ? MIPS_T1 : -1);
+    if (mem_s)
+	emit_host(MIPS_T0, MIPS_T4, size, dyn_read, pc);
+    if (mem_d)
+	emit_host(MIPS_T2, MIPS_T5, size, dyn_write, pc);
+
+    switch (sm) {
+    case 0:
+	E(size == 4 ? MIPS_LW(MIPS_T6, DREG(sr), MIPS_A0) : MIPS_LHU(MIPS_T6, DREG(sr), MIPS_A0));
+	break;
+    case 1:
+	E(size == 4 ? MIPS_LW(MIPS_T6, AREG(sr), MIPS_A0) : MIPS_LHU(MIPS_T6, AREG(sr), MIPS_A0));
+	break;
+    default:
+	if (mem_s)
+	    emit_load(MIPS_T6, MIPS_T4, size);
+	else
+	    emit_li(MIPS_T6, size == 4 ? (p[1] << 16) | p[2] : p[1]);
+	break;
+    }
+    if (upd_s)
+	E(MIPS_SW(MIPS_T1, AREG(sr), MIPS_A0));
+
+    if (dm == 1) {
+	if (size == 2) {
+	    E(MIPS_SLL(MIPS_T6, MIPS_T6, 16));
+	    E(MIPS_SRA(MIPS_T6, MIPS_T6, 16));
+	}
+	E(MIPS_SW(MIPS_T6, AREG(dr), MIPS_A0));
+    } else {
+	if (size == 2) {
+	    E(MIPS_SLL(MIPS_T7, MIPS_T6, 16));
+	    emit_flags_logic(MIPS_T7);
+	} else
+	    emit_flags_logic(MIPS_T6);
+	if (dm == 0)
+	    E(size == 4 ? MIPS_SW(MIPS_T6, DREG(dr), MIPS_A0) : MIPS_SH(MIPS_T6, DREG(dr), MIPS_A0));
+	else
+	    emit_store(MIPS_T6, MIPS_T5, size);
+	if (upd_d)
+	    E(MIPS_SW(MIPS_T3, AREG(dr), MIPS_A0));
+    }
+    emit_cycles(4 + ea_cycles(sm, sr, size, 1) + ea_cycles(dm, dr, size, 0), pc + 2 * (1 + sw + ea_words(dm, dr, size)));
+    return 1 + sw + ea_words(dm, dr, size);
+}
+
+enum { ALU_ADD, ALU_SUB, ALU_CMP, ALU_AND, ALU_OR, ALU_EOR };
+
+/* Dn op= the source in T1, shifted up to bit 31 */
+static void emit_alu(int alu, int n, int size)
+{
+    emit_dreg_up(MIPS_T0, n, size);
+    switch (alu) {
+    case ALU_ADD:
+	E(MIPS_ADDU(MIPS_T2, MIPS_T0, MIPS_T1));
+	emit_flags_arith(0, MIPS_T0, MIPS_T1, MIPS_T2, 1);
+	break;
+    case ALU_SUB:
+    case ALU_CMP:
+	E(MIPS_SUBU(MIPS_T2, MIPS_T0, MIPS_T1));
+	emit_flags_arith(1, MIPS_T0, MIPS_T1, MIPS_T2, alu == ALU_SUB);
+	break;
+    case ALU_AND:
+	E(MIPS_AND(MIPS_T2, MIPS_T0, MIPS_T1));
+	emit_flags_logic(MIPS_T2);
+	break;
+    case ALU_OR:
+	E(MIPS_OR(MIPS_T2, MIPS_T0, MIPS_T1));
+	emit_flags_logic(MIPS_T2);
+	break;
+    case ALU_EOR:
+	E(MIPS_XOR(MIPS_T2, MIPS_T0, MIPS_T1));
+	emit_flags_logic(MIPS_T2);
+	break;
+    }
+    if (alu != ALU_CMP)
+	emit_dreg_down(n, MIPS_T2, size);
+}
+
+/* ADD, SUB, CMP, AND, OR Dn,Dn and EOR Dn,Dn */
+static int dyn_alu_reg(uae_u32 pc, int op, int alu)
+{
+    int size = 1 << ((op >> 6) & 3), s = op & 7, d = (op >> 9) & 7;
+    int c = size == 2 ? 4 : alu == ALU_CMP ? 6 : 8;
+
+    if (((op >> 6) & 3) == 0 || ((op >> 6) & 3) == 3 || ((op >> 3) & 7))
+	return 0;
+    if (alu == ALU_EOR) {
+	int t = s;
+	s = d;
+	d = t;
+    }
+    emit_dreg_up(MIPS_T1, s, size);
+    emit_alu(alu, d, size);
+    emit_cycles(c, pc + 2);
+    return 1;
+}
+
+/* ORI, ANDI, SUBI, ADDI, EORI, CMPI #imm,Dn */
+static int dyn_alu_imm(uae_u32 pc, const uae_u16 *p)
+{
+    static const signed char alus[8] = { ALU_OR, ALU_AND, ALU_SUB, ALU_ADD, -1, ALU_EOR, ALU_CMP, -1 };
+    int op = p[0], alu = alus[(op >> 9) & 7], size = 1 << ((op >> 6) & 3), c;
+
+    if (alu < 0 || ((op >> 6) & 3) == 0 || ((op >> 6) & 3) == 3 || ((op >> 3) & 7))
+	return 0;
+    if (size == 2) {
+	emit_li(MIPS_T1, p[1] << 16);
+	c = 8;
+    } else {
+	emit_li(MIPS_T1, (p[1] << 16) | p[2]);
+	c = alu == ALU_AND || alu == ALU_CMP ? 14 : 16;
+    }
+    emit_alu(alu, op & 7, size);
+    emit_cycles(c, pc + size + 2);
+    return 1 + size / 2;
+}
+
+/* ADDQ and SUBQ to Dn or An */
+static int dyn_addq(uae_u32 pc, int op)
+{
+    int n = (((op >> 9) - 1) & 7) + 1, size = 1 << ((op >> 6) & 3), r = op & 7, sub = op & 0x100;
+
+    if (((op >> 3) & 7) == 1) {
+	E(MIPS_LW(MIPS_T0, AREG(r), MIPS_A0));
+	E(MIPS_ADDIU(MIPS_T0, MIPS_T0, sub ? -n : n));
+	E(MIPS_SW(MIPS_T0, AREG(r), MIPS_A0));
+	emit_cycles(size == 2 && !sub ? 4 : 8, pc + 2);
+	return 1;
+    }
+    if ((op >> 3) & 7)
+	return 0;
+    emit_li(MIPS_T1, size == 2 ? n << 16 : n);
+    emit_alu(sub ? ALU_SUB : ALU_ADD, r, size);
+    emit_cycles(size == 2 ? 4 : 8, pc + 2);
+    return 1;
+}
+
+/* ASR, LSL, LSR, ROL, ROR #n,Dn */
+static int dyn_shift(uae_u32 pc, int op)
+{
+    int n = (((op >> 9) - 1) & 7) + 1, size = 1 << ((op >> 6) & 3), r = op & 7;
+    int type = (op >> 3) & 3, left = op & 0x100, bits = size * 8, up;
+
+    if (((op >> 6) & 3) == 0 || ((op >> 6) & 3) == 3 || (op & 0x20) || type == 2 || (type == 0 && left))
+	return 0;
+    switch (type) {
+    case 0:			/* ASR */
+	E(MIPS_LW(MIPS_T0, DREG(r), MIPS_A0));
+	if (size == 2) {
+	    E(MIPS_SLL(MIPS_T0, MIPS_T0, 16));
+	    E(MIPS_SRA(MIPS_T0, MIPS_T0, 16));
+	}
+	E(MIPS_SRA(MIPS_T2, MIPS_T0, n - 1));
+	E(MIPS_ANDI(MIPS_T2, MIPS_T2, 1));
+	E(MIPS_SRA(MIPS_T1, MIPS_T0, n));
+	break;
+    case 1:
+	if (left) {		/* LSL */
+	    emit_dreg_up(MIPS_T0, r, size);
+	    E(MIPS_SRL(MIPS_T2, MIPS_T0, 32 - n));
+	    E(MIPS_ANDI(MIPS_T2, MIPS_T2, 1));
+	    E(MIPS_SLL(MIPS_T1, MIPS_T0, n));
+	    emit_flags_shift(MIPS_T1, MIPS_T2, 1);
+	    emit_dreg_down(r, MIPS_T1, size);
+	    emit_cycles((size == 2 ? 6 : 8) + 2 * n, pc + 2);
+	    return 1;
+	}
+	/* LSR */
+	E(size == 4 ? MIPS_LW(MIPS_T0, DREG(r), MIPS_A0) : MIPS_LHU(MIPS_T0, DREG(r), MIPS_A0));
+	E(MIPS_SRL(MIPS_T2, MIPS_T0, n - 1));
+	E(MIPS_ANDI(MIPS_T2, MIPS_T2, 1));
+	E(MIPS_SRL(MIPS_T1, MIPS_T0, n));
+	break;
+    case 3:			/* ROL, ROR */
+	E(size == 4 ? MIPS_LW(MIPS_T0, DREG(r), MIPS_A0) : MIPS_LHU(MIPS_T0, DREG(r), MIPS_A0));
+	E(left ? MIPS_SLL(MIPS_T1, MIPS_T0, n) : MIPS_SRL(MIPS_T1, MIPS_T0, n));
+	E(left ? MIPS_SRL(MIPS_T2, MIPS_T0, bits - n) : MIPS_SLL(MIPS_T2, MIPS_T0, bits - n));
+	E(MIPS_OR(MIPS_T1, MIPS_T1, MIPS_T2));
+	if (size == 2)
+	    E(MIPS_ANDI(MIPS_T1, MIPS_T1, 0xFFFF));
+	if (left)
+	    E(MIPS_ANDI(MIPS_T2, MIPS_T1, 1));
+	else
+	    E(MIPS_SRL(MIPS_T2, MIPS_T1, bits - 1));
+	break;
+    }
+    up = MIPS_T1;
+    if (size == 2) {
+	E(MIPS_SLL(MIPS_T3, MIPS_T1, 16));
+	up = MIPS_T3;
+    }
+    emit_flags_shift(up, MIPS_T2, type != 3);
+    E(size == 4 ? MIPS_SW(MIPS_T1, DREG(r), MIPS_A0) : MIPS_SH(MIPS_T1, DREG(r), MIPS_A0));
+    emit_cycles((size == 2 ? 6 : 8) + 2 * n, pc + 2);
+    return 1;
+}
+
+/* CLR, NOT, TST Dn */
+static int dyn_unary(uae_u32 pc, int op)
+{
+    int size = 1 << ((op >> 6) & 3), r = op & 7, kind = op & 0x0F00;
+
+    if (((op >> 6) & 3) == 0 || ((op >> 6) & 3) == 3 || ((op >> 3) & 7))
+	return 0;
+    switch (kind) {
+    case 0x0200:		/* CLR */
+	E(size == 4 ? MIPS_SW(MIPS_ZERO, DREG(r), MIPS_A0) : MIPS_SH(MIPS_ZERO, DREG(r), MIPS_A0));
+	E(MIPS_ANDI(MIPS_A2, MIPS_A2, 0xFFF0));
+	E(MIPS_ORI(MIPS_A2, MIPS_A2, 4));
+	break;
+    case 0x0600:		/* NOT */
+	emit_dreg_up(MIPS_T0, r, size);
+	E(MIPS_NOR(MIPS_T0, MIPS_T0, MIPS_ZERO));
+	if (size == 2)
+	    E(MIPS_SRL(MIPS_T0, MIPS_T0, 16));
+	E(MIPS_SLL(MIPS_T1, MIPS_T0, size == 2 ? 16 : 0));
+	emit_flags_logic(MIPS_T1);
+	E(size == 4 ? MIPS_SW(MIPS_T0, DREG(r), MIPS_A0) : MIPS_SH(MIPS_T0, DREG(r), MIPS_A0));
+	break;
+    case 0x0A00:		/* TST */
+	emit_dreg_up(MIPS_T0, r, size);
+	emit_flags_logic(MIPS_T0);
+	emit_cycles(4, pc + 2);
+	return 1;
+    default:
+	return 0;
+    }
+    emit_cycles(size == 2 ? 4 : 6, pc + 2);
+    return 1;
+}
+
+/* the condition of Bcc: t0 != 0 when it holds if nz, t0 == 0 if not */
+static void emit_cond(int cc, int *nz)
+{
+    static const unsigned char bits[16] = { 0, 0, 5, 5, 1, 1, 4, 4, 2, 2, 8, 8 };
+
+    *nz = cc & 1;
+    if (cc < 12) {
+	E(MIPS_ANDI(MIPS_T0, MIPS_A2, bits[cc]));
+	return;
+    }
+    /* GE, LT, GT, LE: N ^ V, and Z */
+    E(MIPS_SRL(MIPS_T0, MIPS_A2, 2));
+    E(MIPS_XOR(MIPS_T0, MIPS_T0, MIPS_A2));
+    E(MIPS_ANDI(MIPS_T0, MIPS_T0, 2));
+    if (cc >= 14) {
+	E(MIPS_ANDI(MIPS_T1, MIPS_A2, 4));
+	E(MIPS_OR(MIPS_T0, MIPS_T0, MIPS_T1));
+    }
+}
+
+/* BRA and Bcc, .S and .W; *ended for BRA */
+static int dyn_bcc(uae_u32 pc, const uae_u16 *p, int *ended)
+{
+    int op = p[0], cc = (op >> 8) & 15, words = 1, nz;
+    uae_s32 disp = (uae_s8)op;
+    uae_u32 target, *skip;
+
+    if (cc == 1 || (op & 0xFF) == 0xFF)
+	return 0;
+    if (!disp) {
+	disp = (uae_s16)p[1];
+	words = 2;
+    }
+    target = (pc + 2 + disp) & ADDR_MASK;
+    if (target & 1)		/* FAME raises the address error */
+	return 0;
+    if (!cc) {
+	E(MIPS_ADDIU(MIPS_A1, MIPS_A1, -10));
+	emit_jump(target);
+	*ended = 1;
+	return words;
+    }
+    emit_cond(cc, &nz);
+    skip = emit;
+    E(nz ? MIPS_BEQ(MIPS_T0, MIPS_ZERO, 0) : MIPS_BNE(MIPS_T0, MIPS_ZERO, 0));
+    E(MIPS_NOP);
+    E(MIPS_ADDIU(MIPS_A1, MIPS_A1, -10));
+    emit_jump(target);
+    mips_patch_branch(skip, emit);
+    emit_cycles(words == 1 ? 8 : 12, pc + 2 * words);
+    return words;
+}
+
+/* DBF Dn */
+static int dyn_dbf(uae_u32 pc, const uae_u16 *p)
+{
+    int r = p[0] & 7;
+    uae_u32 target = (pc + 2 + (uae_s16)p[1]) & ADDR_MASK, *skip;
+
+    if (target & 1)
+	return 0;
+    E(MIPS_LHU(MIPS_T0, DREG(r), MIPS_A0));
+    E(MIPS_ADDIU(MIPS_T0, MIPS_T0, -1));
+    E(MIPS_SH(MIPS_T0, DREG(r), MIPS_A0));
+    E(MIPS_ANDI(MIPS_T0, MIPS_T0, 0xFFFF));
+    E(MIPS_XORI(MIPS_T0, MIPS_T0, 0xFFFF));
+    skip = emit;
+    E(MIPS_BEQ(MIPS_T0, MIPS_ZERO, 0));
+    E(MIPS_NOP);
+    E(MIPS_ADDIU(MIPS_A1, MIPS_A1, -10));
+    emit_jump(target);
+    mips_patch_branch(skip, emit);
+    emit_cycles(14, pc + 4);
+    return 2;
+}
+
+/* LEA (An), d16(An), abs.W, abs.L */
+static int dyn_lea(uae_u32 pc, const uae_u16 *p)
+{
+    int op = p[0], mode = (op >> 3) & 7, reg = op & 7, c;
+
+    if (mode == 2)
+	c = 4;
+    else if (mode == 5 || (mode == 7 && reg == 0))
+	c = 8;
+    else if (mode == 7 && reg == 1)
+	c = 12;
+    else
+	return 0;
+    emit_ea_addr(mode, reg, 4, p + 1, MIPS_T0, MIPS_T1, -1);
+    E(MIPS_SW(MIPS_T0, AREG((op >> 9) & 7), MIPS_A0));
+    emit_cycles(c, pc + 2 * (1 + ea_words(mode, reg, 4)));
+    return 1 + ea_words(mode, reg, 4);
+}
+
+/* Translates the instruction at pc; returns its words, or 0 */
+static int dyn_insn(uae_u32 pc, const uae_u16 *p, int *ended)
+{
+    int op = p[0], r = op & 7;
+
+    switch (op >> 12) {
+    case 0x0:
+	if ((op & 0xFFF8) == 0x0800) {	/* BTST #n,Dn */
+	    int bit = p[1] & 31;
+	    E(MIPS_LW(MIPS_T0, DREG(r), MIPS_A0));
+	    E(MIPS_SRL(MIPS_T0, MIPS_T0, bit));
+	    E(MIPS_ANDI(MIPS_T0, MIPS_T0, 1));
+	    E(MIPS_XORI(MIPS_T0, MIPS_T0, 1));
+	    E(MIPS_SLL(MIPS_T0, MIPS_T0, 2));
+	    E(MIPS_ANDI(MIPS_A2, MIPS_A2, 0xFFFB));
+	    E(MIPS_OR(MIPS_A2, MIPS_A2, MIPS_T0));
+	    emit_cycles(10, pc + 4);
+	    return 2;
+	}
+	if (op & 0x100)
+	    return 0;
+	return dyn_alu_imm(pc, p);
+    case 0x2:
+	return dyn_move(pc, p, 4);
+    case 0x3:
+	return dyn_move(pc, p, 2);
+    case 0x4:
+	if (op == 0x4E71) {		/* NOP */
+	    emit_cycles(4, pc + 2);
+	    return 1;
+	}
+	if ((op & 0xF1C0) == 0x41C0)
+	    return dyn_lea(pc, p);
+	if ((op & 0xFFF8) == 0x4840) {	/* SWAP */
+	    E(MIPS_LW(MIPS_T0, DREG(r), MIPS_A0));
+	    E(MIPS_SLL(MIPS_T1, MIPS_T0, 16));
+	    E(MIPS_SRL(MIPS_T0, MIPS_T0, 16));
+	    E(MIPS_OR(MIPS_T1, MIPS_T1, MIPS_T0));
+	    E(MIPS_SW(MIPS_T1, DREG(r), MIPS_A0));
+	    emit_flags_logic(MIPS_T1);
+	    emit_cycles(4, pc + 2);
+	    return 1;
+	}
+	if ((op & 0xFFB8) == 0x4880) {	/* EXT.W, EXT.L */
+	    int l = op & 0x40;
+	    E(MIPS_LW(MIPS_T0, DREG(r), MIPS_A0));
+	    E(MIPS_SLL(MIPS_T1, MIPS_T0, l ? 16 : 24));
+	    E(MIPS_SRA(MIPS_T1, MIPS_T1, l ? 16 : 8));
+	    if (l)
+		E(MIPS_SW(MIPS_T1, DREG(r), MIPS_A0));
+	    else {
+		E(MIPS_SRL(MIPS_T2, MIPS_T1, 16));
+		E(MIPS_SH(MIPS_T2, DREG(r), MIPS_A0));
+	    }
+	    emit_flags_logic(MIPS_T1);
+	    emit_cycles(4, pc + 2);
+	    return 1;
+	}
+	switch (op & 0xFF00) {
+	case 0x4200: case 0x4600: case 0x4A00:
+	    return dyn_unary(pc, op);
+	}
+	return 0;
+    case 0x5:
+	if ((op & 0xFFF8) == 0x51C8)
+	    return dyn_dbf(pc, p);
+	if (((op >> 6) & 3) == 3 || !((op >> 6) & 3))
+	    return 0;
+	return dyn_addq(pc, op);
+    case 0x6:
+	return dyn_bcc(pc, p, ended);
+    case 0x7:
+	if (op & 0x100)
+	    return 0;
+	E(MIPS_ADDIU(MIPS_T0, MIPS_ZERO, (uae_s8)op));
+	E(MIPS_SW(MIPS_T0, DREG((op >> 9) & 7), MIPS_A0));
+	emit_flags_logic(MIPS_T0);
+	emit_cycles(4, pc + 2);
+	return 1;
+    case 0x8:
+	return op & 0x100 ? 0 : dyn_alu_reg(pc, op, ALU_OR);
+    case 0x9:
+	return op & 0x100 ? 0 : dyn_alu_reg(pc, op, ALU_SUB);
+    case 0xB:
+	return dyn_alu_reg(pc, op, op & 0x100 ? ALU_EOR : ALU_CMP);
+    case 0xC:
+	return op & 0x100 ? 0 : dyn_alu_reg(pc, op, ALU_AND);
+    case 0xD:
+	return op & 0x100 ? 0 : dyn_alu_reg(pc, op, ALU_ADD);
+    case 0xE:
+	return dyn_shift(pc, op);
+    }
+    return 0;
+}
+
+static void dyn_flush(void)
+{
+    int i;
+
+    for (i = 0; i < DYN_BLOCKS; i++)
+	dyn_blocks[i].pc = 1;
+    dyn_code_end = dyn_code;
+    dyn_src_used = 0;
+}
+
+static struct dyn_block *dyn_translate(struct dyn_block *b, uae_u32 pc, const uae_u16 *host)
+{
+    uae_u32 cur = pc, *epilogue, *stubs[DYN_MAX_EXITS], stub_pc[DYN_MAX_EXITS];
+    unsigned i, j, nstubs = 0;
+    int insns = 0, ended = 0;
+
+    if (!dyn_code_end || dyn_code_end + DYN_CODE_BLOCK > dyn_code + DYN_CODE_WORDS
+	|| dyn_src_used + DYN_MAX_INSNS * 5 > DYN_SRC_WORDS) {
+	if (dyn_code_end)
+	    m68k_dynarec_stats.flushes++;
+	dyn_flush();
+    }
+    emit = dyn_start = dyn_code_end;
+    dyn_start_pc = pc;
+    dyn_nexits = 0;
+
+    /* stay in the 64K page the block starts in */
+    while (insns < DYN_MAX_INSNS && !ended && ((cur + 10) & ~0xFFFF) == (pc & ~0xFFFF)) {
+	uae_u32 *mark = emit;
+	unsigned exits = dyn_nexits;
+	int words = dyn_insn(cur, host + (cur - pc) / 2, &ended);
+	if (!words) {
+	    emit = mark;
+	    dyn_nexits = exits;
+	    break;
+	}
+	cur += 2 * words;
+	insns++;
+    }
+
+    b->pc = pc;
+    b->host = host;
+    b->insns = insns;
+    b->words = insns ? (cur - pc) / 2 : 1;
+    b->src = &dyn_src[dyn_src_used];
+    memcpy(b->src, host, b->words * 2);
+    dyn_src_used += b->words;
+    if (!insns) {
+	b->code = NULL;
+	return b;
+    }
+    if (!ended)
+	emit_exit(MIPS_B(0), cur);
+
+    /* one stub per 68k PC the block leaves with: t0 = pc */
+    for (i = 0; i < dyn_nexits; i++) {
+	for (j = 0; j < nstubs && stub_pc[j] != dyn_exits[i].pc; j++)
+	    ;
+	if (j == nstubs) {
+	    stub_pc[nstubs] = dyn_exits[i].pc;
+	    E(MIPS_LUI(MIPS_T0, dyn_exits[i].pc >> 16));
+	    stubs[nstubs++] = emit;
+	    E(MIPS_B(0));
+	    E(MIPS_ORI(MIPS_T0, MIPS_T0, dyn_exits[i].pc & 0xFFFF));
+	}
+	mips_patch_branch(dyn_exits[i].at, stubs[j] - 1);
+    }
+    epilogue = emit;
+    E(MIPS_SW(MIPS_T0, offsetof(M68K_CONTEXT, pc), MIPS_A0));
+    E(MIPS_SH(MIPS_A2, offsetof(M68K_CONTEXT, sr), MIPS_A0));
+    E(MIPS_JR(MIPS_RA));
+    E(MIPS_MOVE(MIPS_V0, MIPS_A1));
+    for (j = 0; j < nstubs; j++)
+	mips_patch_branch(stubs[j], epilogue);
+
+    b->code = dyn_start;
+    dyn_code_end = emit;
+#ifdef __mips__
+    __builtin___clear_cache((char *)dyn_start, (char *)emit);
+#endif
+    m68k_dynarec_stats.blocks++;
+    m68k_dynarec_stats.insns += insns;
+    return b;
+}
+
+/* The block at pc, translated again if its 68k code changed */
+static struct dyn_block *dyn_lookup(uae_u32 pc)
+{
+    struct dyn_block *b = &dyn_blocks[(pc >> 1) & (DYN_BLOCKS - 1)];
+    const uae_u16 *host;
+
+    if ((pc & 1) || !dyn_fetch[pc >> 16])
+	return NULL;
+    host = (const uae_u16 *)(uintptr_t)(dyn_fetch[pc >> 16] + pc);
+    if (b->pc == pc && b->host == host) {
+	if (!memcmp(b->src, host, b->words * 2))
+	    return b;
+	m68k_dynarec_stats.invalidated++;
+    }
+    return dyn_translate(b, pc, host);
+}
+
+/* What m68k_emulate() would start with: a pending interrupt above the
+   mask, trace, or STOP */
+static int dyn_fame_only(void)
+{
+    unsigned irq = CTX.interrupts[0];
+
+    if (CTX.execinfo & (0x80 | 0x08) || (CTX.sr & 0x8000))
+	return 1;
+    if (irq) {
+	int level = 7;
+	while (!(irq & (1 << level)))
+	    level--;
+	if (level == 7 || level > ((CTX.sr >> 8) & 7))
+	    return 1;
+    }
+    return 0;
+}
+
+#ifdef MIPS_DYNAREC_LOCKSTEP
+static uae_u32 dyn_peek(uae_u32 addr, int size)
+{
+    void *p = (void *)(uintptr_t)addr;
+    return size == 4 ? *(uae_u32 *)p : size == 2 ? *(uae_u16 *)p : *(uae_u8 *)p;
+}
+
+/* Undoes the block run that took done cycles from the state start, runs
+   the same cycles through FAME and compares; returns FAME's cycles */
+static int dyn_lockstep(const struct dyn_block *b, const M68K_CONTEXT *start, int done)
+{
+    static uae_u32 stored[MIPS_SIM_LOG];
+    M68K_CONTEXT dyn = CTX;
+    unsigned i, n = mips_sim_stores;
+    int fame = 0, bad = 0;
+
+    for (i = 0; i < n; i++)
+	stored[i] = dyn_peek(mips_sim_log[i].addr, mips_sim_log[i].size);
+    mips_sim_undo();
+    memcpy(CTX.dreg, start->dreg, sizeof CTX.dreg);
+    memcpy(CTX.areg, start->areg, sizeof CTX.areg);
+    CTX.pc = start->pc;
+    CTX.sr = start->sr;
+    while (fame < done) {
+	unsigned before = CTX.cycles_counter;
+	m68k_emulate(1);
+	fame += CTX.cycles_counter - before;
+    }
+
+    if (memcmp(CTX.dreg, dyn.dreg, sizeof CTX.dreg) || memcmp(CTX.areg, dyn.areg, sizeof CTX.areg)
+	|| CTX.pc != dyn.pc || CTX.sr != dyn.sr || fame != done)
+	bad = 1;
+    for (i = 0; i < n; i++)
+	if (dyn_peek(mips_sim_log[i].addr, mips_sim_log[i].size) != stored[i])
+	    bad = 1;
+    m68k_dynarec_stats.checked++;
+    if (bad && ++m68k_dynarec_stats.mismatches <= 8) {
+	printf("DYNAREC: block %06x (%u insns) differs from FAME:\n", b->pc, b->insns);
+	printf("  code:");
+	for (i = 0; i < b->words && i < 16; i++)
+	    printf(" %04x", b->src[i]);
+	printf("\n  pc %06x/%06x sr %04x/%04x cycles %d/%d\n", dyn.pc, CTX.pc, dyn.sr, CTX.sr, done, fame);
+	for (i = 0; i < 8; i++)
+	    if (CTX.dreg[i] != dyn.dreg[i] || CTX.areg[i] != dyn.areg[i])
+		printf("  d%u %08x/%08x a%u %08x/%08x\n", i, dyn.dreg[i], CTX.dreg[i], i, dyn.areg[i], CTX.areg[i]);
+    }
+    return fame;
+}
+#endif
+
+/* Runs block b for at most left cycles; returns the cycles it took, 0
+   when it left before its first instruction */
+static int dyn_run(const struct dyn_block *b, int left)
+{
+    uae_u32 sr = CTX.sr & SR_MASK;
+    int done;
+#ifdef MIPS_DYNAREC_LOCKSTEP
+    M68K_CONTEXT start = CTX;
+
+    if (left > DYN_LOCKSTEP_CYCLES)
+	left = DYN_LOCKSTEP_CYCLES;
+    mips_sim_logging = 1;
+#endif
+
+#ifdef __mips__
+    done = left - ((int (*)(M68K_CONTEXT *, int, unsigned))b->code)(&CTX, left, sr);
+#else
+    done = left - (int)mips_sim_call(HOSTADDR(b->code), HOSTADDR(&CTX), left, sr);
+#endif
+    if (!done)
+	return 0;
+#ifdef MIPS_DYNAREC_LOCKSTEP
+    done = dyn_lockstep(b, &start, done);
+#else
+    CTX.cycles_counter += done;
+#endif
+    m68k_dynarec_stats.cycles += done;
+    return done;
+}
+
+void m68k_dynarec_emulate(int cycles)
+{
+    int left = cycles;
+
+    do {
+	unsigned before = CTX.cycles_counter;
+	struct dyn_block *b;
+	int done = 0;
+
+	if (dyn_fame_only()) {
+	    m68k_emulate(left);
+	    m68k_dynarec_stats.fame_cycles += CTX.cycles_counter - before;
+	    return;
+	}
+	b = dyn_lookup(CTX.pc & ADDR_MASK);
+	if (b && b->code)
+	    done = dyn_run(b, left);
+	if (!done) {
+	    m68k_emulate(1);
+	    done = CTX.cycles_counter - before;
+	    m68k_dynarec_stats.fame_cycles += done;
+	}
+	left -= done;
+    } while (left > 0);
+}
+
+void m68k_dynarec_reset(void)
+{
+    dyn_flush();
+    memset(&m68k_dynarec_stats, 0, sizeof m68k_dynarec_stats);
+}
+
+static void dyn_pages(uae_u32 *pages, const M68K_DATA *d)
+{
+    unsigned i;
+
+    for (; d->low_addr != (unsigned)-1; d++)
+	for (i = (d->low_addr >> 16) & 0xFF; i <= ((d->high_addr >> 16) & 0xFF); i++)
+	    pages[i] = d->mem_handler ? 0 : HOSTADDR(d->data);
+}
+
+void m68k_dynarec_set_banks(void)
+{
+    const M68K_PROGRAM *f;
+    unsigned i;
+
+    memset(dyn_fetch, 0, sizeof dyn_fetch);
+    memset(dyn_read, 0, sizeof dyn_read);
+    memset(dyn_write, 0, sizeof dyn_write);
+    for (f = CTX.fetch; f->low_addr != (unsigned)-1; f++)
+	for (i = (f->low_addr >> 16) & 0xFF; i <= ((f->high_addr >> 16) & 0xFF); i++)
+	    dyn_fetch[i] = f->offset;
+    dyn_pages(dyn_read, CTX.read_word);
+    dyn_pages(dyn_write, CTX.write_word);
+}
+
+void m68k_dynarec_show(void)
+{
+    struct m68k_dynarec_stats *s = &m68k_dynarec_stats;
+    double all = s->cycles + s->fame_cycles;
+
+    printf("DYNAREC: %u blocks, %.1f insns per block, %u invalidated, %u flushes\n",
+	   s->blocks, s->blocks ? (double)s->insns / s->blocks : 0.0, s->invalidated, s->flushes);
+    printf("DYNAREC: %.1f%% of %.0f cycles in blocks\n", all ? 100 * s->cycles / all : 0.0, all);
+#ifdef MIPS_DYNAREC_LOCKSTEP
+    printf("DYNAREC: %u block runs checked against FAME, %u mismatches\n", s->checked, s->mismatches);
+#endif
+}
@@ -0,0 +1,34 @@
+/*
+ * 68000 basic block translator to MIPS32 (USE_MIPS_DYNAREC), running
+ * next to the FAME C core. See m68k_dynarec.cpp.
+ */
+
+#ifndef M68K_DYNAREC_H
+#define M68K_DYNAREC_H
+
+/* m68k_emulate(cycles), through the translated blocks where it can */
+void m68k_dynarec_emulate(int cycles);
+
+/* Forgets all blocks and counters, after a reset or a new program */
+void m68k_dynarec_reset(void);
+
+/* Rebuilds the page tables of the blocks from the FAME context; called
+   by famec_SetBanks() */
+void m68k_dynarec_set_banks(void);
+
+struct m68k_dynarec_stats {
+    unsigned blocks;		/* translated */
+    unsigned insns;		/* translated, in all blocks */
+    unsigned invalidated;	/* blocks whose 68k code had changed */
+    unsigned flushes;		/* of the full code buffer */
+    double cycles;		/* run in blocks */
+    double fame_cycles;		/* run by FAME */
+    unsigned checked;		/* block runs compared with FAME */
+    unsigned mismatches;
+};
+
+extern struct m68k_dynarec_stats m68k_dynarec_stats;
+
+void m68k_dynarec_show(void);
+
+#endif
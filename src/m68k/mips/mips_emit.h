@@ -0,0 +1,86 @@
+/*
+ * MIPS32 instruction encodings for the 68000 block translator
+ * (USE_MIPS_DYNAREC, see m68k_dynarec.cpp).
+ *
+ * Only MIPS32 release 1 instructions, so that the code does not depend
+ * on the release the SF2000 and GB300 CPU implements, and mips_sim.cpp
+ * runs all of them. Every macro gives the instruction word; branch
+ * offsets are in instructions from the delay slot, as the hardware
+ * counts them.
+ */
+
+#ifndef MIPS_EMIT_H
+#define MIPS_EMIT_H
+
+enum {
+    MIPS_ZERO = 0, MIPS_AT, MIPS_V0, MIPS_V1,
+    MIPS_A0, MIPS_A1, MIPS_A2, MIPS_A3,
+    MIPS_T0, MIPS_T1, MIPS_T2, MIPS_T3, MIPS_T4, MIPS_T5, MIPS_T6, MIPS_T7,
+    MIPS_S0, MIPS_S1, MIPS_S2, MIPS_S3, MIPS_S4, MIPS_S5, MIPS_S6, MIPS_S7,
+    MIPS_T8, MIPS_T9, MIPS_K0, MIPS_K1, MIPS_GP, MIPS_SP, MIPS_FP, MIPS_RA
+};
+
+#define MIPS_R(rs, rt, rd, sa, fn) \
+    ((uae_u32)(((rs) << 21) | ((rt) << 16) | ((rd) << 11) | ((sa) << 6) | (fn)))
+#define MIPS_I(op, rs, rt, imm) \
+    ((uae_u32)(((op) << 26) | ((rs) << 21) | ((rt) << 16) | ((imm) & 0xFFFF)))
+
+/* SPECIAL */
+#define MIPS_SLL(rd, rt, sa)	MIPS_R(0, rt, rd, sa, 0x00)
+#define MIPS_SRL(rd, rt, sa)	MIPS_R(0, rt, rd, sa, 0x02)
+#define MIPS_SRA(rd, rt, sa)	MIPS_R(0, rt, rd, sa, 0x03)
+#define MIPS_SLLV(rd, rt, rs)	MIPS_R(rs, rt, rd, 0, 0x04)
+#define MIPS_SRLV(rd, rt, rs)	MIPS_R(rs, rt, rd, 0, 0x06)
+#define MIPS_SRAV(rd, rt, rs)	MIPS_R(rs, rt, rd, 0, 0x07)
+#define MIPS_JR(rs)		MIPS_R(rs, 0, 0, 0, 0x08)
+#define MIPS_JALR(rd, rs)	MIPS_R(rs, 0, rd, 0, 0x09)
+#define MIPS_ADDU(rd, rs, rt)	MIPS_R(rs, rt, rd, 0, 0x21)
+#define MIPS_SUBU(rd, rs, rt)	MIPS_R(rs, rt, rd, 0, 0x23)
+#define MIPS_AND(rd, rs, rt)	MIPS_R(rs, rt, rd, 0, 0x24)
+#define MIPS_OR(rd, rs, rt)	MIPS_R(rs, rt, rd, 0, 0x25)
+#define MIPS_XOR(rd, rs, rt)	MIPS_R(rs, rt, rd, 0, 0x26)
+#define MIPS_NOR(rd, rs, rt)	MIPS_R(rs, rt, rd, 0, 0x27)
+#define MIPS_SLT(rd, rs, rt)	MIPS_R(rs, rt, rd, 0, 0x2A)
+#define MIPS_SLTU(rd, rs, rt)	MIPS_R(rs, rt, rd, 0, 0x2B)
+#define MIPS_NOP		MIPS_SLL(MIPS_ZERO, MIPS_ZERO, 0)
+#define MIPS_MOVE(rd, rs)	MIPS_ADDU(rd, rs, MIPS_ZERO)
+
+/* REGIMM */
+#define MIPS_BLTZ(rs, off)	MIPS_I(0x01, rs, 0x00, off)
+#define MIPS_BGEZ(rs, off)	MIPS_I(0x01, rs, 0x01, off)
+
+/* branches and immediates */
+#define MIPS_BEQ(rs, rt, off)	MIPS_I(0x04, rs, rt, off)
+#define MIPS_BNE(rs, rt, off)	MIPS_I(0x05, rs, rt, off)
+#define MIPS_BLEZ(rs, off)	MIPS_I(0x06, rs, 0, off)
+#define MIPS_BGTZ(rs, off)	MIPS_I(0x07, rs, 0, off)
+#define MIPS_B(off)		MIPS_BEQ(MIPS_ZERO, MIPS_ZERO, off)
+#define MIPS_ADDIU(rt, rs, imm)	MIPS_I(0x09, rs, rt, imm)
+#define MIPS_SLTI(rt, rs, imm)	MIPS_I(0x0A, rs, rt, imm)
+#define MIPS_SLTIU(rt, rs, imm)	MIPS_I(0x0B, rs, rt, imm)
+#define MIPS_ANDI(rt, rs, imm)	MIPS_I(0x0C, rs, rt, imm)
+#define MIPS_ORI(rt, rs, imm)	MIPS_I(0x0D, rs, rt, imm)
+#define MIPS_XORI(rt, rs, imm)	MIPS_I(0x0E, rs, rt, imm)
+#define MIPS_LUI(rt, imm)	MIPS_I(0x0F, 0, rt, imm)
+
+/* loads and stores, little endian like the host */
+#define MIPS_LB(rt, off, base)	MIPS_I(0x20, base, rt, off)
+#define MIPS_LH(rt, off, base)	MIPS_I(0x21, base, rt, off)
+#define MIPS_LW(rt, off, base)	MIPS_I(0x23, base, rt, off)
+#define MIPS_LBU(rt, off, base)	MIPS_I(0x24, base, rt, off)
+#define MIPS_LHU(rt, off, base)	MIPS_I(0x25, base, rt, off)
+#define MIPS_SB(rt, off, base)	MIPS_I(0x28, base, rt, off)
+#define MIPS_SH(rt, off, base)	MIPS_I(0x29, base, rt, off)
+#define MIPS_SW(rt, off, base)	MIPS_I(0x2B, base, rt, off)
+
+/* the high half for a lui that a signed 16 bit offset completes */
+#define MIPS_HI(v)		((((uae_u32)(v)) + 0x8000) >> 16)
+#define MIPS_LO(v)		((uae_u32)(v) & 0xFFFF)
+
+/* points the branch at *at to the instruction at to */
+static __inline__ void mips_patch_branch (uae_u32 *at, const uae_u32 *to)
+{
+    *at = (*at & 0xFFFF0000) | ((to - (at + 1)) & 0xFFFF);
+}
+
+#endif
@@ -0,0 +1,167 @@
+/*
+ * Emulated MIPS32, little endian, for the instructions mips_emit.h
+ * encodes. Branches and jumps have their delay slot; there are no
+ * exceptions: an unknown instruction, or an unaligned load or store,
+ * stops the emulator, as it is a bug of the translator.
+ *
+ * With mips_sim_logging set, every store is logged with the value it
+ * overwrote, so that the lock-step mode of m68k_dynarec.cpp can undo a
+ * block and run it again through FAME.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+#include "mips_sim.h"
+
+#define SIM_RETURN 0xFFFFFFF0	/* ra of a call: the return ends it */
+
+struct mips_sim_store mips_sim_log[MIPS_SIM_LOG];
+unsigned mips_sim_stores;
+int mips_sim_logging;
+
+#define HOST(a) ((uintptr_t)(uae_u32)(a))
+
+static void sim_fail(const char *what, uae_u32 pc, uae_u32 insn)
+{
+    fprintf(stderr, "mips_sim: %s at %08x (%08x)\n", what, pc, insn);
+    abort();
+}
+
+static void sim_log(uae_u32 addr, int size, uae_u32 pc, uae_u32 insn)
+{
+    struct mips_sim_store *s;
+
+    if (!mips_sim_logging)
+	return;
+    if (mips_sim_stores == MIPS_SIM_LOG)
+	sim_fail("store log full", pc, insn);
+    s = &mips_sim_log[mips_sim_stores++];
+    s->addr = addr;
+    s->size = size;
+    s->old = size == 4 ? *(uae_u32 *)HOST(addr) : size == 2 ? *(uae_u16 *)HOST(addr) : *(uae_u8 *)HOST(addr);
+}
+
+void mips_sim_undo(void)
+{
+    while (mips_sim_stores) {
+	struct mips_sim_store *s = &mips_sim_log[--mips_sim_stores];
+	if (s->size == 4)
+	    *(uae_u32 *)HOST(s->addr) = s->old;
+	else if (s->size == 2)
+	    *(uae_u16 *)HOST(s->addr) = s->old;
+	else
+	    *(uae_u8 *)HOST(s->addr) = s->old;
+    }
+}
+
+uae_u32 mips_sim_call(uae_u32 entry, uae_u32 a0, uae_u32 a1, uae_u32 a2)
+{
+    uae_u32 r[32] = { 0 };
+    uae_u32 pc = entry, npc = entry + 4;
+
+    r[4] = a0;
+    r[5] = a1;
+    r[6] = a2;
+    r[31] = SIM_RETURN;
+    mips_sim_stores = 0;
+
+    while (pc != SIM_RETURN) {
+	uae_u32 insn = *(uae_u32 *)HOST(pc);
+	uae_u32 rs = (insn >> 21) & 31, rt = (insn >> 16) & 31, rd = (insn >> 11) & 31;
+	uae_u32 sa = (insn >> 6) & 31;
+	uae_u32 uimm = insn & 0xFFFF;
+	uae_s32 simm = (uae_s16)insn;
+	uae_u32 target = npc + (simm << 2);
+	uae_u32 next = npc + 4, addr = r[rs] + simm;
+
+	switch (insn >> 26) {
+	case 0x00:
+	    switch (insn & 0x3F) {
+	    case 0x00: r[rd] = r[rt] << sa; break;
+	    case 0x02: r[rd] = r[rt] >> sa; break;
+	    case 0x03: r[rd] = (uae_s32)r[rt] >> sa; break;
+	    case 0x04: r[rd] = r[rt] << (r[rs] & 31); break;
+	    case 0x06: r[rd] = r[rt] >> (r[rs] & 31); break;
+	    case 0x07: r[rd] = (uae_s32)r[rt] >> (r[rs] & 31); break;
+	    case 0x08: next = r[rs]; break;
+	    case 0x09: next = r[rs]; r[rd] = npc + 4; break;
+	    case 0x21: r[rd] = r[rs] + r[rt]; break;
+	    case 0x23: r[rd] = r[rs] - r[rt]; break;
+	    case 0x24: r[rd] = r[rs] & r[rt]; break;
+	    case 0x25: r[rd] = r[rs] | r[rt]; break;
+	    case 0x26: r[rd] = r[rs] ^ r[rt]; break;
+	    case 0x27: r[rd] = ~(r[rs] | r[rt]); break;
+	    case 0x2A: r[rd] = (uae_s32)r[rs] < (uae_s32)r[rt]; break;
+	    case 0x2B: r[rd] = r[rs] < r[rt]; break;
+	    default: sim_fail("unknown instruction", pc, insn);
+	    }
+	    break;
+	case 0x01:
+	    if (rt == 0x00) {
+		if ((uae_s32)r[rs] < 0)
+		    next = target;
+	    } else if (rt == 0x01) {
+		if ((uae_s32)r[rs] >= 0)
+		    next = target;
+	    } else
+		sim_fail("unknown instruction", pc, insn);
+	    break;
+	case 0x02: next = (npc & 0xF0000000) | ((insn & 0x3FFFFFF) << 2); break;
+	case 0x03: next = (npc & 0xF0000000) | ((insn & 0x3FFFFFF) << 2); r[31] = npc + 4; break;
+	case 0x04: if (r[rs] == r[rt]) next = target; break;
+	case 0x05: if (r[rs] != r[rt]) next = target; break;
+	case 0x06: if ((uae_s32)r[rs] <= 0) next = target; break;
+	case 0x07: if ((uae_s32)r[rs] > 0) next = target; break;
+	case 0x09: r[rt] = r[rs] + simm; break;
+	case 0x0A: r[rt] = (uae_s32)r[rs] < simm; break;
+	case 0x0B: r[rt] = r[rs] < (uae_u32)simm; break;
+	case 0x0C: r[rt] = r[rs] & uimm; break;
+	case 0x0D: r[rt] = r[rs] | uimm; break;
+	case 0x0E: r[rt] = r[rs] ^ uimm; break;
+	case 0x0F: r[rt] = uimm << 16; break;
+	case 0x20: r[rt] = *(uae_s8 *)HOST(addr); break;
+	case 0x21:
+	    if (addr & 1)
+		sim_fail("unaligned lh", pc, insn);
+	    r[rt] = *(uae_s16 *)HOST(addr);
+	    break;
+	case 0x23:
+	    if (addr & 3)
+		sim_fail("unaligned lw", pc, insn);
+	    r[rt] = *(uae_u32 *)HOST(addr);
+	    break;
+	case 0x24: r[rt] = *(uae_u8 *)HOST(addr); break;
+	case 0x25:
+	    if (addr & 1)
+		sim_fail("unaligned lhu", pc, insn);
+	    r[rt] = *(uae_u16 *)HOST(addr);
+	    break;
+	case 0x28:
+	    sim_log(addr, 1, pc, insn);
+	    *(uae_u8 *)HOST(addr) = r[rt];
+	    break;
+	case 0x29:
+	    if (addr & 1)
+		sim_fail("unaligned sh", pc, insn);
+	    sim_log(addr, 2, pc, insn);
+	    *(uae_u16 *)HOST(addr) = r[rt];
+	    break;
+	case 0x2B:
+	    if (addr & 3)
+		sim_fail("unaligned sw", pc, insn);
+	    sim_log(addr, 4, pc, insn);
+	    *(uae_u32 *)HOST(addr) = r[rt];
+	    break;
+	default:
+	    sim_fail("unknown instruction", pc, insn);
+	}
+	r[0] = 0;
+	pc = npc;
+	npc = next;
+    }
+    return r[2];
+}
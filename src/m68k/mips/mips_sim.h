@@ -0,0 +1,30 @@
+/*
+ * Emulated MIPS32 for the 68000 block translator (USE_MIPS_DYNAREC on
+ * a host that is not MIPS): runs the translated blocks on Linux, so that
+ * they can be developed and checked against FAME there.
+ */
+
+#ifndef MIPS_SIM_H
+#define MIPS_SIM_H
+
+#define MIPS_SIM_LOG 4096	/* stores a call can log */
+
+struct mips_sim_store {
+    uae_u32 addr;
+    uae_u32 old;		/* value before the store */
+    int size;			/* 1, 2 or 4 bytes */
+};
+
+extern struct mips_sim_store mips_sim_log[MIPS_SIM_LOG];
+extern unsigned mips_sim_stores;
+extern int mips_sim_logging;
+
+/* Calls the code at entry like a C function of up to three word
+   arguments and returns its v0. Addresses are host addresses, which
+   the core keeps in 32 bits. */
+uae_u32 mips_sim_call(uae_u32 entry, uae_u32 a0, uae_u32 a1, uae_u32 a2);
+
+/* Puts back what the logged stores of the last call overwrote */
+void mips_sim_undo(void);
+
+#endif
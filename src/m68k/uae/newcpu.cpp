@@ -1242,9 +1242,9 @@ static void m68k_run (void)
 	if (exec_opcode)
 	{
 #endif
-		uae4all_prof_start(0);
+		uae4all_prof_start(UAE4ALL_PROF_M68K);
 		cycles = (*cpufunctbl[opcode])(opcode);
-		uae4all_prof_end(0);
+		uae4all_prof_end(UAE4ALL_PROF_M68K);
 #ifdef DEBUG_M68K
 
 /*
@@ -1261,13 +1261,13 @@ SET_VFLG(0);
 	cycles = (((double)cycles)*cycles_factor);
 #endif
 
-	uae4all_prof_start(1);
+	uae4all_prof_start(UAE4ALL_PROF_EVENTS);
         do_cycles (cycles);
 	if (uae_regs.spcflags) {
 	    if (do_specialties (cycles))
 		return;
 	}
-	uae4all_prof_end(1);
+	uae4all_prof_end(UAE4ALL_PROF_EVENTS);
     }
 }
 
@@ -182,6 +182,9 @@ void do_start_program (void)
 
 void do_leave_program (void)
 {
+#ifdef USE_RENDER_THREAD
+    render_thread_stop ();
+#endif
     graphics_leave ();
     close_joystick ();
     close_sound ();
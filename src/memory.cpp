@@ -659,6 +659,9 @@ static void a1000_handle_kickstart (int mode)
 	memcpy (kickmemory, a1000_bootrom, 8192);
 	memcpy (kickmemory + 131072, a1000_bootrom, 8192);
     }
+#ifdef FAME_PREDECODE
+    m68k_predecode_invalidate (kickmem_start, kickmem_start + kickmem_size - 1);
+#endif
 }
 
 static uae_u32 kickmem_lget (uaecptr) REGPARAM;
@@ -704,6 +707,9 @@ void REGPARAM2 kickmem_lput (uaecptr addr, uae_u32 b)
 	    addr &= kickmem_mask;
 	    m = (uae_u32 *)(kickmemory + addr);
 	    do_put_mem_long (m, swab_l(b));
+#ifdef FAME_PREDECODE
+	    m68k_predecode_invalidate (kickmem_start + addr, kickmem_start + addr + 3);
+#endif
 	    return;
 	} else
 	    a1000_handle_kickstart (0);
@@ -719,6 +725,9 @@ void REGPARAM2 kickmem_wput (uaecptr addr, uae_u32 b)
 	    addr &= kickmem_mask;
 	    m = (uae_u16 *)(kickmemory + addr);
 	    do_put_mem_word (m, swab_w(b));
+#ifdef FAME_PREDECODE
+	    m68k_predecode_invalidate (kickmem_start + addr, kickmem_start + addr + 1);
+#endif
 	    return;
 	} else
 	    a1000_handle_kickstart (0);
@@ -732,6 +741,9 @@ void REGPARAM2 kickmem_bput (uaecptr addr, uae_u32 b)
 	    addr -= kickmem_start & kickmem_mask;
 	    addr &= kickmem_mask;
 	    kickmemory[addr] = b;
+#ifdef FAME_PREDECODE
+	    m68k_predecode_invalidate (kickmem_start + addr, kickmem_start + addr);
+#endif
 	    return;
 	} else
 	    a1000_handle_kickstart (0);
@@ -1398,6 +1410,9 @@ static void reload_kickstart(void)
     }
     swab_memory(kickmemory, kickmem_size);
     kickmem_checksum=get_kickmem_checksum();
+#ifdef FAME_PREDECODE
+    m68k_predecode_invalidate (kickmem_start, kickmem_start + kickmem_size - 1);
+#endif
 }
 
 void memory_reset (void)
@@ -0,0 +1,224 @@
+/*
+ * UAE4ALL per-subsystem profiler (PROFILER_UAE4ALL)
+ *
+ * uae4all_prof_start()/uae4all_prof_end() accumulate raw ticks per zone
+ * for the current frame; uae4all_prof_frame() folds them into the
+ * totals and a history ring once per frame. Optionally every start/end
+ * is also recorded into a trace buffer that can be written out as
+ * Chrome trace JSON (chrome://tracing, Perfetto).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "debug_uae4all.h"
+
+#ifdef PROFILER_UAE4ALL
+
+#ifndef UAE4ALL_PROF_HISTORY
+#define UAE4ALL_PROF_HISTORY 1024
+#endif
+
+#ifndef UAE4ALL_PROF_TRACE_EVENTS
+#define UAE4ALL_PROF_TRACE_EVENTS 65536
+#endif
+
+unsigned uae4all_prof_initial[UAE4ALL_PROF_ZONES];
+unsigned uae4all_prof_sum[UAE4ALL_PROF_ZONES];
+unsigned uae4all_prof_executed[UAE4ALL_PROF_ZONES];
+int uae4all_prof_tracing=0;
+
+static const char *uae4all_prof_msg[UAE4ALL_PROF_ZONES] = {
+	"M68K",
+	"EVENTS",
+	"HSync",
+	"Copper",
+	"Audio",
+	"CIA",
+	"Blitter",
+	"Vsync",
+	"update_fetch",
+	"linetoscr",
+	"do_long_fetch",
+	"pfield_doline",
+	"draw_sprites",
+	"flush_block",
+	"SET_INTERRUPT",
+	"drawing",
+	"video_out",
+	"resample",
+};
+
+static unsigned long long prof_total[UAE4ALL_PROF_ZONES];
+static unsigned long long prof_total_executed[UAE4ALL_PROF_ZONES];
+
+/* Unwrapped clock, advanced at every frame and trace event */
+static unsigned long long prof_clock;
+static unsigned prof_last_ticks;
+static unsigned long long prof_clock_initial, prof_usec_initial;
+static unsigned prof_frames;
+
+struct prof_frame_entry {
+	unsigned ticks;
+	unsigned zone[UAE4ALL_PROF_ZONES];
+};
+static struct prof_frame_entry prof_history[UAE4ALL_PROF_HISTORY];
+
+struct prof_trace_entry {
+	unsigned long long ts;
+	unsigned short zone, end;
+};
+static struct prof_trace_entry *prof_trace_buf=NULL;
+static unsigned prof_trace_count=0;
+
+static unsigned long long prof_usec(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (unsigned long long)tv.tv_sec*1000000+tv.tv_usec;
+}
+
+static __inline__ unsigned long long prof_advance(unsigned t)
+{
+	prof_clock+=(unsigned)(t-prof_last_ticks);
+	prof_last_ticks=t;
+	return prof_clock;
+}
+
+/* Ticks per microsecond, measured against gettimeofday since init */
+static double prof_rate(void)
+{
+	unsigned long long dus=prof_usec()-prof_usec_initial;
+	prof_advance(uae4all_prof_ticks());
+	if (!dus || prof_clock==prof_clock_initial)
+		return 1.0;
+	return (double)(prof_clock-prof_clock_initial)/(double)dus;
+}
+
+void uae4all_prof_init(void)
+{
+	memset(uae4all_prof_sum,0,sizeof(uae4all_prof_sum));
+	memset(uae4all_prof_executed,0,sizeof(uae4all_prof_executed));
+	memset(prof_total,0,sizeof(prof_total));
+	memset(prof_total_executed,0,sizeof(prof_total_executed));
+	prof_frames=0;
+	prof_trace_count=0;
+	uae4all_prof_tracing=0;
+	prof_last_ticks=uae4all_prof_ticks();
+	prof_clock_initial=prof_clock;
+	prof_usec_initial=prof_usec();
+}
+
+void uae4all_prof_frame(void)
+{
+	static unsigned long long last_clock=0;
+	struct prof_frame_entry *e=&prof_history[prof_frames%UAE4ALL_PROF_HISTORY];
+	unsigned long long now=prof_advance(uae4all_prof_ticks());
+	unsigned i;
+
+	e->ticks=prof_frames?(unsigned)(now-last_clock):0;
+	last_clock=now;
+	for(i=0;i<UAE4ALL_PROF_ZONES;i++)
+	{
+		e->zone[i]=uae4all_prof_sum[i];
+		prof_total[i]+=uae4all_prof_sum[i];
+		prof_total_executed[i]+=uae4all_prof_executed[i];
+		uae4all_prof_sum[i]=0;
+		uae4all_prof_executed[i]=0;
+	}
+	prof_frames++;
+}
+
+void uae4all_prof_trace_start(void)
+{
+	if (!prof_trace_buf)
+		prof_trace_buf=(struct prof_trace_entry *)malloc(UAE4ALL_PROF_TRACE_EVENTS*sizeof(struct prof_trace_entry));
+	prof_trace_count=0;
+	uae4all_prof_tracing=(prof_trace_buf!=NULL);
+}
+
+void uae4all_prof_trace(unsigned zone, int end, unsigned t)
+{
+	struct prof_trace_entry *e;
+	if (prof_trace_count>=UAE4ALL_PROF_TRACE_EVENTS)
+	{
+		uae4all_prof_tracing=0;
+		return;
+	}
+	e=&prof_trace_buf[prof_trace_count++];
+	e->ts=prof_advance(t);
+	e->zone=zone;
+	e->end=end;
+}
+
+void uae4all_prof_show(void)
+{
+	unsigned i;
+	double rate=prof_rate();
+	double total_us=(double)(prof_clock-prof_clock_initial)/rate;
+
+	puts("--------------------------------------------");
+	printf("PROFILER: %u frames, %.3f ms/frame\n",prof_frames,prof_frames?total_us/prof_frames/1000.0:0.0);
+	for(i=0;i<UAE4ALL_PROF_ZONES;i++)
+	{
+		double us=(double)prof_total[i]/rate;
+		if (!prof_total_executed[i])
+			continue;
+		printf("%-14s %6.2f%%  %9.3f ms/frame  %8llu calls  %8.3f us/call\n",
+			uae4all_prof_msg[i],
+			total_us>0?us*100.0/total_us:0.0,
+			prof_frames?us/prof_frames/1000.0:0.0,
+			prof_total_executed[i],
+			us/prof_total_executed[i]);
+	}
+	puts("--------------------------------------------"); fflush(stdout);
+}
+
+/* Last UAE4ALL_PROF_HISTORY frames, times in microseconds */
+void uae4all_prof_dump_csv(const char *filename)
+{
+	FILE *f=fopen(filename,"w");
+	double rate=prof_rate();
+	unsigned i,n,first;
+
+	if (!f)
+		return;
+	fprintf(f,"frame,frame_us");
+	for(i=0;i<UAE4ALL_PROF_ZONES;i++)
+		fprintf(f,",%s",uae4all_prof_msg[i]);
+	fputc('\n',f);
+	first=prof_frames>UAE4ALL_PROF_HISTORY?prof_frames-UAE4ALL_PROF_HISTORY:0;
+	for(n=first;n<prof_frames;n++)
+	{
+		struct prof_frame_entry *e=&prof_history[n%UAE4ALL_PROF_HISTORY];
+		fprintf(f,"%u,%.2f",n,e->ticks/rate);
+		for(i=0;i<UAE4ALL_PROF_ZONES;i++)
+			fprintf(f,",%.2f",e->zone[i]/rate);
+		fputc('\n',f);
+	}
+	fclose(f);
+}
+
+void uae4all_prof_dump_trace(const char *filename)
+{
+	FILE *f=fopen(filename,"w");
+	double rate=prof_rate();
+	unsigned i;
+
+	if (!f)
+		return;
+	fprintf(f,"{\"traceEvents\":[\n");
+	for(i=0;i<prof_trace_count;i++)
+	{
+		struct prof_trace_entry *e=&prof_trace_buf[i];
+		fprintf(f,"%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1}\n",
+			i?",":"",uae4all_prof_msg[e->zone],e->end?'E':'B',
+			(double)(e->ts-prof_clock_initial)/rate);
+	}
+	fprintf(f,"],\"displayTimeUnit\":\"ns\"}\n");
+	fclose(f);
+}
+
+#endif
@@ -115,7 +115,7 @@ void flush_block (int ystart, int ystop)
 void flush_screen (void)
 #endif
 {
-    uae4all_prof_start(13);
+    uae4all_prof_start(UAE4ALL_PROF_FLUSH_BLOCK);
 #ifdef DEBUG_GFX
     dbgf("Function: flush_block %d %d\n", ystart, ystop);
 #endif
@@ -171,7 +171,7 @@ void flush_screen (void)
 		vkbd_mouse();
 	if (vkbd_mode)
 		vkbd_key=vkbd_process();
-    uae4all_prof_end(13);
+    uae4all_prof_end(UAE4ALL_PROF_FLUSH_BLOCK);
 }
 
 
@@ -97,3 +97,108 @@ unsigned savedisk_get_changes(void *mem, unsigned size, void *patch, void *orig)
 	}
 	return ret;
 }
+
+#ifdef USE_SAVEDISK_DIRTY
+/* Marks the slots an .ads patch replaced, so they stay in later patches */
+void savedisk_mark_patch(unsigned *dirty, void *patch, unsigned patch_size)
+{
+	unsigned *src=(unsigned *)patch;
+	unsigned pos=0;
+	patch_size/=sizeof(unsigned);
+	while(pos<patch_size)
+	{
+		savedisk_mark_dirty(dirty,src[pos]*SAVEDISK_SLOT,SAVEDISK_SLOT);
+		pos+=1+(SAVEDISK_SLOT/sizeof(unsigned));
+	}
+}
+
+/* Same patch as savedisk_get_changes(), but only slots marked in dirty
+   can differ from orig, so only those are compared */
+unsigned savedisk_get_changes_dirty(void *mem, unsigned size, void *patch, void *orig, unsigned *dirty)
+{
+	unsigned ret=0;
+	unsigned w, words;
+	unsigned char *src=(unsigned char *)mem;
+	unsigned char *orig_p=(unsigned char *)orig;
+	unsigned *dest=(unsigned *)patch;
+	if (!orig)
+		return 0;
+	if (size%SAVEDISK_SLOT)
+		size++;
+	size/=SAVEDISK_SLOT;
+	words=(size+31)/32;
+	for(w=0;w<words;w++)
+	{
+		unsigned bits=dirty[w];
+		while(bits)
+		{
+			unsigned b=__builtin_ctz(bits);
+			unsigned pos=w*32+b;
+			unsigned o=pos*SAVEDISK_SLOT;
+			bits&=bits-1;
+			if (pos>=size)
+				break;
+			if (memcmp((void *)&src[o],(void *)&orig_p[o],SAVEDISK_SLOT))
+			{
+				unsigned i=(ret/sizeof(unsigned));
+				dest[i++]=pos;
+				memcpy((void *)&dest[i],(void *)&src[o],SAVEDISK_SLOT);
+				ret+=sizeof(unsigned)+SAVEDISK_SLOT;
+			}
+		}
+	}
+	return ret;
+}
+#endif
+
+#if defined(USE_SAVEDISK_ASYNC) && !defined(NO_ZLIB)
+/* Takes a copy of the patch; returns 0 when out of memory */
+int savedisk_pack_start(savedisk_packer *p, void *patch, unsigned size, unsigned out_max)
+{
+	memset(p,0,sizeof(*p));
+	p->patch=(unsigned char *)malloc(size);
+	p->out=(unsigned char *)malloc(out_max);
+	if ((!p->patch)||(!p->out)||(deflateInit(&p->z,Z_BEST_COMPRESSION)!=Z_OK))
+	{
+		free(p->patch);
+		free(p->out);
+		p->patch=p->out=NULL;
+		return 0;
+	}
+	memcpy(p->patch,patch,size);
+	p->size=size;
+	p->out_max=out_max;
+	p->z.next_in=p->patch;
+	p->z.next_out=p->out;
+	p->z.avail_out=out_max;
+	return 1;
+}
+
+/* Feeds at most slice more input bytes: 1 when out/out_size are complete,
+   0 when there is more to do, -1 if the output did not fit */
+int savedisk_pack_step(savedisk_packer *p, unsigned slice)
+{
+	unsigned left=p->size-(unsigned)(p->z.next_in-p->patch);
+	int ret;
+	if (slice>left)
+		slice=left;
+	p->z.avail_in=slice;
+	ret=deflate(&p->z,slice==left?Z_FINISH:Z_NO_FLUSH);
+	if (ret==Z_STREAM_END)
+	{
+		p->out_size=p->z.total_out;
+		return 1;
+	}
+	if ((ret!=Z_OK&&ret!=Z_BUF_ERROR)||(!p->z.avail_out))
+		return -1;
+	return 0;
+}
+
+void savedisk_pack_free(savedisk_packer *p)
+{
+	deflateEnd(&p->z);
+	free(p->patch);
+	free(p->out);
+	p->patch=p->out=NULL;
+}
+#endif
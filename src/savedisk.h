@@ -7,3 +7,39 @@ unsigned savedisk_get_checksum(void *mem, unsigned size);
 void savedisk_apply_changes(void *mem, void *patch, unsigned patch_size);
 unsigned savedisk_get_changes_file(void *mem, unsigned size, void *patch, char *filename);
 unsigned savedisk_get_changes(void *mem, unsigned size, void *patch, void *orig);
+
+#ifdef USE_SAVEDISK_DIRTY
+/* One bit per SAVEDISK_SLOT of a disk image, set by writes */
+#define SAVEDISK_DIRTY_WORDS(size) (((size)+SAVEDISK_SLOT*32-1)/(SAVEDISK_SLOT*32))
+
+static __inline__ void savedisk_mark_dirty(unsigned *dirty, unsigned offset, unsigned len)
+{
+	unsigned s, e;
+	if (!len)
+		return;
+	e=(offset+len-1)/SAVEDISK_SLOT;
+	for(s=offset/SAVEDISK_SLOT;s<=e;s++)
+		dirty[s>>5]|=1U<<(s&31);
+}
+
+void savedisk_mark_patch(unsigned *dirty, void *patch, unsigned patch_size);
+unsigned savedisk_get_changes_dirty(void *mem, unsigned size, void *patch, void *orig, unsigned *dirty);
+#endif
+
+#if defined(USE_SAVEDISK_ASYNC) && !defined(NO_ZLIB)
+#include <zlib.h>
+
+/* Compresses a patch snapshot in bounded steps, same stream as compress2() */
+typedef struct {
+	z_stream z;
+	unsigned char *patch;		/* owned copy */
+	unsigned size;
+	unsigned char *out;		/* compressed, out_size bytes when done */
+	unsigned long out_size;
+	unsigned out_max;
+} savedisk_packer;
+
+int savedisk_pack_start(savedisk_packer *p, void *patch, unsigned size, unsigned out_max);
+int savedisk_pack_step(savedisk_packer *p, unsigned slice);
+void savedisk_pack_free(savedisk_packer *p);
+#endif
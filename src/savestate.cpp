@@ -1203,6 +1203,7 @@ bool restore_state_from_buffer(const void *buffer, size_t size)
      * This is the CRITICAL fix - prevents do_cycles from calling CIA_handler
      * before we have a chance to properly reinitialize */
     eventtab[ev_cia].active = 0;
+    event_changed (ev_cia);
     write_log("v115: Step 2 - eventtab[ev_cia].active = 0 (disabled)\n");
 
     /* STEP 3: Sync ALL event oldcycles to current cycles (v113 fix, kept) */
@@ -1280,6 +1281,7 @@ bool restore_state_from_buffer(const void *buffer, size_t size)
 
     /* STEP 1: Disable audio event to prevent immediate trigger */
     eventtab[ev_audio].active = 0;
+    event_changed (ev_audio);
     write_log("v116: Step 1 - eventtab[ev_audio].active = 0 (disabled)\n");
 
     /* STEP 2: Reset last_cycles to current cycles
@@ -144,7 +144,7 @@ void flush_block (int ystart, int ystop)
 void flush_screen (void)
 #endif
 {
-    uae4all_prof_start(13);
+    uae4all_prof_start(UAE4ALL_PROF_FLUSH_BLOCK);
 #ifdef DEBUG_GFX
     dbgf("Function: flush_block %d %d\n", ystart, ystop);
 #endif
@@ -189,7 +189,7 @@ void flush_screen (void)
     if (SDL_MUSTLOCK(prSDLScreen))
     	SDL_LockSurface (prSDLScreen);
 #endif
-    uae4all_prof_end(13);
+    uae4all_prof_end(UAE4ALL_PROF_FLUSH_BLOCK);
 }
 
 void black_screen_now(void)
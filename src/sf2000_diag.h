@@ -45,6 +45,7 @@ static inline void diag_add(const char *msg) {
 
 #define DIAG(msg)
 #define DIAG_FATAL(msg)
+#define xlog(...)
 
 #endif /* SF2000 */
 
@@ -20,6 +20,7 @@
 #include "gensound.h"
 #include "sound.h"
 #include "custom.h"
+#include "debug_uae4all.h"
 
 extern unsigned long next_sample_evtime;
 
@@ -119,9 +120,54 @@ void sound_default_evtime(void)
     schedule_audio();
 }
 
+#ifdef USE_AUDIO_RESAMPLER
+#include "audio_resample.h"
+
+static struct audio_resample resampler;
+static uae_u16 resample_out[SNDBUFFER_LEN*2*DEFAULT_SOUND_CHANNELS];
+/* Frames sent since the last flush_audio, and the fraction of a frame
+   the per-frame target carries over (22050 Hz at 60 Hz is 367.5) */
+static int resample_sent, resample_frac;
+
+static void resample_send(uae_u16 *buf, int n, int target)
+{
+    uae4all_prof_start(UAE4ALL_PROF_RESAMPLE);
+    if (target < n / 2)
+        target = n / 2;
+    if (target > n * 2)
+        target = n * 2;
+    if (target > SNDBUFFER_LEN*2)
+        target = SNDBUFFER_LEN*2;
+    target = audio_resample_block(&resampler, buf, n, resample_out, target);
+    uae4all_prof_end(UAE4ALL_PROF_RESAMPLE);
+    if (target > 0)
+        retro_audiocb((short int *)resample_out, target);
+    resample_sent += target;
+}
+
+/* What one emulated frame should produce at sound_rate */
+static int resample_frame_target(void)
+{
+    int hz = (beamcon0 & 0x20) ? VBLANK_HZ_PAL : VBLANK_HZ_NTSC;
+    int target = sound_rate / hz;
+
+    resample_frac += sound_rate % hz;
+    if (resample_frac >= hz) {
+        resample_frac -= hz;
+        target++;
+    }
+    return target;
+}
+#endif
+
 void finish_sound_buffer (void)
 {
+#ifdef USE_AUDIO_RESAMPLER
+    /* Mid-frame overflow: filter at 1:1, flush_audio evens the frame out */
+    resample_send(sndbuffer[0], SNDBUFFER_LEN / 2, SNDBUFFER_LEN / 2);
+#else
     retro_audiocb((short int *)sndbuffer[0], SNDBUFFER_LEN / 2 );
+#endif
     sndbufpt = render_sndbuff = sndbuffer[0];
 }
 
@@ -144,6 +190,10 @@ int init_sound (void)
     scaled_sample_evtime_ok = 1;
     sound_available = 1;
 
+#ifdef USE_AUDIO_RESAMPLER
+    audio_resample_init(&resampler);
+    resample_sent = resample_frac = 0;
+#endif
     sound_default_evtime();
 
     return 1;
@@ -153,8 +203,19 @@ void flush_audio(void)
 {
 
     // Flush audio buffer in order to render all audio samples for a given frame. It's better for some frontend
+#ifdef USE_AUDIO_TIMELINE
+    audio_timeline_render();
+#endif
 
+#ifdef USE_AUDIO_RESAMPLER
+    {
+        int target = resample_frame_target() - resample_sent;
+        resample_send(sndbuffer[wrcnt%SOUND_BUFFERS_COUNT], (sndbufpt - render_sndbuff)/2, target);
+        resample_sent = 0;
+    }
+#else
     retro_audiocb((short int*) sndbuffer[wrcnt%SOUND_BUFFERS_COUNT], (sndbufpt - render_sndbuff)/2);
+#endif
 
     sndbufpt = sndbuffer[0];
     render_sndbuff = sndbuffer[0];
@@ -16,6 +16,9 @@
 #include "zfile.h"
 
 #include "savedisk.h"
+#ifdef USE_SAVEDISK_ASYNC
+#include "thread.h"
+#endif
 
 #ifndef NO_ZLIB
 #include <zlib.h>
@@ -56,7 +59,7 @@ static void prepare_save(void)
 	paquete_size-=4;
 }
 
-static void rebuild_paquete(char *name, unsigned size, unsigned char* data, FILE *f)
+static void rebuild_paquete(const char *name, unsigned size, unsigned char* data, FILE *f)
 {
 	unsigned short *crc=(unsigned short*) &paquete[0x46];
 	unsigned *data_len=(unsigned *) &paquete[0x48];
@@ -146,13 +149,35 @@ static unsigned uae4all_disk_pos[4]={ 0 ,0 ,0 ,0 };
 static unsigned char uae4all_disk_used[4]= { 0 ,0 ,0 ,0 };
 static int uae4all_disk_writed[4]= { 0, 0, 0, 0 };
 static int uae4all_disk_writed_now[4]= { 0, 0, 0, 0 };
+#ifdef USE_SAVEDISK_ASYNC
+static int uae4all_disk_quiet[4]= { 0, 0, 0, 0 };
+/* The image name each slot was opened with: DISK_check_change() puts the
+   next disk in prefs_df before the old one is closed */
+static char uae4all_disk_name[4][128];
+#endif
 static void *uae4all_disk_orig[4]={ NULL, NULL, NULL, NULL };
 static unsigned uae4all_disk_crc[4]={ 0, 0, 0, 0 };
 static unsigned uae4all_disk_actual_crc[4]={ 0, 0, 0, 0};
+#ifdef USE_SAVEDISK_DIRTY
+/* Slots written since the image was loaded (and the ones the .ads patch
+   replaced): only these can differ from uae4all_disk_orig. The saved
+   crc is then the checksum of the last patch instead of the image. */
+static unsigned uae4all_disk_dirty[4][SAVEDISK_DIRTY_WORDS(MAX_DISK_LEN)];
+#endif
+#if defined(USE_SAVEDISK_ASYNC) && !defined(NO_ZLIB)
+static void savedisk_job_stop(void);
+static void uae4all_flush_disk_now(int n);
+#endif
 
 void zfile_exit (void)
 {
 	int i;
+#if defined(USE_SAVEDISK_ASYNC) && !defined(NO_ZLIB)
+	for(i=0;i<NUM_DRIVES;i++)
+		if ((uae4all_disk_memory[i])&&(uae4all_disk_used[i]))
+			uae4all_flush_disk_now(i);
+	savedisk_job_stop();
+#endif
 	for(i=0;i<NUM_DRIVES;i++)
 		if (uae4all_disk_memory[i])
 		{
@@ -170,6 +195,9 @@ int zfile_close (FILE *f)
 	for(i=0;i<NUM_DRIVES;i++)
 		if (f==uae4all_disk_memory[i])
 		{
+#if defined(USE_SAVEDISK_ASYNC) && !defined(NO_ZLIB)
+			uae4all_flush_disk_now(i);
+#endif
 			uae4all_disk_used[i]=0;
 			break;
 		}
@@ -232,11 +260,181 @@ static char *get_namefile(unsigned num)
 	return (char *)&__uae4all_write_namefile[0];
 }
 
-static void uae4all_disk_real_write(int num)
+#ifndef NO_ZLIB
+/* Replaces the .ads file of a disk with a compressed patch */
+static void uae4all_disk_write_ads(const char *diskname, char *namefile, void *bc, unsigned long sizecompressed)
+{
+	unsigned usado=0;
+	{
+		FILE *f=fopen(namefile,"rb");
+		if (f)
+		{
+			fseek(f,0,SEEK_END);
+			usado=ftell(f);
+			fclose(f);
+			usado/=512;
+		}
+	}
+	if ( ((getFreeBlocks()+usado)*512) >=(sizecompressed+VMUFILE_PAD))
+	{
+		eliminate_file(namefile);
+		FILE *f=fopen(namefile,"wb");
+		if (f)
+		{
+			rebuild_paquete(diskname, sizecompressed, (unsigned char*) bc, f);
+			fwrite((void *)&sizecompressed,1,4,f);
+			fwrite(bc,1,sizecompressed,f);
+			fclose(f);
+		}
+	}
+}
+#endif
+
+#if defined(USE_SAVEDISK_ASYNC) && !defined(NO_ZLIB)
+/* Write-behind: the patch is snapshotted at vsync, compressed and written
+   by a worker thread, or without threads SAVEDISK_SLICE input bytes per
+   uae4all_flush_disk() call. One job at a time; a drive whose write finds
+   the writer busy stays pending and is retried on the next check.
+   savedisk_job_stop() ends the worker and finishes the job in hand, for
+   uae4all_flush_disk_now() at disk close and at exit. */
+#define SAVEDISK_SLICE (16*1024)
+
+static struct {
+	savedisk_packer pack;
+	char namefile[32];
+	char diskname[128];
+	volatile int state;		/* 0 idle, 1 packing, 2 written */
+} savedisk_job;
+
+/* Set while uae4all_flush_disk_now() writes: the job is done in place */
+static int savedisk_job_inplace=0;
+
+static void savedisk_job_write(void)
+{
+	uae4all_disk_write_ads(savedisk_job.diskname,savedisk_job.namefile,savedisk_job.pack.out,savedisk_job.pack.out_size);
+}
+
+static int savedisk_job_finish(void)
+{
+	int ret;
+	while(!(ret=savedisk_pack_step(&savedisk_job.pack,SAVEDISK_SLICE)));
+	return ret;
+}
+
+#ifndef NO_THREADS
+static uae_sem_t savedisk_job_sem;
+static uae_thread_id savedisk_job_tid;
+static int savedisk_job_thread_started=0;
+static volatile int savedisk_job_quit=0;
+
+static void *savedisk_job_thread(void *arg)
+{
+	for(;;)
+	{
+		uae_sem_wait(&savedisk_job_sem);
+		if (savedisk_job_quit)
+			break;
+		if (savedisk_job_finish()>0)
+			savedisk_job_write();
+		savedisk_job.state=2;
+	}
+	return NULL;
+}
+#endif
+
+/* Called from the emulation thread at every disk check */
+static void savedisk_job_poll(void)
+{
+	switch(savedisk_job.state)
+	{
+		case 1:
+#ifdef NO_THREADS
+			{
+				int ret=savedisk_pack_step(&savedisk_job.pack,SAVEDISK_SLICE);
+				if (!ret)
+					break;
+				if (ret>0)
+					savedisk_job_write();
+			}
+#else
+			break;
+#endif
+		case 2:
+			savedisk_pack_free(&savedisk_job.pack);
+			savedisk_job.state=0;
+			break;
+	}
+}
+
+static int savedisk_job_start(int num, void *patch, unsigned size)
+{
+	if (savedisk_job.state)
+		return 0;
+	if (!savedisk_pack_start(&savedisk_job.pack,patch,size,MAX_COMP_SIZE))
+		return 1;	/* out of memory: drop this save like a failed compress2 */
+	strcpy(savedisk_job.namefile,get_namefile(num));
+	strcpy(savedisk_job.diskname,uae4all_disk_name[num]);
+	savedisk_job.state=1;
+#ifndef NO_THREADS
+	if ((!savedisk_job_thread_started)&&(!savedisk_job_inplace))
+	{
+		uae_sem_init(&savedisk_job_sem,0,0);
+		savedisk_job_thread_started=!uae_start_thread(savedisk_job_thread,NULL,&savedisk_job_tid);
+	}
+	if ((savedisk_job_thread_started)&&(!savedisk_job_inplace))
+		uae_sem_post(&savedisk_job_sem);
+	else
+#else
+	if (savedisk_job_inplace)
+#endif
+	{
+		if (savedisk_job_finish()>0)
+			savedisk_job_write();
+		savedisk_job.state=2;
+	}
+	return 1;
+}
+
+/* Ends the worker, then finishes and frees the job in hand on this
+   thread. The worker only looks at the quit flag between jobs, so a job
+   it has taken is written by it and one it has not is written here. The
+   next job starts the worker again. */
+static void savedisk_job_stop(void)
+{
+#ifndef NO_THREADS
+	if (savedisk_job_thread_started)
+	{
+		savedisk_job_quit=1;
+		uae_sem_post(&savedisk_job_sem);
+		uae_wait_thread(savedisk_job_tid);
+		uae_sem_destroy(&savedisk_job_sem);
+		savedisk_job_thread_started=0;
+		savedisk_job_quit=0;
+	}
+#endif
+	if (savedisk_job.state==1)
+	{
+		if (savedisk_job_finish()>0)
+			savedisk_job_write();
+		savedisk_job.state=2;
+	}
+	savedisk_job_poll();
+}
+#endif
+
+/* Returns 0 if the write has to be retried later */
+static int uae4all_disk_real_write(int num)
 {
 #ifdef NO_ZLIB
 	/* Disk saving disabled without zlib */
 	(void)num;
+#else
+#ifdef USE_SAVEDISK_DIRTY
+	void *buff_patch=uae4all_extra_buffer;
+	unsigned changed=savedisk_get_changes_dirty(uae4all_disk_memory[num],MAX_DISK_LEN,buff_patch,uae4all_disk_orig[num],uae4all_disk_dirty[num]);
+	unsigned new_crc=savedisk_get_checksum(buff_patch,changed);
+	if (new_crc!=uae4all_disk_actual_crc[num])
+	{
 #else
 	unsigned new_crc=savedisk_get_checksum(uae4all_disk_memory[num],MAX_DISK_LEN);
 	if (new_crc!=uae4all_disk_actual_crc[num])
@@ -245,43 +443,26 @@ static void uae4all_disk_real_write(int num)
 		void *buff_patch=uae4all_extra_buffer;
 		memset(buff_patch,0,MAX_DISK_LEN);
 		unsigned changed=savedisk_get_changes(buff,MAX_DISK_LEN,buff_patch,uae4all_disk_orig[num]);
+#endif
 		if ((changed)&&(changed<MAX_DISK_LEN))
 		{
+#ifdef USE_SAVEDISK_ASYNC
+			if (!savedisk_job_start(num,buff_patch,changed))
+				return 0;
+#else
 			char *namefile=get_namefile(num);
 			void *bc=calloc(1,MAX_COMP_SIZE);
 			unsigned long sizecompressed=MAX_COMP_SIZE;
 			int retc=compress2((Bytef *)bc,&sizecompressed,(const Bytef *)uae4all_extra_buffer,changed,Z_BEST_COMPRESSION);
 			if (retc>=0)
-			{
-				unsigned usado=0;
-				{
-					FILE *f=fopen(namefile,"rb");
-					if (f)
-					{
-						fseek(f,0,SEEK_END);
-						usado=ftell(f);
-						fclose(f);
-						usado/=512;
-					}
-				}
-				if ( ((getFreeBlocks()+usado)*512) >=(sizecompressed+VMUFILE_PAD))
-				{
-					eliminate_file(namefile);
-					FILE *f=fopen(namefile,"wb");
-					if (f)
-					{
-						rebuild_paquete(prefs_df[num], sizecompressed, (unsigned char*) bc, f);
-						fwrite((void *)&sizecompressed,1,4,f);
-						fwrite(bc,1,sizecompressed,f);
-						fclose(f);
-					}
-				}
-			}
+				uae4all_disk_write_ads(prefs_df[num],namefile,bc,sizecompressed);
 			free(bc);
+#endif
 			uae4all_disk_actual_crc[num]=new_crc;
 		}
 	}
 #endif /* NO_ZLIB */
+	return 1;
 }
 
 
@@ -316,6 +497,9 @@ static void uae4all_initsave(unsigned num)
 			if (retc>=0)
 			{
 				savedisk_apply_changes(uae4all_disk_memory[num],uae4all_extra_buffer,sizeuncompressed);
+#ifdef USE_SAVEDISK_DIRTY
+				savedisk_mark_patch(uae4all_disk_dirty[num],uae4all_extra_buffer,sizeuncompressed);
+#endif
 			}
 			else
 			{
@@ -328,7 +512,11 @@ static void uae4all_initsave(unsigned num)
 		if (f)
 			fclose(f);
 	}
+#ifdef USE_SAVEDISK_DIRTY
+	uae4all_disk_actual_crc[num]=savedisk_get_checksum(uae4all_extra_buffer,savedisk_get_changes_dirty(uae4all_disk_memory[num],MAX_DISK_LEN,uae4all_extra_buffer,uae4all_disk_orig[num],uae4all_disk_dirty[num]));
+#else
 	uae4all_disk_actual_crc[num]=savedisk_get_checksum(uae4all_disk_memory[num],MAX_DISK_LEN);
+#endif
 #endif /* NO_ZLIB */
 }
 
@@ -366,6 +554,13 @@ FILE *zfile_open (const char *name, const char *mode)
 	    uae4all_disk_pos[i]=0;
 	    uae4all_disk_writed[i]=0;
 	    uae4all_disk_used[i]=1;
+#ifdef USE_SAVEDISK_DIRTY
+	    memset(uae4all_disk_dirty[i],0,sizeof(uae4all_disk_dirty[i]));
+#endif
+#ifdef USE_SAVEDISK_ASYNC
+	    strncpy(uae4all_disk_name[i],name,127);
+	    uae4all_disk_name[i][127]=0;
+#endif
 	    uae4all_initsave(i);
 	    return (FILE *)uae4all_disk_memory[i];
     }
@@ -399,6 +594,9 @@ size_t uae4all_fwrite( void *ptr, size_t tam, size_t nmiemb, FILE *flujo)
 	if (uae4all_disk_pos[i]>=uae4all_disk_len[i])
 		return 0;
 	memcpy((void *)(((unsigned)uae4all_disk_memory[i])+((unsigned)uae4all_disk_pos[i])),ptr,tam*nmiemb);
+#ifdef USE_SAVEDISK_DIRTY
+	savedisk_mark_dirty(uae4all_disk_dirty[i],uae4all_disk_pos[i],tam*nmiemb);
+#endif
 	uae4all_disk_pos[i]+=tam*nmiemb;
 	uae4all_disk_writed[i]=1;
 	return nmiemb;
@@ -522,6 +720,57 @@ size_t uae4all_rom_fread(void *ptr, size_t tam, size_t nmiemb, FILE *flujo)
 	return (uae4all_rom_pos-rpos)/tam;
 }
 
+#ifdef USE_SAVEDISK_ASYNC
+/* Checks (every 5 vsyncs) without writes before a burst is saved, and
+   the most a busy burst can wait */
+#define SAVEDISK_QUIET 10
+#define SAVEDISK_MAX_WAIT 100
+
+#ifndef NO_ZLIB
+/* Writes a save still pending for drive n and waits for it, before its
+   disk is closed or the core exits */
+static void uae4all_flush_disk_now(int n)
+{
+	savedisk_job_stop();
+	if (((uae4all_disk_writed[n])||(uae4all_disk_writed_now[n]))&&(mainMenu_autosave)&&(maple_first_vmu()))
+	{
+		savedisk_job_inplace=1;
+		uae4all_disk_real_write(n);
+		savedisk_job_inplace=0;
+		savedisk_job_stop();
+	}
+	uae4all_disk_writed[n]=0;
+	uae4all_disk_writed_now[n]=0;
+	uae4all_disk_quiet[n]=0;
+}
+#endif
+
+void uae4all_flush_disk(int n)
+{
+#ifndef NO_ZLIB
+	savedisk_job_poll();
+#endif
+	if (uae4all_disk_writed[n])
+	{
+		uae4all_disk_writed[n]=0;
+		uae4all_disk_quiet[n]=0;
+		if (!uae4all_disk_writed_now[n])
+			uae4all_disk_writed_now[n]=1;
+	}
+	else if (uae4all_disk_writed_now[n])
+		uae4all_disk_quiet[n]++;
+	if ((uae4all_disk_writed_now[n])&&(mainMenu_autosave)&&(maple_first_vmu()))
+	{
+		if ((uae4all_disk_quiet[n]>=SAVEDISK_QUIET)||(uae4all_disk_writed_now[n]>=SAVEDISK_MAX_WAIT))
+		{
+			if (uae4all_disk_real_write(n))
+				uae4all_disk_writed_now[n]=0;
+		}
+		else
+			uae4all_disk_writed_now[n]++;
+	}
+}
+#else
 void uae4all_flush_disk(int n)
 {
 	if ((uae4all_disk_writed[n])&&(mainMenu_autosave))
@@ -539,4 +788,4 @@ void uae4all_flush_disk(int n)
 		}
 	}
 }
-
+#endif